@@ -7,6 +7,7 @@ from . import joint_constraints
 from holoocean.spaces import ContinuousActionSpace, DiscreteActionSpace
 from holoocean.sensors import SensorDefinition, SensorFactory, RGBCamera
 from holoocean.command import AddSensorCommand, RemoveSensorCommand
+from holoocean.exceptions import HoloOceanException
 
 
 class ControlSchemes:
@@ -73,6 +74,9 @@ class ControlSchemes:
     SV_CONTROL = 1
     SV_FORCES = 2
 
+MAX_ACTION_SCHEDULE_TICKS = 256
+
+
 class HoloOceanAgent:
     """A learning agent in HoloOcean
 
@@ -108,6 +112,14 @@ class HoloOceanAgent:
 
         self._action_buffer = \
             self._client.malloc(name, [self._max_control_scheme_length], np.float32)
+        # One row per tick, the engine holds the last row once the schedule runs out
+        self._action_schedule_buffer = \
+            self._client.malloc(name + "_action_schedule",
+                                [MAX_ACTION_SCHEDULE_TICKS, self._max_control_scheme_length],
+                                np.float32)
+        # Number of rows in the schedule and the next row the engine will use
+        self._action_schedule_info_buffer = \
+            self._client.malloc(name + "_action_schedule_info", [2], np.uint32)
         # Teleport flag: 0: do nothing, 1: teleport, 2: rotate, 3: teleport and rotate
         self._teleport_type_buffer = self._client.malloc(name + "_teleport_flag", [1], np.uint8)
         self._teleport_buffer = self._client.malloc(name + "_teleport_command", [12], np.float32)
@@ -123,11 +135,37 @@ class HoloOceanAgent:
         Args:
             action(:obj:`np.ndarray`): The action to take.
         """
+        self._action_schedule_info_buffer[0] = 0
         self.__act__(action)
 
+    def act_schedule(self, actions):
+        """Sets a different command for each of the next ticks. The engine uses one action
+        per tick, so a whole schedule can be run with a single
+        :meth:`~holoocean.environments.HoloOceanEnvironment.tick` with ``num_ticks`` > 1.
+        Once the schedule runs out the last action is held. Calling :meth:`act` discards
+        whatever is left of the schedule.
+
+        Args:
+            actions (:obj:`list` of :obj:`np.ndarray`): The action to take on each tick, in
+                order. At most ``MAX_ACTION_SCHEDULE_TICKS`` actions may be given.
+        """
+        if len(actions) == 0:
+            raise HoloOceanException("Action schedule must contain at least one action")
+        if len(actions) > MAX_ACTION_SCHEDULE_TICKS:
+            raise HoloOceanException("Action schedule can have at most {} actions, got {}"
+                                     .format(MAX_ACTION_SCHEDULE_TICKS, len(actions)))
+
+        # Run each row through __act__ so agent specific conversions still apply
+        for i, action in enumerate(actions):
+            self.__act__(action)
+            np.copyto(self._action_schedule_buffer[i], self._action_buffer)
+        self._action_schedule_info_buffer[1] = 0
+        self._action_schedule_info_buffer[0] = len(actions)
+
     def clear_action(self):
         """Sets the action to zeros, effectively removing any previous actions.
         """
+        self._action_schedule_info_buffer[0] = 0
         np.copyto(self._action_buffer, np.zeros(self._action_buffer.shape))
 
     def set_control_scheme(self, index):
@@ -354,6 +354,91 @@ class RotateSensorCommand(Command):
         self.add_number_parameters(rotation)
 
 
+class SaveSnapshotCommand(Command):
+    """Capture the state of every agent, sensor and prop in the level, so it can be put back
+    with :class:`RestoreSnapshotCommand` instead of reloading the level.
+
+    """
+    def __init__(self):
+        Command.__init__(self)
+        self.set_command_type("SaveSnapshot")
+
+
+class RestoreSnapshotCommand(Command):
+    """Put the level back into the state captured by the last :class:`SaveSnapshotCommand`.
+    Props spawned since then are destroyed.
+
+    """
+    def __init__(self):
+        Command.__init__(self)
+        self.set_command_type("RestoreSnapshot")
+
+
+class ProfileCommand(Command):
+    """Record the next few ticks with the engine's profiler and write them out as a Chrome trace.
+
+    Args:
+        num_ticks (:obj:`int`): Number of ticks to record.
+        path (:obj:`str`): Where to write the trace. If empty, the engine writes
+            ``HolodeckProfile.json`` to its log directory.
+
+    """
+    def __init__(self, num_ticks, path=""):
+        Command.__init__(self)
+        self.set_command_type("Profile")
+        self.add_number_parameters(num_ticks)
+        self.add_string_parameters(path)
+
+
+class RenderSonarPosesCommand(Command):
+    """Compute a sonar's images at a batch of poses, without moving its agent.
+
+    The poses are read from, and the images written to, the sensor's pose batch buffers.
+
+    Args:
+        agent_name (:obj:`str`): Name of the agent the sonar is on.
+        sensor_name (:obj:`str`): Name of the sonar.
+        num_poses (:obj:`int`): Number of poses in the pose batch buffer.
+        capacity (:obj:`int`): Most poses the pose batch buffers hold, the same for every batch
+            so they're reused.
+
+    """
+    def __init__(self, agent_name, sensor_name, num_poses, capacity):
+        Command.__init__(self)
+        self.set_command_type("RenderSonarPoses")
+        self.add_string_parameters(agent_name)
+        self.add_string_parameters(sensor_name)
+        self.add_number_parameters(num_poses)
+        self.add_number_parameters(capacity)
+
+
+class DeriveOctreesCommand(Command):
+    """Fill in the octree cache for the current octree sizes by merging the leaves of a finer
+    cache of the same map, instead of building it from the world.
+
+    The number of tiles made is written to the derived octrees buffer.
+
+    """
+    def __init__(self):
+        Command.__init__(self)
+        self.set_command_type("DeriveOctrees")
+
+
+class OctreeStatsCommand(Command):
+    """Write out what the octree tiles have done this session: loads by where they came from,
+    unloads, resident tiles and memory, and build times, for each ``octree_min`` in use.
+
+    Args:
+        path (:obj:`str`): Where to write the json. If empty, the engine writes
+            ``OctreeStats.json`` to its log directory.
+
+    """
+    def __init__(self, path=""):
+        Command.__init__(self)
+        self.set_command_type("OctreeStats")
+        self.add_string_parameters(path)
+
+
 class RenderViewportCommand(Command):
     """Enable or disable the viewport. Note that this does not prevent the viewport from being shown,
     it just prevents it from being updated. 
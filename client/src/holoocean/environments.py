@@ -6,24 +6,123 @@ It specifies an environment, which contains a number of agents, and the interfac
 with the agents.
 """
 import atexit
+import copy
+import json
 import os
 import random
 import subprocess
 import sys
+import tempfile
+import time
+import warnings
 
 import numpy as np
+from numpy.lib.recfunctions import repack_fields
 
 from holoocean.command import CommandCenter, SpawnAgentCommand, \
     TeleportCameraCommand, RenderViewportCommand, RenderQualityCommand, \
-    CustomCommand, DebugDrawCommand
+    CustomCommand, DebugDrawCommand, SaveSnapshotCommand, RestoreSnapshotCommand, ProfileCommand, \
+    RenderSonarPosesCommand, DeriveOctreesCommand, OctreeStatsCommand
 
-from holoocean.exceptions import HoloOceanException
+from holoocean.exceptions import HoloOceanException, HoloOceanConfigurationException
 from holoocean.holooceanclient import HoloOceanClient
 from holoocean.agents import AgentDefinition, SensorDefinition, AgentFactory
 from holoocean.weather import WeatherController
+from holoocean import octrees
 
 from holoocean.sensors import AcousticBeaconSensor
 from holoocean.sensors import OpticalModemSensor
+from holoocean.sensors import SonarSensor
+MAX_TELEMETRY_SENSORS = 128
+
+TELEMETRY_SENSOR_DTYPE = np.dtype([
+    ("agent", "S32"),
+    ("sensor", "S32"),
+    ("ms", np.float32),
+    ("reserved", np.uint32)
+])
+
+# Must match the layout of FTelemetryHeader/FSensorTelemetry in the engine
+TELEMETRY_DTYPE = np.dtype([
+    ("tick", np.uint32),
+    ("num_sensors", np.uint32),
+    ("tick_ms", np.float32),
+    ("acquire_ms", np.float32),
+    ("commands_ms", np.float32),
+    ("control_ms", np.float32),
+    ("physics_ms", np.float32),
+    ("reserved", np.float32),
+    ("sensors", TELEMETRY_SENSOR_DTYPE, (MAX_TELEMETRY_SENSORS,))
+])
+
+MAX_SCHEDULED_SENSORS = 64
+
+SENSOR_SCHEDULE_ENTRY_DTYPE = np.dtype([
+    ("agent", "S32"),
+    ("sensor", "S32"),
+    ("period", np.uint32),
+    ("phase", np.uint32),
+    ("cost", np.float32),
+    ("pinned", np.uint32)
+])
+
+# Must match the layout of FSensorScheduleHeader/FSensorScheduleEntry in the engine
+SENSOR_SCHEDULE_DTYPE = np.dtype([
+    ("num_sensors", np.uint32),
+    ("hyperperiod", np.uint32),
+    ("peak_cost", np.float32),
+    ("unstaggered_peak_cost", np.float32),
+    ("tick_offset", np.uint32),
+    ("sensors", SENSOR_SCHEDULE_ENTRY_DTYPE, (MAX_SCHEDULED_SENSORS,))
+])
+
+
+class _TrackedState(dict):
+    """Sensor state for one agent that remembers which sensors were looked up in it, so
+    the engine can skip lazy sensors nobody reads. See ``lazy_sensors``.
+    """
+
+    def __init__(self, sensors):
+        super().__init__()
+        self._sensors = sensors
+
+    def _touch(self, key):
+        sensor = self._sensors.get(key)
+        if sensor is not None:
+            sensor.accessed = True
+
+    def _touch_all(self):
+        for sensor in self._sensors.values():
+            sensor.accessed = True
+
+    def __getitem__(self, key):
+        self._touch(key)
+        return super().__getitem__(key)
+
+    def __contains__(self, key):
+        self._touch(key)
+        return super().__contains__(key)
+
+    def get(self, key, default=None):
+        self._touch(key)
+        return super().get(key, default)
+
+    def __iter__(self):
+        self._touch_all()
+        return super().__iter__()
+
+    def keys(self):
+        self._touch_all()
+        return super().keys()
+
+    def items(self):
+        self._touch_all()
+        return super().items()
+
+    def values(self):
+        self._touch_all()
+        return super().values()
+
 
 class HoloOceanEnvironment:
     """Proxy for communicating with a HoloOcean world
@@ -115,6 +214,31 @@ class HoloOceanEnvironment:
         if scenario is not None and "lcm_provider" not in scenario:
             scenario['lcm_provider'] = ""
 
+        # Only compute the expensive sensors the client reads
+        self._lazy_sensors = scenario is not None and scenario.get("lazy_sensors", False)
+        if self._lazy_sensors and not copy_state:
+            warnings.warn("lazy_sensors needs copy_state to see which sensors are read, ignoring it")
+            self._lazy_sensors = False
+
+        # Skip rendering entirely, only physics and non-visual sensors run
+        self._sensors_only = scenario is not None and scenario.get("sensors_only", False)
+        if self._sensors_only:
+            self._check_sensors_only()
+
+        # Share loaded octree tiles with other instances on this machine
+        self._octree_shared_cache = scenario is not None and scenario.get("octree_shared_cache", False)
+
+        # Save and load octree tiles as DAGs, with repeated parts stored once
+        self._octree_dag = scenario is not None and scenario.get("octree_dag", False)
+
+        # Compress octree tiles when they're saved
+        self._octree_compress = scenario is not None and scenario.get("octree_compress", False)
+
+        # Restore a snapshot on reset instead of reloading the level
+        self._fast_reset = scenario is not None and scenario.get("fast_reset", False)
+        self._snapshot_scenario = None
+        self._snapshot_agents = None
+
         self._uuid = uuid
         self._pre_start_steps = pre_start_steps
         self._copy_state = copy_state
@@ -169,6 +293,10 @@ class HoloOceanEnvironment:
         self._client.command_center = self._command_center
         self._reset_ptr = self._client.malloc("RESET", [1], np.bool_)
         self._reset_ptr[0] = False
+        self._tick_schedule_ptr = self._client.malloc("tick_schedule", [1], np.uint32)
+        self._tick_schedule_ptr[0] = 0
+        self._telemetry_ptr = self._client.malloc("telemetry", [TELEMETRY_DTYPE.itemsize], np.uint8)
+        self._sensor_schedule_ptr = self._client.malloc("sensor_schedule", [SENSOR_SCHEDULE_DTYPE.itemsize], np.uint8)
 
         # Initialize environment controller
         self.weather = WeatherController(self.send_world_command)
@@ -371,12 +499,19 @@ class HoloOceanEnvironment:
         If it is a single agent environment, it returns that state for that agent. Otherwise, it
         returns a dict from agent name to state.
 
+        If ``fast_reset`` is set in the scenario, resets after the first restore a snapshot
+        instead of reloading the level, see :ref:`configure-fast-reset`.
+
         Returns:
          :obj:`tuple` or :obj:`dict`:
             Returns the same as `tick`.
         """
+        if self._can_restore_snapshot():
+            return self._restore_snapshot()
+
         # Reset level
         self._initial_reset = True
+        self._snapshot_scenario = None
         self._reset_ptr[0] = True
         for agent in self.agents.values():
             agent.clear_action()
@@ -411,11 +546,42 @@ class HoloOceanEnvironment:
         else:
             self._default_state_fn = self._get_full_state
 
-        for _ in range(self._pre_start_steps + 1):
+        for i in range(self._pre_start_steps + 1):
+            # Save the snapshot on the last tick, so a restore lines up with a full reset
+            if self._fast_reset and i == self._pre_start_steps:
+                self._enqueue_command(SaveSnapshotCommand())
             self.tick(publish=False)
 
+        if self._fast_reset:
+            self._snapshot_scenario = copy.deepcopy(self._scenario)
+            self._snapshot_agents = set(self.agents)
+
         return self._default_state_fn()
 
+    def _can_restore_snapshot(self):
+        # Anything that changed since the snapshot needs the level reloaded
+        return self._fast_reset and \
+            self._snapshot_scenario is not None and \
+            self._snapshot_scenario == self._scenario and \
+            self._snapshot_agents == set(self.agents)
+
+    def _restore_snapshot(self):
+        """Resets the environment by restoring the snapshot saved during the last full reset,
+        without reloading the level. Returns the same as :meth:`reset`.
+        """
+        for agent in self.agents.values():
+            agent.clear_action()
+            for sensor in agent.sensors.values():
+                sensor.tick_count = sensor.tick_every
+
+        if self._command_center.queue_size > 0:
+            print("Warning: Reset called before all commands could be sent. Discarding",
+                  self._command_center.queue_size, "commands.")
+        self._command_center.clear()
+
+        self._enqueue_command(RestoreSnapshotCommand())
+        return self.tick(publish=False)
+
     def step(self, action, ticks=1, publish=True):
         """Supplies an action to the main agent and tells the environment to tick once.
         Primary mode of interaction for single agent environments.
@@ -423,7 +589,8 @@ class HoloOceanEnvironment:
         Args:
             action (:obj:`np.ndarray`): An action for the main agent to carry out on the next tick.
             ticks (:obj:`int`): Number of times to step the environment with this action.
-                If ticks > 1, this function returns the last state generated.
+                If ticks > 1, this function returns the last state generated. Unless publishing
+                over LCM, all ticks are run by the engine before control returns to the client.
             publish (:obj:`bool`): Whether or not to publish as defined by scenario. Defaults to True.
 
         Returns:
@@ -438,23 +605,10 @@ class HoloOceanEnvironment:
         if not self._initial_reset:
             raise HoloOceanException("You must call .reset() before .step()")
 
-        for _ in range(ticks):
-            if self._agent is not None:
-                self._agent.act(action)
-
-            self._command_center.handle_buffer()
-            self._client.release()
-            self._client.acquire(self._timeout)
-
-            last_state = self._default_state_fn()
-
-            self._tick_sensor()
-            self._num_ticks += 1
-
-            if publish and self._lcm is not None:
-                self._publish(last_state)
+        if self._agent is not None:
+            self._agent.act(action)
 
-        return last_state
+        return self._run_ticks(ticks, publish)
 
     def act(self, agent_name, action):
         """Supplies an action to a particular agent, but doesn't tick the environment.
@@ -469,6 +623,203 @@ class HoloOceanEnvironment:
         """
         self.agents[agent_name].act(action)
 
+    def act_schedule(self, agent_name, actions):
+        """Supplies a different action for each of the next ticks to a particular agent,
+        but doesn't tick the environment. One action is used per tick, so the whole schedule
+        can be run with a single call to `tick` with ``num_ticks`` > 1. After the schedule
+        runs out the last action is held.
+
+        Args:
+            agent_name (:obj:`str`): The name of the agent to supply actions for.
+            actions (:obj:`list` of :obj:`np.ndarray`): The action to apply on each tick.
+        """
+        self.agents[agent_name].act_schedule(actions)
+
+    def get_telemetry(self):
+        """Gets how long the engine spent on each part of the last tick, in milliseconds.
+
+        ``tick_ms`` is the whole tick, not counting ``acquire_ms``, the time the engine spent
+        waiting on the client before it. ``commands_ms``, ``control_ms`` and ``physics_ms``
+        are the time spent running commands, control schemes and physics.
+
+        Returns:
+            (:obj:`np.ndarray`, :obj:`np.ndarray`): A structured array with the ``tick`` number
+            and the timings above, and a structured array with the ``agent``, ``sensor`` and
+            ``ms`` of every sensor that ticked.
+        """
+        telemetry = self._telemetry_ptr.view(TELEMETRY_DTYPE)[0].copy()
+        num_sensors = min(int(telemetry["num_sensors"]), MAX_TELEMETRY_SENSORS)
+        sensors = repack_fields(telemetry["sensors"][:num_sensors][["agent", "sensor", "ms"]])
+
+        fields = [name for name in TELEMETRY_DTYPE.names if name not in ("sensors", "reserved", "num_sensors")]
+        return repack_fields(telemetry[fields]), sensors
+
+    def get_sensor_schedule(self):
+        """Gets the schedule the engine picked for sensors that don't capture every tick.
+
+        Sensors with the same capture period are given different phases, so that expensive
+        ones like sonars don't all capture on the same tick. A sensor captures on ticks where
+        ``tick % period == phase``.
+
+        Returns:
+            (:obj:`np.ndarray`, :obj:`dict`): A structured array with the ``agent``, ``sensor``,
+            ``period``, ``phase``, estimated ``cost`` in milliseconds and whether the phase was
+            ``pinned`` by the configuration, for each scheduled sensor. And a dictionary with the
+            ``hyperperiod`` the schedule repeats over, and the estimated ``peak_cost`` of the
+            busiest tick along with the ``unstaggered_peak_cost`` it would have without phases.
+        """
+        schedule = self._sensor_schedule_ptr.view(SENSOR_SCHEDULE_DTYPE)[0].copy()
+        num_sensors = min(int(schedule["num_sensors"]), MAX_SCHEDULED_SENSORS)
+        sensors = repack_fields(schedule["sensors"][:num_sensors])
+
+        summary = {
+            "hyperperiod": int(schedule["hyperperiod"]),
+            "peak_cost": float(schedule["peak_cost"]),
+            "unstaggered_peak_cost": float(schedule["unstaggered_peak_cost"])
+        }
+        return sensors, summary
+
+    def profile(self, num_ticks, path=None):
+        """Records the next ``num_ticks`` ticks with the engine's profiler.
+
+        The trace is written once the ticks have run, and can be opened in ``chrome://tracing``
+        or https://ui.perfetto.dev. A summary of each zone is also written to the engine's log.
+
+        Args:
+            num_ticks (:obj:`int`): Number of ticks to record.
+            path (:obj:`str`, optional): Where to write the trace. Defaults to
+                ``HolodeckProfile.json`` in the engine's log directory.
+        """
+        path = os.path.abspath(path) if path is not None else ""
+        self._enqueue_command(ProfileCommand(num_ticks, path))
+
+    def render_sonar_poses(self, agent_name, sensor_name, poses, batch_size=256):
+        """Computes a sonar's images at each of the given poses, without moving its agent.
+
+        The engine renders each batch of poses during one tick, computing as many of them at once
+        as it has worker threads, so this is much faster than teleporting an agent along a
+        trajectory. The world still advances a tick for every batch. Uses the sonar's
+        configuration as is, with each pose's noise drawn on its own; the sonar's own data and
+        the agent aren't changed.
+
+        Args:
+            agent_name (:obj:`str`): Name of the agent the sonar is on.
+            sensor_name (:obj:`str`): Name of the sonar.
+            poses (:obj:`np.ndarray` or :obj:`str`): An (n, 6) array of sensor poses in the world
+                frame, each ``[x, y, z, roll, pitch, yaw]`` in meters and degrees. Or the path to a
+                comma separated trajectory file with one such pose per line.
+            batch_size (:obj:`int`, optional): Most poses rendered in one tick. The shared memory
+                used is sized for this many and reused for every batch. Defaults to 256.
+
+        Returns:
+            :obj:`np.ndarray`: The images, one per pose, each shaped like the sonar's data.
+        """
+        if isinstance(poses, str):
+            poses = np.loadtxt(poses, delimiter=",", ndmin=2)
+        poses = np.asarray(poses, dtype=np.float32).reshape(-1, 6)
+
+        sensor = self.agents[agent_name].sensors[sensor_name]
+        buffer_name = agent_name + "_" + sensor_name
+
+        images = np.zeros([len(poses)] + list(sensor.data_shape), np.float32)
+        if len(poses) == 0:
+            return images
+
+        # Every batch uses the same buffers, the last one just fills part of them
+        batch_size = min(batch_size, len(poses))
+        pose_ptr = self._client.malloc(buffer_name + "_pose_batch", [batch_size, 6], np.float32)
+        image_ptr = self._client.malloc(buffer_name + "_pose_batch_images",
+                                        [batch_size] + list(sensor.data_shape), np.float32)
+        count_ptr = self._client.malloc(buffer_name + "_pose_batch_count", [1], np.uint32)
+
+        for start in range(0, len(poses), batch_size):
+            batch = poses[start:start + batch_size]
+            pose_ptr[:len(batch)] = batch
+            count_ptr[0] = 0
+
+            self._enqueue_command(RenderSonarPosesCommand(agent_name, sensor_name, len(batch), batch_size))
+            self.tick(publish=False)
+
+            if count_ptr[0] != len(batch):
+                raise HoloOceanException("Sonar {} couldn't render poses, either it isn't a sonar or "
+                                         "its octree isn't loaded yet".format(sensor_name))
+            images[start:start + len(batch)] = image_ptr[:len(batch)]
+
+        return images
+
+    def derive_octrees(self):
+        """Fills in the octree cache for this scenario's ``octree_min`` and ``octree_max`` from a
+        finer cache of the same map, by merging its leaves instead of building it from the world.
+
+        The finer cache's ``octree_min`` has to be this one's halved one or more times, and its
+        ``octree_max`` has to give the same root size. Tiles that are already saved, or that the
+        finer cache hasn't built, are left alone. Sonars do the same for any tile they load that
+        isn't saved yet, so this is only needed to fill in the whole cache up front.
+
+        Returns:
+            :obj:`int`: How many tiles were made.
+        """
+        derived_ptr = self._client.malloc("derived_octrees", [1], np.uint32)
+        self._enqueue_command(DeriveOctreesCommand())
+        self.tick(publish=False)
+        return int(derived_ptr[0])
+
+    def octree_stats(self, path=None):
+        """Reports on the octree tiles sonars use, for each ``octree_min`` that's been asked for.
+
+        The engine's counters for this session are combined with what
+        :func:`holoocean.octrees.resolution_stats` finds in each resolution's cache folder.
+
+        Args:
+            path (:obj:`str`, optional): Where the engine writes its counters. Defaults to a
+                file in the temp directory.
+
+        Returns:
+            :obj:`dict`: The ``map``, session ``uptime_s``, tile ``loads`` and ``unloads`` and their
+            rates per second over the session (``load_rate``, ``unload_rate``) and since the last
+            call (``recent_load_rate``, ``recent_unload_rate``), and ``resolutions``. Each
+            resolution has its ``min``, ``max``, ``root`` and ``dir``, ``loads`` by where they came
+            from, ``unloads``, ``resident_tiles``, ``resident_bytes`` and ``peak_resident_bytes``,
+            ``builds``, ``build_s`` and ``nan_normals`` this session, and its ``cache``.
+        """
+        if path is None:
+            path = os.path.join(tempfile.gettempdir(), "holoocean_octree_stats_{}.json".format(self._uuid))
+        path = os.path.abspath(path)
+        self._enqueue_command(OctreeStatsCommand(path))
+        self.tick(publish=False)
+
+        with open(path) as f:
+            stats = json.load(f)
+        for res in stats["resolutions"]:
+            res["cache"] = octrees.resolution_stats(res["dir"]) if os.path.isdir(res["dir"]) else None
+        return stats
+
+    def wait_for_octrees(self, timeout=None):
+        """Ticks the environment until every sonar has finished building the octree near it
+        and is making images. Sonars build it in the background when they start up, see
+        :class:`~holoocean.sensors.SonarSensor`.
+
+        Args:
+            timeout (:obj:`float`, optional): Seconds to wait before giving up. Waits as long as
+                it takes by default.
+
+        Returns:
+            :obj:`dict`: The state from the last tick.
+        """
+        sonars = [sensor for agent in self.agents.values() for sensor in agent.sensors.values()
+                  if isinstance(sensor, SonarSensor)]
+
+        start = time.time()
+        state = self.tick(publish=False)
+        while not all(sonar.octree_ready for sonar in sonars):
+            if timeout is not None and time.time() - start > timeout:
+                progress = {sonar.name: sonar.octree_progress for sonar in sonars}
+                raise HoloOceanException("Sonar octrees weren't built within {} seconds, "
+                                         "tiles done/total: {}".format(timeout, progress))
+            state = self.tick(publish=False)
+
+        return state
+
     def get_joint_constraints(self, agent_name, joint_name):
         """Returns the corresponding swing1, swing2 and twist limit values for the
                 specified agent and joint. Will return None if the joint does not exist for the agent.
@@ -482,7 +833,9 @@ class HoloOceanEnvironment:
         """Ticks the environment once. Normally used for multi-agent environments.
 
         Args:
-            num_ticks (:obj:`int`): Number of ticks to perform. Defaults to 1.
+            num_ticks (:obj:`int`): Number of ticks to perform. Defaults to 1. Unless publishing
+                over LCM, all ticks are run by the engine before control returns to the client,
+                see :meth:`act_schedule` to change actions between them.
             publish (:obj:`bool`): Whether or not to publish as defined by scenario. Defaults to True.
 
         Returns:
@@ -497,19 +850,41 @@ class HoloOceanEnvironment:
         if not self._initial_reset:
             raise HoloOceanException("You must call .reset() before .tick()")
 
-        for _ in range(num_ticks):
-            self._command_center.handle_buffer()
+        return self._run_ticks(num_ticks, publish)
 
-            self._client.release()
-            self._client.acquire(self._timeout)
+    def _run_ticks(self, num_ticks, publish):
+        """Has the engine run ``num_ticks`` ticks and returns the last state.
+
+        When nothing needs to be published every tick, all ticks are run by the engine in a
+        single round trip, otherwise it falls back to one round trip per tick.
+        """
+        if publish and self._lcm is not None:
+            for _ in range(num_ticks):
+                state = self._round_trip(1)
+                self._publish(state)
+            return state
 
-            state = self._default_state_fn()
+        return self._round_trip(num_ticks)
 
+    def _round_trip(self, num_ticks):
+        self._command_center.handle_buffer()
+        if self._lazy_sensors:
+            self._request_sensors()
+
+        self._tick_schedule_ptr[0] = num_ticks
+        self._client.release()
+        self._client.acquire(self._timeout)
+
+        # Keep sensor rates and sim time the same as if each tick was its own round trip
+        for _ in range(num_ticks - 1):
             self._tick_sensor()
             self._num_ticks += 1
 
-            if publish and self._lcm is not None:
-                self._publish(state)
+        self._align_scheduled_sensors()
+        state = self._default_state_fn()
+
+        self._tick_sensor()
+        self._num_ticks += 1
 
         return state
 
@@ -742,6 +1117,31 @@ class HoloOceanEnvironment:
         command_to_send = CustomCommand(name, num_params, string_params)
         self._enqueue_command(command_to_send)
 
+    def _check_sensors_only(self):
+        """Makes sure no sensor in the scenario needs rendering, which ``sensors_only`` turns off"""
+        for agent in self._scenario.get("agents", []):
+            for sensor in agent.get("sensors", []):
+                if sensor["sensor_type"] in SensorDefinition._rendered_sensors:
+                    raise HoloOceanConfigurationException(
+                        "{} on agent {} needs rendering, which sensors_only turns off. Remove it from "
+                        "the scenario or turn sensors_only off".format(
+                            sensor.get("sensor_name", sensor["sensor_type"]), agent["agent_name"]))
+
+    def _recording_arguments(self):
+        """Engine arguments for seeding noise and recording the run, from the scenario"""
+        arguments = []
+        if self._scenario is None:
+            return arguments
+
+        if "seed" in self._scenario:
+            arguments.append("-HolodeckSeed=" + str(self._scenario["seed"]))
+        if "record_path" in self._scenario:
+            arguments.append("-HolodeckRecord=" + os.path.abspath(self._scenario["record_path"]))
+            if "record_sensors" in self._scenario:
+                arguments.append("-HolodeckRecordSensors=" + ",".join(self._scenario["record_sensors"]))
+
+        return arguments
+
     def __linux_start_process__(self, binary_path, task_key, gl_version, verbose,
                                 show_viewport=True):
         import posix_ipc
@@ -770,9 +1170,20 @@ class HoloOceanEnvironment:
             '-OctreeMax=' + str(self._octree_max)
         ]
         
-        if not show_viewport:
+        if self._octree_shared_cache:
+            arguments.append("-OctreeSharedCache")
+        if self._octree_dag:
+            arguments.append("-OctreeDag")
+        if self._octree_compress:
+            arguments.append("-OctreeCompress")
+
+        if self._sensors_only:
+            arguments += ["-HolodeckSensorsOnly", "-nullrhi"]
+        elif not show_viewport:
             arguments.append("-RenderOffScreen")
 
+        arguments += self._recording_arguments()
+
         self._world_process = subprocess.Popen(
             arguments, stdout=out_stream, stderr=out_stream
         )
@@ -815,9 +1226,20 @@ class HoloOceanEnvironment:
             '-OctreeMax=' + str(self._octree_max)
         ]
 
-        if not show_viewport:
+        if self._octree_shared_cache:
+            arguments.append("-OctreeSharedCache")
+        if self._octree_dag:
+            arguments.append("-OctreeDag")
+        if self._octree_compress:
+            arguments.append("-OctreeCompress")
+
+        if self._sensors_only:
+            arguments += ["-HolodeckSensorsOnly", "-nullrhi"]
+        elif not show_viewport:
             arguments.append("-RenderOffScreen")
 
+        arguments += self._recording_arguments()
+
         self._world_process = subprocess.Popen(
             arguments, stdout=out_stream, stderr=out_stream
         )
@@ -856,11 +1278,46 @@ class HoloOceanEnvironment:
                 else:
                     sensor.tick_count = 1
 
+    def _align_scheduled_sensors(self):
+        """Lines up the ticks heavy sensors report data on with the phases the engine
+        picked for them, see :meth:`get_sensor_schedule`.
+        """
+        schedule = self._sensor_schedule_ptr.view(SENSOR_SCHEDULE_DTYPE)[0]
+        num_sensors = min(int(schedule["num_sensors"]), MAX_SCHEDULED_SENSORS)
+        if num_sensors == 0:
+            return
+
+        # Shifted after a fast reset, so captures fall on the ticks they did in the first episode
+        tick = int(self._telemetry_ptr.view(TELEMETRY_DTYPE)[0]["tick"]) - int(schedule["tick_offset"])
+        for entry in schedule["sensors"][:num_sensors]:
+            agent = self.agents.get(entry["agent"].decode())
+            sensor = agent.sensors.get(entry["sensor"].decode()) if agent is not None else None
+            period = int(entry["period"])
+            if sensor is None or sensor.tick_every != period:
+                continue
+
+            sensor.tick_count = sensor.tick_every if tick % period == int(entry["phase"]) else 0
+
+    def _request_sensors(self):
+        """Has the engine only compute the lazy sensors that were read from the states
+        returned since the last round trip, see :attr:`~holoocean.sensors.HoloOceanSensor.wanted`.
+        """
+        for agent in self.agents.values():
+            for sensor in agent.sensors.values():
+                if sensor.lazy:
+                    sensor.wanted = sensor.accessed
+                    sensor.accessed = False
+
+    def _new_sensor_state(self, agent):
+        if self._lazy_sensors:
+            return _TrackedState(agent.sensors)
+        return dict()
+
     def _get_single_state(self):
         if self._agent is not None:
             # rebuild state dictionary to drop/change data as needed
             if self._copy_state:
-                state = dict()
+                state = self._new_sensor_state(self.agents[self._agent.name])
                 for sensor_name, sensor in self.agents[self._agent.name].sensors.items():
                     data = sensor.sensor_data
                     if isinstance(data, np.ndarray):
@@ -882,7 +1339,7 @@ class HoloOceanEnvironment:
         if self._copy_state:
             state = dict()
             for agent_name, agent in self.agents.items():
-                state[agent_name] = dict()
+                state[agent_name] = self._new_sensor_state(agent)
                 for sensor_name, sensor in agent.sensors.items():
                     data = sensor.sensor_data
                     if isinstance(data, np.ndarray):
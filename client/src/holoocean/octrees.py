@@ -0,0 +1,323 @@
+"""Reads the octree caches sonars save, to see what's in them.
+
+Each map's cache is in ``Octrees/<map>`` in the world's package, with a folder for each
+``octree_min``/``octree_max`` it's been built at. This goes through the tiles, region bitmaps
+and build log in each of them and reports how big they are and what's in them.
+
+It can also be run from the command line::
+
+    python -m holoocean.octrees <folder> [--json]
+
+where the folder is a map's cache, one resolution of it, or the ``Octrees`` folder of a world.
+"""
+import argparse
+import json
+import math
+import os
+import re
+import struct
+import sys
+import zlib
+from collections import Counter
+
+TILE_MAGIC = 0x4C49544F    # "OTIL"
+DAG_MAGIC = 0x4741444F     # "ODAG"
+REGION_MAGIC = 0x4745524F  # "OREG"
+COMPRESSED = 1
+
+_RESOLUTION_DIR = re.compile(r"^min(\d+)_max(\d+)$")
+
+
+class _Reader:
+    """Reads what the engine wrote with an FArchive"""
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def read(self, fmt):
+        values = struct.unpack_from("<" + fmt, self.data, self.pos)
+        self.pos += struct.calcsize("<" + fmt)
+        return values
+
+    def int32(self):
+        return self.read("i")[0]
+
+    def uint32(self):
+        return self.read("I")[0]
+
+    def string(self):
+        # Negative lengths are UTF-16, both include the terminating null
+        length = self.int32()
+        if length >= 0:
+            raw = self.data[self.pos:self.pos + length]
+            self.pos += length
+            return raw.rstrip(b"\0").decode("latin-1")
+        raw = self.data[self.pos:self.pos - 2 * length]
+        self.pos -= 2 * length
+        return raw.decode("utf-16-le").rstrip("\0")
+
+    def array(self, fmt):
+        count = self.int32()
+        return list(self.read(fmt * count)) if count else []
+
+    def strings(self):
+        return [self.string() for _ in range(self.int32())]
+
+    def at_end(self):
+        return self.pos == len(self.data)
+
+
+def _unpack(path, magic):
+    """Checks a file's header and returns what's behind it, uncompressed"""
+    with open(path, "rb") as f:
+        data = f.read()
+    file_magic, _, flags, raw_size = struct.unpack_from("<4I", data)
+    if file_magic != magic:
+        raise ValueError("{} isn't an octree file of the expected kind".format(path))
+    raw = data[16:]
+    if flags & COMPRESSED:
+        raw = zlib.decompress(raw)
+    if len(raw) != raw_size:
+        raise ValueError("{} is partial or corrupt".format(path))
+    return raw
+
+
+def read_tile(path, scale):
+    """Reads a saved tile.
+
+    Args:
+        path (:obj:`str`): The tile's ``.oct`` or ``.dag`` file.
+        scale (:obj:`int`): How many ``octree_min`` across the tile is, its ``octree_max`` over
+            its ``octree_min``.
+
+    Returns:
+        :obj:`dict`: The tile's ``nodes_per_level``, starting with the tile itself, its
+        ``leaves``, its ``materials`` as a count of leaves with each, and its ``bytes_on_disk``
+        and ``raw_bytes``. DAG tiles also have the ``unique_nodes`` and ``unique_leaves`` they're
+        stored as.
+    """
+    depth = int(round(math.log2(scale)))
+    if path.endswith(".dag"):
+        stats = _read_dag(_unpack(path, DAG_MAGIC), depth)
+    else:
+        stats = _read_oct(_unpack(path, TILE_MAGIC), depth)
+    stats["bytes_on_disk"] = os.path.getsize(path)
+    return stats
+
+
+def _read_oct(raw, depth):
+    reader = _Reader(raw)
+    materials = reader.strings()
+    masks = reader.array("B")
+    reader.array("H")
+    material_ids = reader.array("H")
+
+    # Masks are depth first, the nodes above the leaves each have one
+    levels = [0] * (depth + 1)
+    next_mask = 0
+    stack = [0]
+    while stack:
+        level = stack.pop()
+        levels[level] += 1
+        if level == depth:
+            continue
+        mask = masks[next_mask]
+        next_mask += 1
+        stack.extend([level + 1] * bin(mask).count("1"))
+
+    histogram = Counter(materials[m] for m in material_ids)
+    return {"nodes_per_level": levels, "leaves": len(material_ids),
+            "materials": dict(histogram), "raw_bytes": len(raw)}
+
+
+def _read_dag(raw, depth):
+    reader = _Reader(raw)
+    reader.uint32()
+    root = reader.int32()
+    nodes = reader.array("I")
+    materials = reader.strings()
+    num_leaves = reader.int32()
+    leaves = [reader.read("3H") for _ in range(num_leaves)]
+
+    # Shared nodes count once for every place they're used
+    levels = [0] * (depth + 1)
+    unique = 0
+    used = {root: 1} if root >= 0 else {}
+    for level in range(depth):
+        levels[level] = sum(used.values())
+        unique += len(used)
+        below = Counter()
+        for node, count in used.items():
+            mask = nodes[node]
+            for i in range(1, bin(mask).count("1") + 1):
+                below[nodes[node + i]] += count
+        used = below
+    levels[depth] = sum(used.values())
+
+    histogram = Counter()
+    for leaf, count in used.items():
+        histogram[materials[leaves[leaf][2]]] += count
+    return {"nodes_per_level": levels, "leaves": levels[depth], "materials": dict(histogram),
+            "raw_bytes": len(raw), "unique_nodes": unique, "unique_leaves": num_leaves}
+
+
+def read_region(path):
+    """Reads a region's bitmap.
+
+    Args:
+        path (:obj:`str`): The region's ``.reg`` file.
+
+    Returns:
+        :obj:`list` of :obj:`bool`: Whether each of its tiles has something in it.
+    """
+    reader = _Reader(_unpack(path, REGION_MAGIC))
+    num_bits = reader.int32()
+    words = reader.read("I" * ((num_bits + 31) // 32))
+    return [bool(words[i // 32] >> (i % 32) & 1) for i in range(num_bits)]
+
+
+def read_builds(path):
+    """Reads the log of tile builds a resolution's folder keeps.
+
+    Args:
+        path (:obj:`str`): The ``builds.csv`` file.
+
+    Returns:
+        :obj:`list` of :obj:`dict`: The ``tile``, ``ms``, ``leaves`` and ``nan_normals`` of each build.
+    """
+    builds = []
+    with open(path) as f:
+        for line in f:
+            parts = line.strip().split(",")
+            if len(parts) != 4 or parts[0] == "tile":
+                continue
+            builds.append({"tile": parts[0], "ms": float(parts[1]),
+                           "leaves": int(parts[2]), "nan_normals": int(parts[3])})
+    return builds
+
+
+def resolution_stats(path):
+    """Reports on one resolution of a map's cache.
+
+    Args:
+        path (:obj:`str`): The resolution's folder, ``min<octree_min>_max<octree_max>`` with both in cm.
+
+    Returns:
+        :obj:`dict`: Its ``octree_min`` and ``octree_max`` in cm, number of ``tiles``, their
+        ``nodes_per_level``, ``leaves`` in all and ``leaves_per_tile`` (``min``, ``mean``, ``max``),
+        ``bytes_on_disk`` and ``raw_bytes``, ``materials`` as a count of leaves with each, its
+        ``regions`` and how many tiles they mark as having something in them, the ``corrupt``
+        tiles that couldn't be read, and ``builds`` from its build log.
+    """
+    match = _RESOLUTION_DIR.match(os.path.basename(os.path.normpath(path)))
+    if match is None:
+        raise ValueError("{} isn't an octree cache folder".format(path))
+    octree_min, octree_max = int(match.group(1)), int(match.group(2))
+
+    stats = {"path": os.path.abspath(path), "octree_min": octree_min, "octree_max": octree_max,
+             "tiles": 0, "nodes_per_level": [], "leaves": 0, "bytes_on_disk": 0, "raw_bytes": 0,
+             "materials": Counter(), "corrupt": [], "regions": 0, "marked_tiles": 0}
+    leaves = []
+    for name in sorted(os.listdir(path)):
+        if not name.endswith((".oct", ".dag")):
+            continue
+        try:
+            tile = read_tile(os.path.join(path, name), octree_max // octree_min)
+        except (ValueError, struct.error, zlib.error, IndexError):
+            stats["corrupt"].append(name)
+            continue
+        stats["tiles"] += 1
+        levels = stats["nodes_per_level"]
+        levels.extend([0] * (len(tile["nodes_per_level"]) - len(levels)))
+        for i, count in enumerate(tile["nodes_per_level"]):
+            levels[i] += count
+        leaves.append(tile["leaves"])
+        stats["bytes_on_disk"] += tile["bytes_on_disk"]
+        stats["raw_bytes"] += tile["raw_bytes"]
+        stats["materials"].update(tile["materials"])
+
+    stats["leaves"] = sum(leaves)
+    stats["leaves_per_tile"] = {"min": min(leaves, default=0), "max": max(leaves, default=0),
+                                "mean": sum(leaves) / len(leaves) if leaves else 0}
+    stats["materials"] = dict(stats["materials"].most_common())
+
+    regions = os.path.join(path, "regions")
+    if os.path.isdir(regions):
+        for name in os.listdir(regions):
+            if not name.endswith(".reg"):
+                continue
+            file = os.path.join(regions, name)
+            stats["regions"] += 1
+            stats["bytes_on_disk"] += os.path.getsize(file)
+            try:
+                stats["marked_tiles"] += sum(read_region(file))
+            except (ValueError, struct.error, zlib.error):
+                stats["corrupt"].append(os.path.join("regions", name))
+
+    builds_file = os.path.join(path, "builds.csv")
+    builds = read_builds(builds_file) if os.path.isfile(builds_file) else []
+    times = [b["ms"] for b in builds]
+    stats["builds"] = {"count": len(builds), "total_ms": sum(times),
+                       "mean_ms": sum(times) / len(times) if times else 0,
+                       "max_ms": max(times, default=0),
+                       "nan_normals": sum(b["nan_normals"] for b in builds)}
+    return stats
+
+
+def map_stats(path):
+    """Reports on every resolution of a map's cache.
+
+    Args:
+        path (:obj:`str`): The map's folder in ``Octrees``.
+
+    Returns:
+        :obj:`list` of :obj:`dict`: What :func:`resolution_stats` reports for each, finest first.
+    """
+    found = [name for name in os.listdir(path) if _RESOLUTION_DIR.match(name)]
+    found.sort(key=lambda name: int(_RESOLUTION_DIR.match(name).group(1)))
+    return [resolution_stats(os.path.join(path, name)) for name in found]
+
+
+def _print_resolution(stats, out):
+    out.write("  min {octree_min} cm, max {octree_max} cm: {tiles} tiles, {leaves} leaves\n".format(**stats))
+    per_tile = stats["leaves_per_tile"]
+    out.write("    leaves per tile: min {} mean {:.1f} max {}\n".format(per_tile["min"], per_tile["mean"], per_tile["max"]))
+    out.write("    nodes per level: {}\n".format(" ".join(str(n) for n in stats["nodes_per_level"])))
+    out.write("    on disk: {:.2f} MB, uncompressed {:.2f} MB, {} regions marking {} tiles\n".format(
+        stats["bytes_on_disk"] / 2**20, stats["raw_bytes"] / 2**20, stats["regions"], stats["marked_tiles"]))
+    builds = stats["builds"]
+    if builds["count"]:
+        out.write("    builds: {count}, mean {mean_ms:.1f} ms, max {max_ms:.1f} ms, {nan_normals} NaN normals\n".format(**builds))
+    for material, count in list(stats["materials"].items())[:10]:
+        out.write("    {:>10}  {}\n".format(count, material))
+    if stats["corrupt"]:
+        out.write("    corrupt: {}\n".format(", ".join(stats["corrupt"])))
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(prog="python -m holoocean.octrees", description=__doc__.splitlines()[0])
+    parser.add_argument("path", help="A map's octree cache, one resolution of it, or a world's Octrees folder")
+    parser.add_argument("--json", action="store_true", help="Print everything as json")
+    args = parser.parse_args(argv)
+
+    path = os.path.normpath(args.path)
+    if _RESOLUTION_DIR.match(os.path.basename(path)):
+        maps = {os.path.basename(os.path.dirname(path)): [resolution_stats(path)]}
+    elif any(_RESOLUTION_DIR.match(name) for name in os.listdir(path)):
+        maps = {os.path.basename(path): map_stats(path)}
+    else:
+        maps = {name: map_stats(os.path.join(path, name)) for name in sorted(os.listdir(path))
+                if os.path.isdir(os.path.join(path, name)) and name != "Agents"}
+
+    if args.json:
+        json.dump(maps, sys.stdout, indent=2)
+        sys.stdout.write("\n")
+        return
+    for name, resolutions in maps.items():
+        sys.stdout.write("{}\n".format(name))
+        for stats in resolutions:
+            _print_resolution(stats, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()
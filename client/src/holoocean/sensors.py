@@ -21,6 +21,9 @@ class HoloOceanSensor:
     """
     default_config = {}
 
+    # Whether the engine skips the sensor's capture when it isn't wanted, see :attr:`wanted`
+    lazy = False
+
     def __init__(self, client, agent_name=None, agent_type=None,
                     name="DefaultSensor", config=None):
         self.name = name
@@ -28,12 +31,30 @@ class HoloOceanSensor:
         self.agent_name = agent_name
         self.agent_type = agent_type
         self._buffer_name = self.agent_name + "_" + self.name
+        self.config = {} if config is None else config
 
         self._sensor_data_buffer = \
             self._client.malloc(self._buffer_name + "_sensor_data",
                                 self.data_shape, self.dtype)
 
-        self.config = {} if config is None else config
+        # Optional ring of past samples, filled in by the engine every time the sensor captures
+        self._history_length = self.config.get("HistoryLength", 0)
+        if self._history_length > 0:
+            self._history_buffer = \
+                self._client.malloc(self._buffer_name + "_sensor_history",
+                                    [self._history_length] + list(self.data_shape), self.dtype)
+            self._history_ticks_buffer = \
+                self._client.malloc(self._buffer_name + "_sensor_history_ticks",
+                                    [self._history_length], np.uint32)
+            self._history_index_buffer = \
+                self._client.malloc(self._buffer_name + "_sensor_history_index", [1], np.uint32)
+            self._history_read = int(self._history_index_buffer[0])
+
+        self._wanted_buffer = \
+            self._client.malloc(self._buffer_name + "_sensor_wanted", [1], np.bool_)
+        self._wanted_buffer[0] = True
+        # Set whenever the sensor is looked up in a state, see ``lazy_sensors``
+        self.accessed = True
 
     @property
     def sensor_data(self):
@@ -43,11 +64,49 @@ class HoloOceanSensor:
             :obj:`np.ndarray` of size :obj:`self.data_shape`: Current sensor data
 
         """
-        if self.tick_count == self.tick_every:
+        if self.tick_count == self.tick_every and (self.wanted or not self.lazy):
             return self._sensor_data_buffer
         else:
             return None
 
+    @property
+    def wanted(self):
+        """Whether the client will read this sensor after the next tick. Lazy sensors (the
+        sonars and ``RGBCamera``) skip their capture on ticks where it's ``False``, and leave
+        no data in the state. Set ``lazy_sensors`` in the scenario to have this worked out from
+        which sensors are read.
+
+        Returns:
+            :obj:`bool`
+        """
+        return bool(self._wanted_buffer[0])
+
+    @wanted.setter
+    def wanted(self, wanted):
+        self._wanted_buffer[0] = wanted
+
+    def history(self):
+        """Get every sample the sensor captured since the last call, oldest first.
+        Requires ``HistoryLength`` to be set in the sensor's configuration block. If more
+        samples were captured than the history holds, only the newest ``HistoryLength``
+        are returned.
+
+        Returns:
+            (:obj:`np.ndarray`, :obj:`np.ndarray`): The samples, stacked along the first axis,
+            and the engine tick each one was captured on.
+        """
+        if self._history_length <= 0:
+            raise HoloOceanConfigurationException(
+                "Sensor {} has no history, set HistoryLength in its configuration".format(self.name))
+
+        written = int(self._history_index_buffer[0])
+        count = min(written - self._history_read, self._history_length)
+        slots = np.arange(written - count, written) % self._history_length
+        self._history_read = written
+        self.accessed = True
+
+        return np.copy(self._history_buffer[slots]), np.copy(self._history_ticks_buffer[slots])
+
     @property
     def dtype(self):
         """The type of data in the sensor
@@ -268,6 +327,7 @@ class RGBCamera(HoloOceanSensor):
     """
 
     sensor_type = "RGBCamera"
+    lazy = True
 
     def __init__(self, client, agent_name, agent_type, name="RGBCamera",  config=None):
 
@@ -705,7 +765,47 @@ class AbuseSensor(HoloOceanSensor):
 ######################## HOLOOCEAN CUSTOM SENSORS ###########################
 #Make sure to also add your new sensor to SensorDefinition below
 
-class SidescanSonar(HoloOceanSensor):
+class SonarSensor(HoloOceanSensor):
+    """Base class for the sonars, which search an octree of the world built by the engine.
+
+    The tiles of the octree near the sonar are built in the background when the sonar starts
+    up, the simulation keeps ticking meanwhile and the sonar returns no images until they're
+    done. Use :attr:`octree_ready` and :attr:`octree_progress` to check on it, or
+    :meth:`~holoocean.environments.HoloOceanEnvironment.wait_for_octrees` to wait for it.
+    """
+    # Values of the octree status word, must match ESonarOctreeStatus in the engine
+    OCTREE_WAITING = 0
+    OCTREE_BUILDING = 1
+    OCTREE_READY = 2
+
+    def __init__(self, client, agent_name=None, agent_type=None,
+                 name="DefaultSensor", config=None):
+        super(SonarSensor, self).__init__(client, agent_name, agent_type, name=name, config=config)
+
+        # [status, tiles done, tiles total], written by the engine every tick
+        self._octree_status_buffer = \
+            self._client.malloc(self._buffer_name + "_octree_status", [3], np.uint32)
+
+    @property
+    def octree_ready(self):
+        """Whether the octree near the sonar is built and the sonar is making images.
+
+        Returns:
+            :obj:`bool`
+        """
+        return int(self._octree_status_buffer[0]) == SonarSensor.OCTREE_READY
+
+    @property
+    def octree_progress(self):
+        """How far along the background build of the octree near the sonar is.
+
+        Returns:
+            (:obj:`int`, :obj:`int`): Tiles built so far, and the total number to build.
+        """
+        return int(self._octree_status_buffer[1]), int(self._octree_status_buffer[2])
+
+
+class SidescanSonar(SonarSensor):
     """Simulates a sidescan sonar. See :ref:`configure-octree` for more on
     how to configure the octree that is used.
 
@@ -731,6 +831,7 @@ class SidescanSonar(HoloOceanSensor):
     - ``AzimuthBins``/``AzimuthRes``: Number of azimuth bins of resulting image, or resolution (length in degrees) of each bin. Set one or the other. By default this is computed based on the OctreeMin.
     - ``ElevationBins``/``ElevationRes``: Number of elevation bins used when shadowing is done, or resolution (length in degrees) of each bin. Set one or the other. By default this is computed based on the octree size and the min range. Should only be set if shadowing isn't working.
     - ``InitOctreeRange``: Upon startup, all mid-level octrees within this distance of the agent will be created.
+    - ``OctreeMin``: Size of the smallest octree leaves this sonar sees, in meters. Sonars with different values on the same vehicle each load their own octrees. Defaults to the scenario's ``octree_min``.
     - ``ViewRegion``: Turns on green lines to see visible region. Defaults to False.
     - ``ViewOctree``: What octree leaves to show. Less than -1 means none, -1 means all, and anything greater than or equal to 0 shows the corresponding beam index. Defaults to -10.
     - ``ShadowEpsilon``: What constitutes a break between clusters when shadowing. Defaults to 4*OctreeMin.
@@ -739,6 +840,7 @@ class SidescanSonar(HoloOceanSensor):
 
     """
     sensor_type = "SidescanSonar"
+    lazy = True
 
     def __init__(self, client, agent_name, agent_type, name="SidescanSonar", config=None):
 
@@ -783,7 +885,7 @@ class SidescanSonar(HoloOceanSensor):
         return self.shape
 
 
-class ImagingSonar(HoloOceanSensor):
+class ImagingSonar(SonarSensor):
     """Simulates an imaging sonar. See :ref:`configure-octree` for more on
     how to configure the octree that is used.
 
@@ -814,6 +916,7 @@ class ImagingSonar(HoloOceanSensor):
     - ``ShowWarning``: Whether to show on screen warning about sonar computation happening. Defaults to True.
     - ``ElevationBins``/``ElevationRes``: Number of elevation bins used when shadowing is done, or resolution (length in degrees) of each bin. Set one or the other. By default this is computed based on the octree size and the min/max range. Should only be set if shadowing isn't working.
     - ``InitOctreeRange``: Upon startup, all mid-level octrees within this distance of the agent will be created.
+    - ``OctreeMin``: Size of the smallest octree leaves this sonar sees, in meters. Sonars with different values on the same vehicle each load their own octrees. Defaults to the scenario's ``octree_min``.
     - ``ViewRegion``: Turns on green lines to see visible region. Defaults to False.
     - ``ViewOctree``: What octree leaves to show. Less than -1 means none, -1 means all, and anything greater than or equal to 0 shows the corresponding beam index. Defaults to -10.
     - ``ShadowEpsilon``: What constitutes a break between clusters when shadowing. Defaults to 4*OctreeMin.
@@ -823,6 +926,7 @@ class ImagingSonar(HoloOceanSensor):
     """
 
     sensor_type = "ImagingSonar"
+    lazy = True
 
     def __init__(self, client, agent_name, agent_type, name="ImagingSonar", config=None):
 
@@ -869,7 +973,7 @@ class ImagingSonar(HoloOceanSensor):
     def data_shape(self):
         return self.shape
 
-class SinglebeamSonar(HoloOceanSensor):
+class SinglebeamSonar(SonarSensor):
     """Simulates an echosounder, which is a sonar sensor with a single cone shaped beam. See :ref:`configure-octree` for more on
     how to configure the octree that is used.
 
@@ -902,6 +1006,7 @@ class SinglebeamSonar(HoloOceanSensor):
     - ``OpeningAngleBins``/``OpeningAngleRes``: Number of OpeningAngle bins used when shadowing is done, or resolution (length in degrees) of each bin. Set one or the other. By default this is computed based on the octree size and the min/max range. Should only be set if shadowing isn't working.
     - ``CentralAngleBins``/``CentralAngleRes``: Number of CentralAngle bins used when shadowing is done, or resolution (length in degrees) of each bin. Set one or the other. By default this is computed based on the octree size and the min/max range. Should only be set if shadowing isn't working.
     - ``InitOctreeRange``: Upon startup, all mid-level octrees within this distance of the agent will be created.
+    - ``OctreeMin``: Size of the smallest octree leaves this sonar sees, in meters. Sonars with different values on the same vehicle each load their own octrees. Defaults to the scenario's ``octree_min``.
     - ``ViewRegion``: Turns on green lines to see visible region. Defaults to False.
     - ``ViewOctree``: What octree leaves to show. Less than -1 means none, -1 means all, and anything greater than or equal to 0 shows the corresponding beam index. Defaults to -10.
     - ``ShadowEpsilon``: What constitutes a break between clusters when shadowing. Defaults to 4*OctreeMin.
@@ -909,6 +1014,7 @@ class SinglebeamSonar(HoloOceanSensor):
     - ``WaterSpeedSound``: Speed of sound in water in m/s. Defaults to 1480.
     """ 
     sensor_type = "SinglebeamSonar" 
+    lazy = True
 
     def __init__(self, client, agent_name, agent_type, name="SinglebeamSonar", config=None):
 
@@ -985,6 +1091,7 @@ class ProfilingSonar(ImagingSonar):
     - ``ShowWarning``: Whether to show on screen warning about sonar computation happening. Defaults to True.
     - ``ElevationBins``/``ElevationRes``: Number of elevation bins used when shadowing is done, or resolution (length in degrees) of each bin. Set one or the other. By default this is computed based on the octree size and the min/max range. Should only be set if shadowing isn't working.
     - ``InitOctreeRange``: Upon startup, all mid-level octrees within this distance of the agent will be created.
+    - ``OctreeMin``: Size of the smallest octree leaves this sonar sees, in meters. Sonars with different values on the same vehicle each load their own octrees. Defaults to the scenario's ``octree_min``.
     - ``ViewRegion``: Turns on green lines to see visible region. Defaults to False.
     - ``ViewOctree``: What octree leaves to show. Less than -1 means none, -1 means all, and anything greater than or equal to 0 shows the corresponding beam index. Defaults to -10.
     - ``ShadowEpsilon``: What constitutes a break between clusters when shadowing. Defaults to 4*OctreeMin.
@@ -1494,6 +1601,9 @@ class SensorDefinition:
     # Generally sensors with a heavy computational cost
     _heavy_sensors = _sonar_sensors + ["RGBCamera"]
 
+    # Sensors that read rendered images, and can't be used with sensors_only
+    _rendered_sensors = ["RGBCamera", "ViewportCapture"]
+
     def get_config_json_string(self):
         """Gets the configuration dictionary as a string ready for transport
 
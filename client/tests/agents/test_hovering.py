@@ -65,4 +65,23 @@ def test_manual_dynamics(env):
     ang_accel = state["DynamicsSensor"][9:12]
 
     assert np.allclose(des[:3], accel), "Manual dynamics didn't hit the correct linear acceleration"
-    assert np.allclose(des[3:], ang_accel), "Manual dynamics didn't hit the correct angular acceleration"
\ No newline at end of file
+    assert np.allclose(des[3:], ang_accel), "Manual dynamics didn't hit the correct angular acceleration"
+
+def test_action_schedule(env):
+    """Test to make sure a schedule run in one tick call matches acting every tick
+    """
+    schedule = [[i / 10, 0, 0, 0, 0, 0] for i in range(10)]
+    env._scenario["agents"][0]["control_scheme"] = 2
+
+    env.reset()
+    for action in schedule:
+        expected = env.step(action)
+
+    env.reset()
+    env.act_schedule("auv0", schedule)
+    state = env.tick(len(schedule))
+
+    assert np.allclose(expected["DynamicsSensor"], state["DynamicsSensor"], atol=1e-3), \
+        "Action schedule didn't match acting every tick"
+    assert np.allclose(schedule[-1][:3], state["DynamicsSensor"][0:3]), \
+        "Last action in the schedule wasn't applied"
@@ -0,0 +1,85 @@
+import copy
+import holoocean
+import uuid
+import numpy as np
+
+fast_reset_config = {
+    "name": "test_fast_reset",
+    "world": "TestWorld",
+    "main_agent": "auv0",
+    "frames_per_sec": False,
+    "fast_reset": True,
+    "agents": [
+        {
+            "agent_name": "auv0",
+            "agent_type": "HoveringAUV",
+            "sensors": [
+                {
+                    "sensor_type": "DynamicsSensor",
+                }
+            ],
+            "control_scheme": 0,
+            "location": [0, 0, -10]
+        }
+    ]
+}
+
+
+def test_fast_reset():
+    """Make sure restoring the snapshot puts the agent back where a full reset does
+    """
+    binary_path = holoocean.packagemanager.get_binary_path_for_package("TestWorlds")
+
+    with holoocean.environments.HoloOceanEnvironment(scenario=fast_reset_config,
+                                                   binary_path=binary_path,
+                                                   show_viewport=False,
+                                                   uuid=str(uuid.uuid4()),
+                                                   ticks_per_sec=30) as env:
+        initial = env.reset()
+
+        for _ in range(3):
+            env.step([20, 20, 20, 20, 0, 0, 0, 0], 30)
+            state = env.reset()
+
+            assert env._snapshot_scenario is not None, "Snapshot wasn't kept"
+            assert np.allclose(initial["DynamicsSensor"], state["DynamicsSensor"], atol=1e-2), \
+                "Restored state doesn't match the state after a full reset"
+
+
+def test_fast_reset_capture_ticks():
+    """Make sure a sensor that captures every few ticks captures on the same ticks of the
+    episode after a fast reset as it did after the full reset
+    """
+    config = copy.deepcopy(fast_reset_config)
+    config["agents"][0]["sensors"].append({
+        "sensor_type": "RGBCamera",
+        "Hz": 10,
+        "configuration": {
+            "CaptureWidth": 64,
+            "CaptureHeight": 64
+        }
+    })
+    binary_path = holoocean.packagemanager.get_binary_path_for_package("TestWorlds")
+
+    with holoocean.environments.HoloOceanEnvironment(scenario=config,
+                                                   binary_path=binary_path,
+                                                   show_viewport=False,
+                                                   uuid=str(uuid.uuid4()),
+                                                   ticks_per_sec=30) as env:
+        def episode():
+            states = [env.reset()]
+            states += [env.step([0] * 8) for _ in range(7)]
+            return states
+
+        full = episode()
+        # Leave the server's tick on a different phase of the camera's period
+        env.step([0] * 8, 4)
+        fast = episode()
+
+        assert env._snapshot_scenario is not None, "Snapshot wasn't kept"
+        for i, (a, b) in enumerate(zip(full, fast)):
+            assert ("RGBCamera" in a) == ("RGBCamera" in b), \
+                "Camera captured on tick {} of one episode but not the other".format(i)
+            assert np.allclose(a["DynamicsSensor"], b["DynamicsSensor"], atol=1e-2), \
+                "Tick {} after a fast reset doesn't match the full reset".format(i)
+        assert any("RGBCamera" in s for s in full), "Camera never captured"
@@ -0,0 +1,49 @@
+import holoocean
+import json
+import uuid
+
+profile_config = {
+    "name": "test_profile",
+    "world": "TestWorld",
+    "main_agent": "auv0",
+    "frames_per_sec": False,
+    "agents": [
+        {
+            "agent_name": "auv0",
+            "agent_type": "HoveringAUV",
+            "sensors": [
+                {
+                    "sensor_type": "IMUSensor"
+                }
+            ],
+            "control_scheme": 0,
+            "location": [0, 0, -10]
+        }
+    ]
+}
+
+
+def test_profile(tmp_path):
+    """Make sure a profile capture writes a trace with the zones we expect
+    """
+    binary_path = holoocean.packagemanager.get_binary_path_for_package("TestWorlds")
+    path = tmp_path / "profile.json"
+
+    with holoocean.environments.HoloOceanEnvironment(scenario=profile_config,
+                                                   binary_path=binary_path,
+                                                   show_viewport=False,
+                                                   uuid=str(uuid.uuid4()),
+                                                   ticks_per_sec=30) as env:
+        env.profile(5, str(path))
+        for _ in range(8):
+            env.tick()
+
+    with open(path) as f:
+        trace = json.load(f)
+
+    names = {event["name"] for event in trace["traceEvents"] if event["ph"] == "X"}
+    assert "CommandCenter::Tick" in names
+    assert "Server::Acquire" in names
+
+    histogram = trace["histograms"]["CommandCenter::Tick"]
+    assert histogram["count"] == sum(histogram["buckets"])
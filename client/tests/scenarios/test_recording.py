@@ -0,0 +1,112 @@
+import holoocean
+import uuid
+import os
+import copy
+import json
+import subprocess
+import sys
+
+import pytest
+
+import numpy as np
+
+recording_config = {
+    "name": "test_recording",
+    "world": "TestWorld",
+    "main_agent": "auv0",
+    "frames_per_sec": False,
+    "seed": 42,
+    "agents": [
+        {
+            "agent_name": "auv0",
+            "agent_type": "HoveringAUV",
+            "sensors": [
+                {
+                    "sensor_type": "IMUSensor",
+                    "configuration": {
+                        "AccelSigma": 1,
+                        "AngVelSigma": 1
+                    }
+                }
+            ],
+            "control_scheme": 0,
+            "location": [0, 0, -10]
+        }
+    ]
+}
+
+
+def run(config):
+    binary_path = holoocean.packagemanager.get_binary_path_for_package("TestWorlds")
+    with holoocean.environments.HoloOceanEnvironment(scenario=config,
+                                                   binary_path=binary_path,
+                                                   show_viewport=False,
+                                                   uuid=str(uuid.uuid4()),
+                                                   ticks_per_sec=30) as env:
+        env.reset()
+        return [env.step([10, 10, 10, 10, 0, 0, 0, 0])["IMUSensor"] for _ in range(20)]
+
+
+def test_seeded_noise_repeats(tmp_path):
+    """Two runs with the same seed should draw the same noise, and recording
+    shouldn't change what the sensors return
+    """
+    config = copy.deepcopy(recording_config)
+    config["record_path"] = str(tmp_path)
+    config["record_sensors"] = ["IMUSensor"]
+
+    first = run(config)
+    second = run(recording_config)
+
+    assert np.allclose(first, second), "Seeded noise wasn't the same between runs"
+    assert os.path.isfile(os.path.join(tmp_path, "index.bin")), "Index wasn't written"
+    assert os.path.isfile(os.path.join(tmp_path, "chunk_0.bin")), "No records were written"
+
+
+def replay(path, world="TestWorld"):
+    """Replays a recording with the engine on its own, and returns the summary it writes"""
+    binary_path = holoocean.packagemanager.get_binary_path_for_package("TestWorlds")
+    run_uuid = str(uuid.uuid4())
+    subprocess.run([binary_path, world, "-HolodeckOn", "-RenderOffScreen", "-TicksPerSec=30",
+                    "--HolodeckUUID=" + run_uuid, "-HolodeckReplay=" + str(path)],
+                   stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL, timeout=120)
+
+    # Nobody waits on the loading semaphore, so it's left behind
+    import posix_ipc
+    try:
+        posix_ipc.unlink_semaphore('/HOLODECK_LOADING_SEM' + run_uuid)
+    except posix_ipc.ExistentialError:
+        pass
+
+    with open(os.path.join(path, "replay.json")) as f:
+        return json.load(f)
+
+
+@pytest.mark.skipif(sys.platform != "linux", reason="Launches the engine directly")
+def test_replay_repeated_flags(tmp_path):
+    """The engine clears the teleport flag once it's applied. Teleports sent on
+    consecutive ticks all need to be recorded, or the replayed location drifts
+    off from the recorded one
+    """
+    config = copy.deepcopy(recording_config)
+    config["record_path"] = str(tmp_path)
+    config["record_sensors"] = ["LocationSensor"]
+    config["agents"][0]["sensors"].append({"sensor_type": "LocationSensor"})
+
+    binary_path = holoocean.packagemanager.get_binary_path_for_package("TestWorlds")
+    with holoocean.environments.HoloOceanEnvironment(scenario=config,
+                                                   binary_path=binary_path,
+                                                   show_viewport=False,
+                                                   uuid=str(uuid.uuid4()),
+                                                   ticks_per_sec=30) as env:
+        env.reset()
+        env.act("auv0", [10, 10, 10, 10, 0, 0, 0, 0])
+        for _ in range(10):
+            env.agents["auv0"].teleport([0, 0, -10])
+            env.tick()
+        for _ in range(5):
+            env.tick()
+
+    summary = replay(tmp_path)
+    assert summary["ticks"] > 15, "Replay stopped before the recording ran out"
+    assert summary["mismatches"] == 0, "Replayed locations didn't match the recording"
@@ -0,0 +1,99 @@
+import copy
+import os
+import time
+import uuid
+
+import holoocean
+import numpy as np
+import pytest
+from holoocean.exceptions import HoloOceanConfigurationException
+
+sonar_config = {
+    "name": "test_sensors_only",
+    "world": "TestWorld",
+    "main_agent": "auv0",
+    "frames_per_sec": False,
+    "agents": [
+        {
+            "agent_name": "auv0",
+            "agent_type": "HoveringAUV",
+            "sensors": [
+                {
+                    "sensor_type": "ImagingSonar",
+                    "configuration": {
+                        "MinRange": .1,
+                        "MaxRange": 1
+                    }
+                },
+                {
+                    "sensor_type": "IMUSensor"
+                }
+            ],
+            "control_scheme": 0,
+            "location": [.95, -1.75, .5]
+        }
+    ]
+}
+
+NUM_TICKS = 200
+
+
+def ticks_per_second(config):
+    binary_path = holoocean.packagemanager.get_binary_path_for_package("TestWorlds")
+
+    with holoocean.environments.HoloOceanEnvironment(scenario=config,
+                                                   binary_path=binary_path,
+                                                   show_viewport=False,
+                                                   uuid=str(uuid.uuid4()),
+                                                   ticks_per_sec=30) as env:
+        # Let the octree load before timing anything
+        env.wait_for_octrees()
+
+        start = time.perf_counter()
+        for _ in range(NUM_TICKS):
+            state = env.tick()
+        elapsed = time.perf_counter() - start
+
+        assert "ImagingSonar" in state and np.any(state["ImagingSonar"]), "Sonar saw nothing"
+        return NUM_TICKS / elapsed
+
+
+def test_sensors_only_ticks():
+    """A sonar should still see the world with rendering turned off
+    """
+    config = copy.deepcopy(sonar_config)
+    config["sensors_only"] = True
+    assert ticks_per_second(config) > 0
+
+
+@pytest.mark.skipif(not os.environ.get("HOLOOCEAN_BENCHMARK"),
+                    reason="Timing depends on the machine, set HOLOOCEAN_BENCHMARK=1 to run it")
+def test_sensors_only_benchmark():
+    """Compare ticks per second of a sonar only scenario with and without rendering.
+    Run with -s to see the numbers
+    """
+    normal = ticks_per_second(sonar_config)
+
+    config = copy.deepcopy(sonar_config)
+    config["sensors_only"] = True
+    sensors_only = ticks_per_second(config)
+
+    print(f"\nnormal: {normal:.1f} ticks/s, sensors_only: {sensors_only:.1f} ticks/s "
+          f"({sensors_only / normal:.2f}x)")
+    assert sensors_only > 0.9 * normal, "Turning rendering off made ticking slower"
+
+
+def test_sensors_only_refuses_cameras():
+    """Cameras can't work without rendering, so they should be caught before the engine starts
+    """
+    config = copy.deepcopy(sonar_config)
+    config["sensors_only"] = True
+    config["agents"][0]["sensors"].append({"sensor_type": "RGBCamera", "socket": "CameraSocket"})
+
+    binary_path = holoocean.packagemanager.get_binary_path_for_package("TestWorlds")
+    with pytest.raises(HoloOceanConfigurationException):
+        holoocean.environments.HoloOceanEnvironment(scenario=config,
+                                                   binary_path=binary_path,
+                                                   show_viewport=False,
+                                                   uuid=str(uuid.uuid4()),
+                                                   ticks_per_sec=30)
@@ -0,0 +1,50 @@
+import holoocean
+import uuid
+
+telemetry_config = {
+    "name": "test_telemetry",
+    "world": "TestWorld",
+    "main_agent": "auv0",
+    "frames_per_sec": False,
+    "agents": [
+        {
+            "agent_name": "auv0",
+            "agent_type": "HoveringAUV",
+            "sensors": [
+                {
+                    "sensor_type": "IMUSensor"
+                },
+                {
+                    "sensor_type": "DVLSensor"
+                }
+            ],
+            "control_scheme": 0,
+            "location": [0, 0, -10]
+        }
+    ]
+}
+
+
+def test_telemetry():
+    """Make sure every sensor shows up in the telemetry and the timings are sane
+    """
+    binary_path = holoocean.packagemanager.get_binary_path_for_package("TestWorlds")
+
+    with holoocean.environments.HoloOceanEnvironment(scenario=telemetry_config,
+                                                   binary_path=binary_path,
+                                                   show_viewport=False,
+                                                   uuid=str(uuid.uuid4()),
+                                                   ticks_per_sec=30) as env:
+        env.tick()
+        first, _ = env.get_telemetry()
+        env.tick(5)
+        stages, sensors = env.get_telemetry()
+
+        assert stages["tick"] == first["tick"] + 5, "Telemetry wasn't from the last tick"
+        assert stages["tick_ms"] > 0
+        assert stages["physics_ms"] <= stages["tick_ms"]
+
+        names = {(agent.decode(), sensor.decode()) for agent, sensor, _ in sensors}
+        assert ("auv0", "IMUSensor") in names
+        assert ("auv0", "DVLSensor") in names
+        assert (sensors["ms"] >= 0).all()
@@ -0,0 +1,52 @@
+import holoocean
+import uuid
+import numpy as np
+
+history_config = {
+    "name": "test_history",
+    "world": "TestWorld",
+    "main_agent": "auv0",
+    "frames_per_sec": False,
+    "agents": [
+        {
+            "agent_name": "auv0",
+            "agent_type": "HoveringAUV",
+            "sensors": [
+                {
+                    "sensor_type": "DynamicsSensor",
+                    "configuration": {
+                        "HistoryLength": 20
+                    }
+                }
+            ],
+            "control_scheme": 0,
+            "location": [0, 0, -10]
+        }
+    ]
+}
+
+
+def test_history():
+    """Make sure every tick of a multi-tick step makes it into the history
+    """
+    binary_path = holoocean.packagemanager.get_binary_path_for_package("TestWorlds")
+
+    with holoocean.environments.HoloOceanEnvironment(scenario=history_config,
+                                                   binary_path=binary_path,
+                                                   show_viewport=False,
+                                                   uuid=str(uuid.uuid4()),
+                                                   ticks_per_sec=30) as env:
+        sensor = env.agents["auv0"].sensors["DynamicsSensor"]
+        sensor.history()
+
+        state = env.tick(10)
+        samples, ticks = sensor.history()
+
+        assert len(samples) == 10, "Didn't get a sample for every tick"
+        assert np.all(np.diff(ticks.astype(np.int64)) == 1), "Samples weren't from consecutive ticks"
+        assert np.allclose(samples[-1], state["DynamicsSensor"]), "Last sample doesn't match the state"
+
+        # More ticks than the history holds only keeps the newest
+        env.tick(30)
+        samples, ticks = sensor.history()
+        assert len(samples) == 20
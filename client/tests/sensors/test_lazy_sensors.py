@@ -0,0 +1,80 @@
+import holoocean
+import pytest
+import uuid
+from types import SimpleNamespace
+
+from holoocean.environments import _TrackedState
+
+lazy_config = {
+    "name": "test_lazy_sensors",
+    "world": "TestWorld",
+    "main_agent": "sphere0",
+    "frames_per_sec": False,
+    "lazy_sensors": True,
+    "agents": [
+        {
+            "agent_name": "sphere0",
+            "agent_type": "SphereAgent",
+            "sensors": [
+                {
+                    "sensor_type": "RGBCamera",
+                    "sensor_name": "FrontCamera",
+                    "socket": "CameraSocket"
+                },
+                {
+                    "sensor_type": "RGBCamera",
+                    "sensor_name": "BackCamera",
+                    "socket": "CameraSocket",
+                    "rotation": [0, 0, 180]
+                },
+                {
+                    "sensor_type": "LocationSensor"
+                }
+            ],
+            "control_scheme": 0,
+            "location": [.95, -1.75, .5]
+        }
+    ]
+}
+
+
+def test_lazy_sensors():
+    """Make sure cameras that aren't read stop being captured, cheap sensors are unaffected,
+    and a camera comes back the tick after it's asked for
+    """
+    binary_path = holoocean.packagemanager.get_binary_path_for_package("TestWorlds")
+
+    with holoocean.environments.HoloOceanEnvironment(scenario=lazy_config,
+                                                   binary_path=binary_path,
+                                                   show_viewport=False,
+                                                   uuid=str(uuid.uuid4()),
+                                                   ticks_per_sec=30) as env:
+        sensors = env.agents["sphere0"].sensors
+
+        for _ in range(3):
+            state = env.tick()
+            state["FrontCamera"]
+            state["LocationSensor"]
+
+        state = env.tick()
+        assert sensors["FrontCamera"].wanted
+        assert not sensors["BackCamera"].wanted
+        assert not dict.__contains__(state, "BackCamera"), "Unread camera was still captured"
+        assert dict.__contains__(state, "LocationSensor"), "Cheap sensors shouldn't be skipped"
+
+        assert "BackCamera" not in state
+        state = env.tick()
+        assert sensors["BackCamera"].wanted
+        assert "BackCamera" in state
+
+
+@pytest.mark.parametrize("read", [dict, lambda s: {**s}, list, lambda s: s.keys(),
+                                  lambda s: [name for name in s]])
+def test_lazy_sensors_whole_state(read):
+    """Make sure going through the whole state, however it's done, counts as reading every sensor"""
+    sensors = {name: SimpleNamespace(accessed=False) for name in ["FrontCamera", "BackCamera"]}
+    state = _TrackedState(sensors)
+    dict.__setitem__(state, "FrontCamera", 0)
+
+    read(state)
+    assert all(sensor.accessed for sensor in sensors.values()), "Sensors weren't marked as read"
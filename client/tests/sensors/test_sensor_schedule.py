@@ -0,0 +1,59 @@
+import holoocean
+import uuid
+
+schedule_config = {
+    "name": "test_sensor_schedule",
+    "world": "TestWorld",
+    "main_agent": "sphere0",
+    "frames_per_sec": False,
+    "agents": [
+        {
+            "agent_name": "sphere0",
+            "agent_type": "SphereAgent",
+            "sensors": [
+                {
+                    "sensor_type": "RGBCamera",
+                    "sensor_name": "FrontCamera",
+                    "socket": "CameraSocket",
+                    "Hz": 10
+                },
+                {
+                    "sensor_type": "RGBCamera",
+                    "sensor_name": "BackCamera",
+                    "socket": "CameraSocket",
+                    "rotation": [0, 0, 180],
+                    "Hz": 10
+                }
+            ],
+            "control_scheme": 0,
+            "location": [.95, -1.75, .5]
+        }
+    ]
+}
+
+
+def test_sensor_schedule():
+    """Make sure sensors with the same period are staggered, and only report data on the
+    ticks they were scheduled to capture on
+    """
+    binary_path = holoocean.packagemanager.get_binary_path_for_package("TestWorlds")
+
+    with holoocean.environments.HoloOceanEnvironment(scenario=schedule_config,
+                                                   binary_path=binary_path,
+                                                   show_viewport=False,
+                                                   uuid=str(uuid.uuid4()),
+                                                   ticks_per_sec=30) as env:
+        env.tick()
+        sensors, summary = env.get_sensor_schedule()
+
+        assert len(sensors) == 2
+        assert (sensors["period"] == 3).all()
+        assert sensors["phase"][0] != sensors["phase"][1], "Cameras weren't staggered"
+        assert summary["peak_cost"] < summary["unstaggered_peak_cost"]
+
+        phases = {sensor.decode(): int(phase) for sensor, phase in zip(sensors["sensor"], sensors["phase"])}
+        for _ in range(12):
+            state = env.tick()
+            tick, _ = env.get_telemetry()
+            for name, phase in phases.items():
+                assert (name in state) == (tick["tick"] % 3 == phase)
@@ -1,6 +1,10 @@
 import holoocean
 import uuid
 import os
+import json
+import shutil
+import struct
+import zlib
 import pytest
 import numpy as np
 
@@ -67,3 +71,380 @@ def test_blank(config):
         for _ in range(10):
             state = env.tick()["ImagingSonar"]
             assert np.allclose(np.zeros_like(state), state)
+
+
+def test_render_poses(config):
+    """Render a batch of poses and make sure each matches where it was placed,
+    and that the sonar's own data is left alone"""
+
+    binary_path = holoocean.packagemanager.get_binary_path_for_package("TestWorlds")
+
+    with holoocean.environments.HoloOceanEnvironment(scenario=config,
+                                                   binary_path=binary_path,
+                                                   show_viewport=False,
+                                                   uuid=str(uuid.uuid4())) as env:
+        state = env.wait_for_octrees()["ImagingSonar"]
+
+        poses = [config["agents"][0]["location"] + [0, 0, 0], [-100, -100, -100, 0, 0, 0]] * 3
+        images = env.render_sonar_poses("auv0", "ImagingSonar", poses, batch_size=4)
+
+        assert images.shape == (6,) + state.shape
+        assert np.any(images[0]), "Sonar saw nothing from the agent's pose"
+        assert np.allclose(np.zeros_like(images[1]), images[1]), "Sonar saw something in the middle of nowhere"
+        assert np.any(images[4]), "Second batch wasn't rendered"
+        assert np.any(env.tick()["ImagingSonar"]), "Rendering poses moved the sonar"
+
+
+def test_background_octree(config):
+    """Make sure the simulation keeps ticking while the octree is built, and the
+    sonar reports how far along it is"""
+
+    binary_path = holoocean.packagemanager.get_binary_path_for_package("TestWorlds")
+
+    with holoocean.environments.HoloOceanEnvironment(scenario=config,
+                                                   binary_path=binary_path,
+                                                   show_viewport=False,
+                                                   uuid=str(uuid.uuid4())) as env:
+        sonar = env.agents["auv0"].sensors["ImagingSonar"]
+        for _ in range(10):
+            env.tick()
+
+        done, total = sonar.octree_progress
+        assert done <= total
+        if not sonar.octree_ready:
+            assert not np.any(env.tick()["ImagingSonar"]), "Sonar made an image before its octree was built"
+
+        env.wait_for_octrees(timeout=600)
+        assert sonar.octree_ready
+        assert sonar.octree_progress[0] == sonar.octree_progress[1]
+        assert np.any(env.tick()["ImagingSonar"]), "Sonar saw nothing once its octree was built"
+
+
+def octree_dir(config):
+    dir = os.path.join(holoocean.util.get_holoocean_path(), "worlds/TestWorlds/LinuxNoEditor/Holodeck/Octrees")
+    return os.path.join(dir, f"{config['world']}/min{int(config['octree_min']*100)}_max{int(config['octree_max']*100)}")
+
+
+def check_tile(path):
+    """Make sure a saved tile's header is right and all of it is there.
+    Returns whether it was compressed"""
+    with open(path, "rb") as file:
+        data = file.read()
+    magic, version, flags, raw_size = struct.unpack("<4I", data[:16])
+    assert magic == 0x4C49544F, f"{path} isn't a tile"
+    if flags & 1:
+        assert len(zlib.decompress(data[16:])) == raw_size, f"{path} is cut off"
+    else:
+        assert len(data) - 16 == raw_size, f"{path} is cut off"
+    return bool(flags & 1)
+
+
+def test_shared_octree_cache(config):
+    """Build the same octree from two instances at once, and make sure every tile
+    that was saved is whole and nothing was left half written"""
+
+    config["octree_min"] = .03
+    config["octree_max"] = 3.84
+    shutil.rmtree(octree_dir(config), ignore_errors=True)
+
+    binary_path = holoocean.packagemanager.get_binary_path_for_package("TestWorlds")
+
+    envs = [holoocean.environments.HoloOceanEnvironment(scenario=config,
+                                                      binary_path=binary_path,
+                                                      show_viewport=False,
+                                                      uuid=str(uuid.uuid4())) for _ in range(2)]
+    try:
+        sonars = [env.agents["auv0"].sensors["ImagingSonar"] for env in envs]
+        while not all(sonar.octree_ready for sonar in sonars):
+            for env in envs:
+                env.tick()
+    finally:
+        for env in envs:
+            env.__on_exit__()
+
+    files = os.listdir(octree_dir(config))
+    assert not [f for f in files if f.endswith(".tmp")], "Half written tiles were left behind"
+    assert not [f for f in files if f.endswith(".corrupt")], "A tile was corrupted"
+    for f in files:
+        if f.endswith(".json"):
+            with open(os.path.join(octree_dir(config), f)) as file:
+                json.load(file)
+        if f.endswith(".oct"):
+            check_tile(os.path.join(octree_dir(config), f))
+
+
+def test_corrupt_tile(config):
+    """Make sure cut off tiles are moved aside and built again"""
+
+    config["octree_min"] = .02
+    config["octree_max"] = 5.12
+    binary_path = holoocean.packagemanager.get_binary_path_for_package("TestWorlds")
+
+    with holoocean.environments.HoloOceanEnvironment(scenario=config,
+                                                   binary_path=binary_path,
+                                                   show_viewport=False,
+                                                   uuid=str(uuid.uuid4())) as env:
+        env.wait_for_octrees()
+
+    tiles = [os.path.join(octree_dir(config), f) for f in os.listdir(octree_dir(config)) if f.endswith(".oct")]
+    assert tiles, "No tiles were saved"
+    for tile in tiles:
+        with open(tile, "rb") as file:
+            contents = file.read()
+        with open(tile, "wb") as file:
+            file.write(contents[:len(contents) // 2])
+
+    with holoocean.environments.HoloOceanEnvironment(scenario=config,
+                                                   binary_path=binary_path,
+                                                   show_viewport=False,
+                                                   uuid=str(uuid.uuid4())) as env:
+        env.wait_for_octrees()
+        assert np.any(env.tick()["ImagingSonar"]), "Sonar saw nothing after rebuilding tiles"
+
+    assert any(os.path.isfile(tile + ".corrupt") for tile in tiles), "Corrupt tiles weren't quarantined"
+    for tile in tiles:
+        if os.path.isfile(tile + ".corrupt"):
+            check_tile(tile)
+
+
+@pytest.mark.skipif(not os.path.isdir("/dev/shm"), reason="Checks the cache in /dev/shm")
+def test_shared_tile_cache(config):
+    """Run two instances sharing loaded tiles, and make sure both see the world
+    and the cache is emptied once they're both closed"""
+
+    config["octree_shared_cache"] = True
+    binary_path = holoocean.packagemanager.get_binary_path_for_package("TestWorlds")
+
+    before = set(f for f in os.listdir("/dev/shm") if f.startswith("HOLODECK_OCTREE_"))
+    envs = [holoocean.environments.HoloOceanEnvironment(scenario=config,
+                                                      binary_path=binary_path,
+                                                      show_viewport=False,
+                                                      uuid=str(uuid.uuid4())) for _ in range(2)]
+    try:
+        for env in envs:
+            env.wait_for_octrees()
+        for env in envs:
+            assert np.any(env.tick()["ImagingSonar"]), "Sonar saw nothing with the shared cache"
+
+        cached = set(f for f in os.listdir("/dev/shm") if f.startswith("HOLODECK_OCTREE_"))
+        assert cached - before, "No tiles were put in the shared cache"
+    finally:
+        for env in envs:
+            env.__on_exit__()
+
+    after = set(f for f in os.listdir("/dev/shm") if f.startswith("HOLODECK_OCTREE_"))
+    assert not after - before, "Tiles were left in the shared cache"
+
+
+def test_dag_tiles(config):
+    """Make sure tiles kept as DAGs give the same image as regular ones, and take up less space"""
+
+    config["octree_min"] = .02
+    config["octree_max"] = 5.12
+    binary_path = holoocean.packagemanager.get_binary_path_for_package("TestWorlds")
+
+    images = []
+    for dag in [False, True]:
+        config["octree_dag"] = dag
+        with holoocean.environments.HoloOceanEnvironment(scenario=config,
+                                                       binary_path=binary_path,
+                                                       show_viewport=False,
+                                                       uuid=str(uuid.uuid4())) as env:
+            env.wait_for_octrees()
+            images.append(env.tick()["ImagingSonar"])
+
+    assert np.any(images[0]), "Sonar saw nothing"
+    assert np.allclose(images[0], images[1], atol=1e-5), "DAG tiles changed the image"
+    assert [f for f in os.listdir(octree_dir(config)) if f.endswith(".dag")], "No DAG tiles were saved"
+
+
+def test_compressed_tiles(config):
+    """Make sure compressed tiles are saved compressed, load, and give the same image"""
+
+    config["octree_min"] = .04
+    config["octree_max"] = 5.12
+    shutil.rmtree(octree_dir(config), ignore_errors=True)
+    binary_path = holoocean.packagemanager.get_binary_path_for_package("TestWorlds")
+
+    images = []
+    for compress in [False, True]:
+        config["octree_compress"] = compress
+        with holoocean.environments.HoloOceanEnvironment(scenario=config,
+                                                       binary_path=binary_path,
+                                                       show_viewport=False,
+                                                       uuid=str(uuid.uuid4())) as env:
+            env.wait_for_octrees()
+            images.append(env.tick()["ImagingSonar"])
+        # Built again from scratch, so the tiles are saved the new way
+        if not compress:
+            tiles = [f for f in os.listdir(octree_dir(config)) if f.endswith(".oct")]
+            assert tiles and not any(check_tile(os.path.join(octree_dir(config), f)) for f in tiles)
+            shutil.rmtree(octree_dir(config))
+
+    tiles = [f for f in os.listdir(octree_dir(config)) if f.endswith(".oct")]
+    assert tiles and all(check_tile(os.path.join(octree_dir(config), f)) for f in tiles), "Tiles weren't compressed"
+    assert np.any(images[0]), "Sonar saw nothing"
+    assert np.allclose(images[0], images[1]), "Compressing tiles changed the image"
+
+
+def test_derived_tiles(config):
+    """Make sure a coarser cache is filled in from a finer one, and the sonar sees the world with it"""
+
+    binary_path = holoocean.packagemanager.get_binary_path_for_package("TestWorlds")
+
+    config["octree_min"] = .02
+    config["octree_max"] = 5.12
+    with holoocean.environments.HoloOceanEnvironment(scenario=config,
+                                                   binary_path=binary_path,
+                                                   show_viewport=False,
+                                                   uuid=str(uuid.uuid4())) as env:
+        env.wait_for_octrees()
+
+    config["octree_min"] = .08
+    shutil.rmtree(octree_dir(config), ignore_errors=True)
+    with holoocean.environments.HoloOceanEnvironment(scenario=config,
+                                                   binary_path=binary_path,
+                                                   show_viewport=False,
+                                                   uuid=str(uuid.uuid4())) as env:
+        assert env.derive_octrees() > 0, "No tiles were derived"
+        tiles = [f for f in os.listdir(octree_dir(config)) if f.endswith(".oct")]
+        for f in tiles:
+            check_tile(os.path.join(octree_dir(config), f))
+
+        env.wait_for_octrees()
+        assert np.any(env.tick()["ImagingSonar"]), "Sonar saw nothing with derived tiles"
+
+
+def test_sonar_octree_min(config):
+    """Make sure a sonar with its own OctreeMin loads octrees at that size, next to the scenario's"""
+
+    config["octree_min"] = .02
+    config["octree_max"] = 5.12
+    config["agents"][0]["sensors"].append({
+        "sensor_type": "ImagingSonar",
+        "sensor_name": "CoarseSonar",
+        "configuration": {
+            "MinRange": .1,
+            "MaxRange": 1,
+            "OctreeMin": .08
+        }
+    })
+    binary_path = holoocean.packagemanager.get_binary_path_for_package("TestWorlds")
+
+    with holoocean.environments.HoloOceanEnvironment(scenario=config,
+                                                   binary_path=binary_path,
+                                                   show_viewport=False,
+                                                   uuid=str(uuid.uuid4())) as env:
+        env.wait_for_octrees()
+        state = env.tick()
+        assert np.any(state["ImagingSonar"]), "Sonar saw nothing"
+        assert np.any(state["CoarseSonar"]), "Sonar with its own OctreeMin saw nothing"
+
+    assert os.path.isdir(octree_dir(config)), "Scenario's octree folder wasn't made"
+    config["octree_min"] = .08
+    assert os.path.isdir(octree_dir(config)), "Sonar's octree folder wasn't made"
+
+
+def test_agent_octree_cache(config):
+    """Make sure agents with the same mesh share one octree, saved once on disk"""
+
+    for i in range(1, 4):
+        config["agents"].append({
+            "agent_name": f"auv{i}",
+            "agent_type": "HoveringAUV",
+            "sensors": [],
+            "control_scheme": 0,
+            "location": [.95 + .5*i, -1.75, .5]
+        })
+    agent_dir = os.path.join(holoocean.util.get_holoocean_path(), "worlds/TestWorlds/LinuxNoEditor/Holodeck/Octrees/Agents")
+    shutil.rmtree(agent_dir, ignore_errors=True)
+    binary_path = holoocean.packagemanager.get_binary_path_for_package("TestWorlds")
+
+    with holoocean.environments.HoloOceanEnvironment(scenario=config,
+                                                   binary_path=binary_path,
+                                                   show_viewport=False,
+                                                   uuid=str(uuid.uuid4())) as env:
+        env.wait_for_octrees()
+        assert np.any(env.tick()["ImagingSonar"]), "Sonar saw nothing"
+
+    tiles = [f for f in os.listdir(agent_dir) if f.endswith(".oct")]
+    assert len(tiles) == 1, f"Expected one octree for the HoveringAUVs, found {tiles}"
+    check_tile(os.path.join(agent_dir, tiles[0]))
+
+
+def test_region_index(config):
+    """Make sure the index above the tiles is saved as regions, and only near the sonar"""
+
+    config["octree_min"] = .1
+    config["octree_max"] = 1.6
+    config["env_min"] = [-500, -500, -50]
+    config["env_max"] = [500, 500, 50]
+    shutil.rmtree(octree_dir(config), ignore_errors=True)
+    binary_path = holoocean.packagemanager.get_binary_path_for_package("TestWorlds")
+
+    with holoocean.environments.HoloOceanEnvironment(scenario=config,
+                                                   binary_path=binary_path,
+                                                   show_viewport=False,
+                                                   uuid=str(uuid.uuid4())) as env:
+        env.wait_for_octrees()
+        assert np.any(env.tick()["ImagingSonar"]), "Sonar saw nothing"
+
+    region_dir = os.path.join(octree_dir(config), "regions")
+    regions = [f for f in os.listdir(region_dir) if f.endswith(".reg")]
+    assert regions, "No regions were saved"
+    assert len(regions) <= 8, f"Regions far from the sonar were made: {regions}"
+    assert not os.path.exists(os.path.join(octree_dir(config), "roots.json"))
+
+
+def test_octree_stats(config):
+    """Make sure the engine's octree counters and the cache report agree on what was built"""
+
+    config["octree_min"] = .1
+    config["octree_max"] = 1.6
+    shutil.rmtree(octree_dir(config), ignore_errors=True)
+    binary_path = holoocean.packagemanager.get_binary_path_for_package("TestWorlds")
+
+    with holoocean.environments.HoloOceanEnvironment(scenario=config,
+                                                   binary_path=binary_path,
+                                                   show_viewport=False,
+                                                   uuid=str(uuid.uuid4())) as env:
+        env.wait_for_octrees()
+        stats = env.octree_stats()
+
+    res = stats["resolutions"][0]
+    assert res["loads"]["built"] > 0, "No tiles were counted as built"
+    assert res["resident_tiles"] > 0 and res["resident_bytes"] > 0
+    assert res["builds"] >= res["loads"]["built"]
+
+    cache = res["cache"]
+    assert cache["tiles"] == cache["builds"]["count"] == res["builds"]
+    assert cache["leaves"] == cache["nodes_per_level"][-1] > 0
+    assert sum(cache["materials"].values()) == cache["leaves"]
+    assert cache["bytes_on_disk"] > 0
+    assert not cache["corrupt"]
+
+
+def test_spawned_prop(config):
+    """Make sure a prop spawned in front of the sonar shows up once its tiles are rebuilt,
+    without changing the saved tiles"""
+
+    config["octree_min"] = .02
+    config["octree_max"] = 5.12
+    binary_path = holoocean.packagemanager.get_binary_path_for_package("TestWorlds")
+
+    with holoocean.environments.HoloOceanEnvironment(scenario=config,
+                                                   binary_path=binary_path,
+                                                   show_viewport=False,
+                                                   uuid=str(uuid.uuid4())) as env:
+        env.wait_for_octrees()
+        before = env.tick()["ImagingSonar"]
+        saved = {f: os.path.getmtime(os.path.join(octree_dir(config), f))
+                 for f in os.listdir(octree_dir(config)) if f.endswith(".oct")}
+
+        env.spawn_prop("box", location=[1.5, -1.75, .5], scale=.2)
+        for _ in range(20):
+            after = env.tick()["ImagingSonar"]
+
+    assert not np.allclose(before, after), "Sonar didn't see the spawned prop"
+    for f, mtime in saved.items():
+        assert os.path.getmtime(os.path.join(octree_dir(config), f)) == mtime, f"{f} was changed"
@@ -1,6 +1,7 @@
 #include "Holodeck.h"
 #include "CommandCenter.h"
 #include "HolodeckGameMode.h" // to avoid a circular dependency. 
+#include "HolodeckProfiler.h"
 
 const FString UCommandCenter::BUFFER_NAME = "command_buffer";
 const FString UCommandCenter::BUFFER_SHOULD_READ_NAME = "command_bool";
@@ -18,6 +19,7 @@ UCommandCenter::UCommandCenter() {
 }
 
 void UCommandCenter::Tick(float DeltaTime) {
+	HOLODECK_PROFILE_ZONE("CommandCenter::Tick");
 	if (ShouldReadBufferPtr && *ShouldReadBufferPtr == true) {
 		ReadCommandBuffer();
 		*ShouldReadBufferPtr = false;
@@ -16,7 +16,13 @@ UCommand* UCommandFactory::MakeCommand(const std::string& Name, const std::vecto
 										  { "RotateSensor", &CreateInstance<URotateSensorCommand> },
 										  { "CustomCommand", &CreateInstance<UCustomCommand> },
 										  { "SendAcousticMessage", &CreateInstance<USendAcousticMessageCommand> },
-										  { "SendOpticalMessage", &CreateInstance<USendOpticalMessageCommand> }, };
+										  { "SendOpticalMessage", &CreateInstance<USendOpticalMessageCommand> },
+										  { "SaveSnapshot", &CreateInstance<USaveSnapshotCommand> },
+										  { "RestoreSnapshot", &CreateInstance<URestoreSnapshotCommand> },
+										  { "Profile", &CreateInstance<UProfileCommand> },
+										  { "RenderSonarPoses", &CreateInstance<URenderSonarPosesCommand> },
+										  { "DeriveOctrees", &CreateInstance<UDeriveOctreesCommand> },
+										  { "OctreeStats", &CreateInstance<UOctreeStatsCommand> }, };
 
 	UCommand*(*CreateCommandFunction)()  = CommandMap[Name];
 	UCommand* ToReturn = nullptr;
@@ -0,0 +1,23 @@
+// MIT License (c) 2021 BYU FRoStLab see LICENSE file
+
+#include "Holodeck.h"
+#include "DeriveOctreesCommand.h"
+#include "HolodeckGameMode.h"
+#include "Octree.h"
+
+const FString UDeriveOctreesCommand::DerivedKey = "derived_octrees";
+
+void UDeriveOctreesCommand::Execute() {
+	UE_LOG(LogHolodeck, Log, TEXT("UDeriveOctreesCommand::Execute"));
+
+	if (StringParams.size() != 0 || NumberParams.size() != 0) {
+		UE_LOG(LogHolodeck, Error, TEXT("Unexpected argument length found in UDeriveOctreesCommand. Command not executed."));
+		return;
+	}
+
+	AHolodeckGameMode* Game = static_cast<AHolodeckGameMode*>(Target);
+	UHolodeckServer* Server = Game->GetAssociatedServer();
+	uint32* Derived = static_cast<uint32*>(Server->Malloc(DerivedKey, sizeof(uint32)));
+
+	*Derived = Octree::deriveAll(*Game->GetOctreeContext());
+}
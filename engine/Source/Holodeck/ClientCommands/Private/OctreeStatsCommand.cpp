@@ -0,0 +1,22 @@
+// MIT License (c) 2021 BYU FRoStLab see LICENSE file
+
+#include "Holodeck.h"
+#include "OctreeStatsCommand.h"
+#include "HolodeckGameMode.h"
+#include "OctreeStats.h"
+
+void UOctreeStatsCommand::Execute() {
+	UE_LOG(LogHolodeck, Log, TEXT("UOctreeStatsCommand::Execute"));
+
+	if (StringParams.size() != 1 || NumberParams.size() != 0) {
+		UE_LOG(LogHolodeck, Error, TEXT("Unexpected argument length found in UOctreeStatsCommand. Command not executed."));
+		return;
+	}
+
+	FString Path = UTF8_TO_TCHAR(StringParams[0].c_str());
+	if (Path.IsEmpty())
+		Path = FPaths::ProjectLogDir() / TEXT("OctreeStats.json");
+
+	AHolodeckGameMode* Game = static_cast<AHolodeckGameMode*>(Target);
+	OctreeStats::write(*Game->GetOctreeContext(), Path);
+}
@@ -0,0 +1,19 @@
+// MIT License (c) 2021 BYU FRoStLab see LICENSE file
+
+#include "Holodeck.h"
+#include "HolodeckProfiler.h"
+#include "ProfileCommand.h"
+
+void UProfileCommand::Execute() {
+	UE_LOG(LogHolodeck, Log, TEXT("UProfileCommand::Execute starting profile capture"));
+
+	if (StringParams.size() != 1 || NumberParams.size() != 1) {
+		UE_LOG(LogHolodeck, Error, TEXT("Unexpected argument length found in UProfileCommand. Command not executed."));
+		return;
+	}
+
+	int NumTicks = NumberParams[0];
+	FString Path = UTF8_TO_TCHAR(StringParams[0].c_str());
+
+	HolodeckProfiler::Capture(NumTicks, Path);
+}
@@ -30,5 +30,5 @@ void URGBCameraRateCommand::Execute() {
 	verifyf(Agent->SensorMap.Contains(SensorName), TEXT("%s Sensor %s not found on agent %s"), *FString(__func__), *SensorName, *AgentName);
 
 	URGBCamera* Camera = (URGBCamera*)Agent->SensorMap[SensorName];
-	Camera->TicksPerCapture = ticksPerCapture;
+	Camera->SetTicksPerCapture(ticksPerCapture);
 }
@@ -0,0 +1,55 @@
+// MIT License (c) 2021 BYU FRoStLab see LICENSE file
+
+#include "Holodeck.h"
+#include "RenderSonarPosesCommand.h"
+#include "HolodeckGameMode.h"
+#include "HolodeckSonar.h"
+#include "Conversion.h"
+
+const FString URenderSonarPosesCommand::PoseBatchKey = "_pose_batch";
+const FString URenderSonarPosesCommand::PoseBatchImagesKey = "_pose_batch_images";
+const FString URenderSonarPosesCommand::PoseBatchCountKey = "_pose_batch_count";
+
+void URenderSonarPosesCommand::Execute() {
+	UE_LOG(LogHolodeck, Log, TEXT("URenderSonarPosesCommand::Execute"));
+
+	if (StringParams.size() != 2 || NumberParams.size() != 2) {
+		UE_LOG(LogHolodeck, Error, TEXT("Unexpected argument length found in URenderSonarPosesCommand. Command not executed."));
+		return;
+	}
+
+	FString AgentName = StringParams[0].c_str();
+	FString SensorName = StringParams[1].c_str();
+	int NumPoses = NumberParams[0];
+	int Capacity = NumberParams[1];
+
+	AHolodeckAgent* Agent = GetAgent(AgentName);
+	if (Agent == nullptr) {
+		return;
+	}
+
+	UHolodeckSonar* Sonar = Agent->SensorMap.Contains(SensorName) ? Cast<UHolodeckSonar>(Agent->SensorMap[SensorName]) : nullptr;
+	if (Sonar == nullptr || NumPoses <= 0 || NumPoses > Capacity) {
+		UE_LOG(LogHolodeck, Error, TEXT("URenderSonarPosesCommand:: %s on agent %s isn't a sonar, or no poses were given. Command not executed."), *SensorName, *AgentName);
+		return;
+	}
+
+	// Sized for the whole batch every time, so the buffers are reused for a shorter last batch
+	AHolodeckGameMode* Game = static_cast<AHolodeckGameMode*>(Target);
+	UHolodeckServer* Server = Game->GetAssociatedServer();
+
+	float* PoseBuffer = static_cast<float*>(Server->Malloc(UHolodeckServer::MakeKey(AgentName, SensorName + PoseBatchKey), Capacity * 6 * sizeof(float)));
+	float* ImageBuffer = static_cast<float*>(Server->Malloc(UHolodeckServer::MakeKey(AgentName, SensorName + PoseBatchImagesKey), Capacity * Sonar->GetImageSize() * sizeof(float)));
+	uint32* CountBuffer = static_cast<uint32*>(Server->Malloc(UHolodeckServer::MakeKey(AgentName, SensorName + PoseBatchCountKey), sizeof(uint32)));
+
+	TArray<FTransform> Poses;
+	Poses.Reserve(NumPoses);
+	for (int i = 0; i < NumPoses; i++) {
+		float* Row = PoseBuffer + i * 6;
+		FVector Location = ConvertLinearVector(FVector(Row[0], Row[1], Row[2]), ClientToUE);
+		FRotator Rotation = RPYToRotator(Row[3], Row[4], Row[5]);
+		Poses.Add(FTransform(Rotation, Location));
+	}
+
+	*CountBuffer = Sonar->RenderPoses(Poses, ImageBuffer);
+}
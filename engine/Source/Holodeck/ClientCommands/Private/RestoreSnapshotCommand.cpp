@@ -0,0 +1,22 @@
+// MIT License (c) 2021 BYU FRoStLab see LICENSE file
+
+#include "Holodeck.h"
+#include "HolodeckGameMode.h"
+#include "RestoreSnapshotCommand.h"
+
+void URestoreSnapshotCommand::Execute() {
+	UE_LOG(LogHolodeck, Log, TEXT("URestoreSnapshotCommand::Execute restoring level snapshot"));
+
+	if (StringParams.size() != 0 || NumberParams.size() != 0) {
+		UE_LOG(LogHolodeck, Error, TEXT("Unexpected argument length found in URestoreSnapshotCommand. Command not executed."));
+		return;
+	}
+
+	AHolodeckGameMode* Game = static_cast<AHolodeckGameMode*>(Target);
+	if (Game == nullptr) {
+		UE_LOG(LogHolodeck, Warning, TEXT("URestoreSnapshotCommand: UCommand::Target is not a UHolodeckGameMode*. Snapshot not restored."));
+		return;
+	}
+
+	Game->RestoreSnapshot();
+}
@@ -18,6 +18,12 @@
 #include "RotateSensorCommand.h"
 #include "SendAcousticMessageCommand.h"
 #include "SendOpticalMessageCommand.h"
+#include "SaveSnapshotCommand.h"
+#include "RestoreSnapshotCommand.h"
+#include "ProfileCommand.h"
+#include "RenderSonarPosesCommand.h"
+#include "DeriveOctreesCommand.h"
+#include "OctreeStatsCommand.h"
 
 #include "CommandFactory.generated.h"
 
@@ -0,0 +1,27 @@
+// MIT License (c) 2021 BYU FRoStLab see LICENSE file
+
+#pragma once
+
+#include "Holodeck.h"
+
+#include "Command.h"
+#include "DeriveOctreesCommand.generated.h"
+
+/**
+* DeriveOctreesCommand
+* Command used to fill in the octree cache for the current OctreeMin/OctreeMax
+* by merging a finer cache of the same map, instead of building it from the world.
+*
+* Takes no parameters. The number of tiles made is written to the derived
+* octrees buffer.
+*/
+UCLASS(ClassGroup = (Custom))
+class HOLODECK_API UDeriveOctreesCommand : public UCommand
+{
+	GENERATED_BODY()
+
+public:
+	void Execute() override;
+
+	static const FString DerivedKey;
+};
@@ -0,0 +1,26 @@
+// MIT License (c) 2021 BYU FRoStLab see LICENSE file
+
+#pragma once
+
+#include "Holodeck.h"
+
+#include "Command.h"
+#include "OctreeStatsCommand.generated.h"
+
+/**
+* OctreeStatsCommand
+* Command used to write out what the octree tiles have done this session: loads
+* by where they came from, unloads, resident tiles and memory, and build times,
+* for each OctreeMin sensors have asked for.
+*
+* StringParameters are expected to be the path to write the json to, or empty
+* for the default.
+*/
+UCLASS(ClassGroup = (Custom))
+class HOLODECK_API UOctreeStatsCommand : public UCommand
+{
+	GENERATED_BODY()
+
+public:
+	void Execute() override;
+};
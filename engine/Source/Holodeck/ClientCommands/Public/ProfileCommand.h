@@ -0,0 +1,27 @@
+// MIT License (c) 2021 BYU FRoStLab see LICENSE file
+
+#pragma once
+
+#include "Holodeck.h"
+
+#include "Command.h"
+#include "ProfileCommand.generated.h"
+
+/**
+* ProfileCommand
+* Command used to record the next few ticks with the HolodeckProfiler and write
+* them out as a Chrome trace.
+*
+* StringParameters are expected to be the path to write the trace to, or empty
+* for the default.
+* NumberParameters are expected to be the number of ticks to record.
+*
+*/
+UCLASS(ClassGroup = (Custom))
+class HOLODECK_API UProfileCommand : public UCommand
+{
+	GENERATED_BODY()
+
+public:
+	void Execute() override;
+};
@@ -0,0 +1,35 @@
+// MIT License (c) 2021 BYU FRoStLab see LICENSE file
+
+#pragma once
+
+#include "Holodeck.h"
+
+#include "Command.h"
+#include "RenderSonarPosesCommand.generated.h"
+
+/**
+* RenderSonarPosesCommand
+* Command used to compute a sonar's images at a list of poses, all within one
+* tick and without moving the agent.
+*
+* StringParameters are expected to be the agent name and the sonar's sensor name.
+* NumberParameters are expected to be the number of poses and the most poses
+* the buffers hold.
+*
+* The client writes the poses to the sensor's pose batch buffer as
+* [x, y, z, roll, pitch, yaw] rows, and reads the images back from the pose
+* batch images buffer. Both are sized for the most poses, so the same ones are
+* used for every batch. The count buffer holds how many images were made.
+*/
+UCLASS(ClassGroup = (Custom))
+class HOLODECK_API URenderSonarPosesCommand : public UCommand
+{
+	GENERATED_BODY()
+
+public:
+	void Execute() override;
+
+	static const FString PoseBatchKey;
+	static const FString PoseBatchImagesKey;
+	static const FString PoseBatchCountKey;
+};
@@ -0,0 +1,26 @@
+// MIT License (c) 2021 BYU FRoStLab see LICENSE file
+
+#pragma once
+
+#include "Holodeck.h"
+
+#include "Command.h"
+#include "RestoreSnapshotCommand.generated.h"
+
+/**
+* RestoreSnapshotCommand
+* Command used to put the level back into the state captured by the last
+* SaveSnapshotCommand, without reloading the level.
+*
+* StringParameters are expected to be empty.
+* NumberParameters are expected to be empty.
+*
+*/
+UCLASS(ClassGroup = (Custom))
+class HOLODECK_API URestoreSnapshotCommand : public UCommand
+{
+	GENERATED_BODY()
+
+public:
+	void Execute() override;
+};
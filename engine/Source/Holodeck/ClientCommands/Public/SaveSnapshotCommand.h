@@ -0,0 +1,26 @@
+// MIT License (c) 2021 BYU FRoStLab see LICENSE file
+
+#pragma once
+
+#include "Holodeck.h"
+
+#include "Command.h"
+#include "SaveSnapshotCommand.generated.h"
+
+/**
+* SaveSnapshotCommand
+* Command used to capture the state of the level so it can be restored with
+* RestoreSnapshotCommand instead of reloading the level on reset.
+*
+* StringParameters are expected to be empty.
+* NumberParameters are expected to be empty.
+*
+*/
+UCLASS(ClassGroup = (Custom))
+class HOLODECK_API USaveSnapshotCommand : public UCommand
+{
+	GENERATED_BODY()
+
+public:
+	void Execute() override;
+};
@@ -3,6 +3,7 @@
 #include "Holodeck.h"
 #include "HolodeckViewportClient.h"
 #include "HolodeckCamera.h" //Included here to avoid cyclic dependency. 
+#include "HolodeckGameMode.h"
 
 UHolodeckViewportClient::UHolodeckViewportClient(const class FObjectInitializer& PCIP) : Super(PCIP) {}
 
@@ -15,6 +16,10 @@ void UHolodeckViewportClient::HolodeckTakeScreenShot() {
 }
 
 void UHolodeckViewportClient::Draw(FViewport * ViewportParam, FCanvas * SceneCanvas) {
+	// There's nothing to show or capture when only sensors are running
+	if (AHolodeckGameMode::IsSensorsOnly())
+		return;
+
 	Super::Draw(ViewportParam, SceneCanvas);
 	HolodeckTakeScreenShot();
 }
@@ -0,0 +1,42 @@
+// MIT License (c) 2021 BYU FRoStLab see LICENSE file
+
+#include "Holodeck.h"
+#include "NoiseSeed.h"
+
+#include <atomic>
+#include <random>
+
+namespace {
+	std::atomic<bool> bSeeded{ false };
+	std::atomic<uint32_t> BaseSeed{ 0 };
+	std::atomic<uint32_t> Counter{ 0 };
+}
+
+void NoiseSeed::SetSeed(uint32_t Seed) {
+	BaseSeed = Seed;
+	Counter = 0;
+	bSeeded = true;
+	UE_LOG(LogHolodeck, Log, TEXT("NoiseSeed:: Seeding noise with %u"), Seed);
+}
+
+bool NoiseSeed::IsSeeded() {
+	return bSeeded;
+}
+
+uint32_t NoiseSeed::GetSeed() {
+	return BaseSeed;
+}
+
+uint32_t NoiseSeed::Next() {
+	if (!bSeeded) {
+		std::random_device rd{};
+		return rd();
+	}
+
+	// Mix the base seed with the generator's index so neighbouring
+	// generators don't end up with correlated streams
+	std::seed_seq Seq{ (uint32_t)BaseSeed, (uint32_t)Counter++ };
+	uint32_t Result;
+	Seq.generate(&Result, &Result + 1);
+	return Result;
+}
@@ -2,6 +2,23 @@
 
 
 #include "Octree.h"
+#include "HolodeckProfiler.h"
+#include "Async/ParallelFor.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+#include <atomic>
+
+#if PLATFORM_WINDOWS
+#include "AllowWindowsPlatformTypes.h"
+#include <windows.h>
+#include "HideWindowsPlatformTypes.h"
+#elif PLATFORM_LINUX
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#include <cstdio>
+#endif
 
 // Initialize static variables
 // Used when making octree
@@ -20,17 +37,9 @@ TArray<FVector> Octree::sides = {FVector( 0, 0, 1),
                                     FVector( 1, 0, 0),
                                     FVector(-1, 0, 0)};
 float Octree::cornerSize = 0.01;
-FCollisionQueryParams Octree::params = Octree::init_params();
 
 // Misc constants
-float Octree::OctreeRoot;
-float Octree::OctreeMax;
-float Octree::OctreeMin;
-FVector Octree::EnvMin;
-FVector Octree::EnvMax;
-FVector Octree::EnvCenter;
-UWorld* Octree::World;
-TDiscardableKeyValueCache<FString, float> Octree::materials;
+bool Octree::useDag;
 
 float sign(float val){
     bool s = signbit(val);
@@ -38,110 +47,358 @@ float sign(float val){
     else return 1.0;
 }
 
-void Octree::initOctree(UWorld* w){
-    World = w;
-
-    // Load environment size
-    if (!FParse::Value(FCommandLine::Get(), TEXT("EnvMinX="), EnvMin.X)) EnvMin.X = -10;
-    if (!FParse::Value(FCommandLine::Get(), TEXT("EnvMinY="), EnvMin.Y)) EnvMin.Y = -10;
-    if (!FParse::Value(FCommandLine::Get(), TEXT("EnvMinZ="), EnvMin.Z)) EnvMin.Z = -10;
-    if (!FParse::Value(FCommandLine::Get(), TEXT("EnvMaxX="), EnvMax.X)) EnvMax.X = 10;
-    if (!FParse::Value(FCommandLine::Get(), TEXT("EnvMaxY="), EnvMax.Y)) EnvMax.Y = 10;
-    if (!FParse::Value(FCommandLine::Get(), TEXT("EnvMaxZ="), EnvMax.Z)) EnvMax.Z = 10;
-    // Clean environment size
-    EnvMin = ConvertLinearVector(EnvMin, ClientToUE);
-    EnvMax = ConvertLinearVector(EnvMax, ClientToUE);
-    FVector min = FVector((int)FGenericPlatformMath::Min(EnvMin.X, EnvMax.X), (int)FGenericPlatformMath::Min(EnvMin.Y, EnvMax.Y), (int)FGenericPlatformMath::Min(EnvMin.Z, EnvMax.Z));
-    FVector max = FVector((int)FGenericPlatformMath::Max(EnvMin.X, EnvMax.X), (int)FGenericPlatformMath::Max(EnvMin.Y, EnvMax.Y), (int)FGenericPlatformMath::Max(EnvMin.Z, EnvMax.Z));
-    EnvMin = min;
-    EnvMax = max;
-    UE_LOG(LogHolodeck, Log, TEXT("Octree:: EnvMin: %s"), *EnvMin.ToString());
-    UE_LOG(LogHolodeck, Log, TEXT("Octree:: EnvMax: %s"), *EnvMax.ToString());
-
-    // Get octree min/max
-    float tempVal;
-    if (!FParse::Value(FCommandLine::Get(), TEXT("OctreeMin="), tempVal)) tempVal = .1;
-    OctreeMin = (tempVal*100);
-    if (!FParse::Value(FCommandLine::Get(), TEXT("OctreeMax="), tempVal)) tempVal = 5;
-    OctreeMax = (tempVal*100);
-
-    // Calculate where/how big is biggest octree
-    EnvCenter = (EnvMax + EnvMin) / 2;
-    OctreeRoot = (EnvMax - EnvMin).GetAbsMax();
-
-    // Make max/root a multiple of min
-    tempVal = OctreeMin;
-    while(tempVal < OctreeMax){
-        tempVal *= 2;
-    }
-    OctreeMax = tempVal;
-    while(tempVal < OctreeRoot){
-        tempVal *= 2;
-    }
-    OctreeRoot = tempVal;
-    UE_LOG(LogHolodeck, Log, TEXT("Octree:: OctreeMin: %f, OctreeMax: %f, OctreeRoot: %f"), OctreeMin, OctreeMax, OctreeRoot);
-
-    // Load material lookup table
-    FString filePath = FPaths::ProjectDir() + "../../materials.csv";
-    TArray<FString> lines;
-	FFileHelper::LoadANSITextFileToStrings(*filePath, NULL, lines);
-	for (int i = 1; i < lines.Num(); i++)
-	{
-        // Split line into elements
-		TArray<FString> stringArray = {};
-		lines[i].ParseIntoArray(stringArray, TEXT(","), false);
-
-        // Put elements into lookup table
-        FString key = stringArray[0];
-        if(stringArray.Num() == 3){
-            // density, speed of sound
-            float z = FCString::Atof(*stringArray[1]) * FCString::Atof(*stringArray[2]);
-            materials.Add(key, z);
+// Exclusive advisory lock on a tile, held while it's built so processes sharing the
+// octree folder don't build the same tile at once. Waits for whoever holds it. The OS
+// drops the lock if the holder dies, so a crashed build doesn't leave the tile locked.
+struct TileLock {
+    TileLock(const FString& path){
+        #if PLATFORM_WINDOWS
+        handle = CreateFileA(TCHAR_TO_ANSI(*path), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+        OVERLAPPED overlapped = {};
+        if(handle == INVALID_HANDLE_VALUE || !LockFileEx(handle, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &overlapped)){
+            UE_LOG(LogHolodeck, Warning, TEXT("Octree: Couldn't lock %s, building without it."), *path);
         }
-	}
+        #elif PLATFORM_LINUX
+        fd = open(TCHAR_TO_ANSI(*path), O_CREAT | O_RDWR, 0666);
+        if(fd == -1 || flock(fd, LOCK_EX) == -1){
+            UE_LOG(LogHolodeck, Warning, TEXT("Octree: Couldn't lock %s, building without it."), *path);
+        }
+        #endif
+    }
+
+    ~TileLock(){
+        #if PLATFORM_WINDOWS
+        if(handle != INVALID_HANDLE_VALUE) CloseHandle(handle);
+        #elif PLATFORM_LINUX
+        if(fd != -1) close(fd);
+        #endif
+    }
+
+    #if PLATFORM_WINDOWS
+    HANDLE handle = INVALID_HANDLE_VALUE;
+    #elif PLATFORM_LINUX
+    int fd = -1;
+    #endif
+};
+
+// Moves from over to, replacing it in one step so readers never see half a file
+static bool replaceFile(const FString& from, const FString& to){
+    #if PLATFORM_WINDOWS
+    return MoveFileExA(TCHAR_TO_ANSI(*from), TCHAR_TO_ANSI(*to), MOVEFILE_REPLACE_EXISTING) != 0;
+    #else
+    return rename(TCHAR_TO_ANSI(*from), TCHAR_TO_ANSI(*to)) == 0;
+    #endif
+}
+
+// Writes to a file of our own and moves it into place, so other processes never load half a tile
+static void writeTile(const FString& file, const void* data, int64 size){
+    FString tmp = file + FString::Printf(TEXT(".%u.%u.tmp"), FPlatformProcess::GetCurrentProcessId(), FPlatformTLS::GetCurrentThreadId());
+    FILE* fp = fopen(TCHAR_TO_ANSI(*tmp), "w+b");
+    bool written = fp != nullptr && fwrite(data, size, 1, fp) == 1;
+    if(fp != nullptr) written = fclose(fp) == 0 && written;
+
+    if(!written || !replaceFile(tmp, file)){
+        UE_LOG(LogHolodeck, Warning, TEXT("Octree: Couldn't save %s, it'll be built again next time."), *file);
+        IFileManager::Get().Delete(*tmp, false, false, true);
+    }
+}
+
+FString Octree::tileName(const FVector& loc){
+    return FString::FromInt((int)loc.X) + "_" + FString::FromInt((int)loc.Y) + "_" + FString::FromInt((int)loc.Z);
 }
 
-Octree* Octree::makeEnvOctreeRoot(){
-    // Get caching/loading location
-    FString filePath = FPaths::ProjectDir() + "Octrees/" + World->GetMapName();
-    filePath += "/min" + FString::FromInt(OctreeMin) + "_max" + FString::FromInt(OctreeMax);
-    FString rootFile = filePath + "/" + "roots.json";
-
-    // load
-    Octree* root = new Octree(EnvCenter, OctreeRoot, rootFile);
-    root->makeTill = Octree::OctreeMax;
-    root->load();
-    
-    // set filename/makeTill for all OctreeMax nodes
-    std::function<void(Octree*)> fix;
-    fix = [&filePath, &fix](Octree* tree){
-        if(tree->size == Octree::OctreeMax){
-            tree->makeTill = Octree::OctreeMin;
-            tree->file = filePath + "/" + FString::FromInt((int)tree->loc.X) + "_" 
-                                        + FString::FromInt((int)tree->loc.Y) + "_" 
-                                        + FString::FromInt((int)tree->loc.Z) + ".json";
+Octree* Octree::makeEnvOctreeRoot(OctreeContext& ctx, float min){
+    HOLODECK_PROFILE_ZONE("Octree::makeEnvOctreeRoot");
+    const OctreeContext::Resolution& res = ctx.resolution(min > 0 ? min : ctx.OctreeMin);
+    FFileManagerGeneric().MakeDirectory(*(res.dir + "/regions"), true);
+
+    // Everything under it is made as sensors get near it, see loadIndex
+    Octree* root = new Octree(ctx.EnvCenter, res.root);
+    root->makeTill = res.min;
+    if(res.root == res.max){
+        root->tile = true;
+        root->file = ctx.tileFile(res.dir + "/" + tileName(root->loc) + (useDag ? ".dag" : ".oct"));
+    }
+    else{
+        root->index = true;
+    }
+
+    UE_LOG(LogHolodeck, Log, TEXT("Octree::Made Octree root"));
+
+    return root;
+}
+
+float Octree::regionSize(float tileSize, float rootSize){
+    return FMath::Min(rootSize, tileSize*RegionTiles);
+}
+
+FString Octree::regionFile(const FString& dir, const FVector& loc){
+    return dir + "/regions/" + tileName(loc) + ".reg";
+}
+
+int32 Octree::regionBit(const FVector& regionLoc, float region, float tileSize, const FVector& at){
+    int32 n = FMath::RoundToInt(region / tileSize);
+    FVector rel = (at - regionLoc + FVector(region/2)) / tileSize;
+    int32 i = FMath::Clamp(FMath::FloorToInt(rel.X), 0, n - 1);
+    int32 j = FMath::Clamp(FMath::FloorToInt(rel.Y), 0, n - 1);
+    int32 k = FMath::Clamp(FMath::FloorToInt(rel.Z), 0, n - 1);
+    return (k*n + j)*n + i;
+}
+
+FVector Octree::regionTile(const FVector& regionLoc, float region, float tileSize, int32 bit){
+    int32 n = FMath::RoundToInt(region / tileSize);
+    return regionLoc - FVector(region/2) + FVector(bit % n + .5f, bit / n % n + .5f, bit / (n*n) + .5f)*tileSize;
+}
+
+FVector Octree::nodeAt(OctreeContext& ctx, float rootSize, float size, const FVector& at){
+    // Walk down the same way the octree is split, so it lands exactly on the node's center
+    FVector center = ctx.EnvCenter;
+    for(float s = rootSize; s > size; s /= 2){
+        center += OctreeCodec::cornerOf(OctreeCodec::slotOf(at - center))*s/4;
+    }
+    return center;
+}
+
+static const uint32 RegionMagic = 0x4745524F;  // "OREG"
+static const uint32 RegionVersion = 1;
+
+bool Octree::loadRegion(const FString& path, int32 count, TBitArray<>& bits){
+    TArray<uint8> bytes, raw;
+    if(!FFileHelper::LoadFileToArray(bytes, *path, FILEREAD_Silent) || !OctreeCodec::unpack(RegionMagic, RegionVersion, bytes, raw)) return false;
+    FMemoryReader ar(raw);
+    ar << bits;
+    return !ar.IsError() && ar.AtEnd() && bits.Num() == count;
+}
+
+void Octree::saveRegion(const FString& path, TBitArray<>& bits){
+    TArray<uint8> raw, bytes;
+    FMemoryWriter ar(raw);
+    ar << bits;
+    OctreeCodec::pack(RegionMagic, RegionVersion, raw, bytes);
+    writeTile(path, bytes.GetData(), bytes.Num());
+}
+
+void Octree::makeRegion(OctreeContext& ctx, const OctreeContext::Resolution& res, const FVector& regionLoc, TBitArray<>& bits){
+    float region = regionSize(res.max, res.root);
+    int32 n = FMath::RoundToInt(region / res.max);
+    bits.Init(false, n*n*n);
+    if(deriveRegion(ctx, res, regionLoc, bits)) return;
+    bits.Init(false, n*n*n);
+
+    HOLODECK_PROFILE_ZONE("Octree::makeRegion");
+    Octree* made = makeOctree(ctx, regionLoc, region, res.max, "", false);
+    std::function<void(Octree*)> mark;
+    mark = [&](Octree* tree){
+        if(tree->size == res.max){
+            bits[regionBit(regionLoc, region, res.max, tree->loc)] = true;
         }
         else{
-            for(Octree* l : tree->leaves){
-                fix(l);
-            }
+            for(Octree* l : tree->leaves) mark(l);
         }
     };
-    fix(root);
-    
-    UE_LOG(LogHolodeck, Log, TEXT("Octree::Made Octree root"));
+    if(made) mark(made);
+    delete made;
+}
 
-    return root;
+bool Octree::deriveRegion(OctreeContext& ctx, const OctreeContext::Resolution& res, const FVector& regionLoc, TBitArray<>& bits){
+    // A finer cache whose tiles go down to ours already knows where they all are
+    if(res.finerDir.IsEmpty() || res.finerMax > res.max) return false;
+    float region = regionSize(res.max, res.root);
+    float finerRegion = regionSize(res.finerMax, res.root);
+    int32 count = FMath::Cube(FMath::RoundToInt(finerRegion / res.finerMax));
+
+    // Its regions are the same size or smaller, and line up with ours
+    int32 per = FMath::RoundToInt(region / finerRegion);
+    for(int32 i = 0; i < per*per*per; i++){
+        FVector finerLoc = nodeAt(ctx, res.root, finerRegion, regionTile(regionLoc, region, finerRegion, i));
+        TBitArray<> finer;
+        if(!loadRegion(regionFile(res.finerDir, finerLoc), count, finer)) return false;
+        for(TConstSetBitIterator<> it(finer); it; ++it){
+            bits[regionBit(regionLoc, region, res.max, regionTile(finerLoc, finerRegion, res.finerMax, it.GetIndex()))] = true;
+        }
+    }
+    return true;
+}
+
+void Octree::loadIndex(OctreeContext& ctx){
+    HOLODECK_PROFILE_ZONE("Octree::loadIndex");
+    indexed = true;
+    const OctreeContext::Resolution& res = ctx.resolution(makeTill);
+    if(size > regionSize(res.max, res.root)){
+        // Nothing's saved above regions, so make every child that's in the environment
+        FBox env(ctx.EnvMin, ctx.EnvMax);
+        for(FVector off : corners){
+            FVector center = loc + off*size/4;
+            if(!env.Intersect(FBox(center - FVector(size/4), center + FVector(size/4)))) continue;
+            Octree* child = new Octree(center, size/2);
+            child->index = true;
+            child->makeTill = makeTill;
+            leaves.Add(child);
+        }
+        return;
+    }
+
+    // It's a region, work out which tiles are in it once and save it for next time.
+    // Only one process makes it, the others wait and load what it saved
+    int32 count = FMath::Cube(FMath::RoundToInt(size / res.max));
+    FString path = regionFile(res.dir, loc);
+    TBitArray<> bits;
+    if(!ctx.findRegion(path, bits) && !loadRegion(path, count, bits)){
+        TileLock lock(path + ".lock");
+        if(!loadRegion(path, count, bits)){
+            makeRegion(ctx, res, loc, bits);
+            saveRegion(path, bits);
+        }
+    }
+
+    for(TConstSetBitIterator<> it(bits); it; ++it){
+        Octree* tree = addLeaf(regionTile(loc, size, res.max, it.GetIndex()), res.max);
+        if(tree == nullptr) continue;
+        tree->tile = true;
+        tree->makeTill = res.min;
+        tree->file = ctx.tileFile(res.dir + "/" + tileName(tree->loc) + (useDag ? ".dag" : ".oct"));
+    }
 }
 
-Octree* Octree::makeOctree(FVector center, float octreeSize, float octreeMin, FString actorName){
+void Octree::rebuildTiles(OctreeContext& ctx, const TArray<FBox>& boxes, int32 generation, const std::atomic<bool>& cancel,
+                          TArray<OctreeContext::TileUpdate>& made, TMap<FString, TBitArray<>>& regions){
+    HOLODECK_PROFILE_ZONE("Octree::rebuildTiles");
+    // Points from min to max no more than step apart, so every tile between them has one in it
+    auto steps = [](float min, float max, float step){
+        TArray<float> found;
+        for(float at = min; at < max; at += step) found.Add(at);
+        found.Add(max);
+        return found;
+    };
+
+    for(const OctreeContext::Resolution* res : ctx.getResolutions()){
+        FBox root(ctx.EnvCenter - FVector(res->root/2), ctx.EnvCenter + FVector(res->root/2));
+        FString ext = useDag ? ".dag" : ".oct";
+        TMap<FString, Octree*> found;
+        for(const FBox& box : boxes){
+            // Probes reach a leaf past a tile's edge, so the tiles next to it may have changed too
+            FBox inside = box.ExpandBy(res->min).Overlap(root);
+            if(!inside.IsValid) continue;
+            for(float x : steps(inside.Min.X, inside.Max.X, res->max))
+            for(float y : steps(inside.Min.Y, inside.Max.Y, res->max))
+            for(float z : steps(inside.Min.Z, inside.Max.Z, res->max)){
+                FVector center = nodeAt(ctx, res->root, res->max, FVector(x, y, z));
+                FString name = tileName(center) + ext;
+                if(found.Contains(name)) continue;
+                FString file = ctx.rebuildDir(*res) + "/" + tileName(center) + "_" + FString::FromInt(generation) + ext;
+                Octree* tile = new Octree(center, res->max, file);
+                tile->tile = true;
+                tile->makeTill = res->min;
+                found.Add(name, tile);
+            }
+        }
+        TArray<Octree*> tiles;
+        found.GenerateValueArray(tiles);
+
+        TArray<bool> occupied;
+        occupied.Init(false, tiles.Num());
+        ParallelFor(tiles.Num(), [&](int32 i){
+            if(cancel) return;
+            Octree* tile = tiles[i];
+            OctreeStats::startBuild();
+            tile->build(ctx);
+            OctreeStats::finishBuild(tile);
+            occupied[i] = tile->leaves.Num() != 0;
+            tile->save();
+        });
+
+        // Regions only list the tiles with something in them, so ones that filled up or emptied out change them
+        float region = regionSize(res->max, res->root);
+        int32 count = FMath::Cube(FMath::RoundToInt(region / res->max));
+        for(int32 i = 0; i < tiles.Num(); i++){
+            Octree* tile = tiles[i];
+            if(!cancel){
+                made.Add({res->min, tile->loc, tile->file, res->dir + "/" + tileName(tile->loc) + ext});
+            }
+            if(!cancel && res->root != res->max){
+                FVector regionLoc = nodeAt(ctx, res->root, region, tile->loc);
+                FString path = regionFile(res->dir, regionLoc);
+                TBitArray<>* bits = regions.Find(path);
+                if(bits == nullptr){
+                    TBitArray<> loaded;
+                    if(!ctx.findRegion(path, loaded) && !loadRegion(path, count, loaded)){
+                        makeRegion(ctx, *res, regionLoc, loaded);
+                    }
+                    bits = &regions.Add(path, loaded);
+                }
+                (*bits)[regionBit(regionLoc, region, res->max, tile->loc)] = occupied[i];
+            }
+            delete tile;
+        }
+    }
+}
+
+void Octree::replaceTile(OctreeContext& ctx, const OctreeContext::TileUpdate& update){
+    const OctreeContext::Resolution& res = ctx.resolution(makeTill);
+    float region = regionSize(res.max, res.root);
+    Octree* node = this;
+    while(!node->isTile()){
+        // It'll be made with the rebuilt file when the index gets to it
+        if(node->isIndex() && !node->indexed) return;
+
+        // Regions only list tiles that had something in them, so it may be new
+        if(node->isIndex() && node->size <= region){
+            Octree* tree = node->addLeaf(update.loc, res.max);
+            if(tree != nullptr){
+                tree->tile = true;
+                tree->makeTill = res.min;
+                tree->file = update.file;
+                return;
+            }
+        }
+
+        int32 slot = OctreeCodec::slotOf(update.loc - node->loc);
+        Octree* child = nullptr;
+        for(Octree* l : node->leaves){
+            if(OctreeCodec::slotOf(l->loc - node->loc) == slot){
+                child = l;
+                break;
+            }
+        }
+        if(child == nullptr) return;
+        node = child;
+    }
+
+    node->unload();
+    node->file = update.file;
+}
+
+void Octree::tilesNear(OctreeContext& ctx, const FVector& at, float dist, TArray<Octree*>& found){
+    if(isTile()){
+        if((at - loc).Size() <= dist) found.Add(this);
+        return;
+    }
+
+    // Nothing under it can be close enough
+    if((at - loc).Size() > dist + size*FMath::Sqrt(3)/2) return;
+    if(isIndex()) load(ctx);
+    for(Octree* l : leaves){
+        l->tilesNear(ctx, at, dist, found);
+    }
+}
+
+Octree* Octree::makeOctree(OctreeContext& ctx, FVector center, float octreeSize, float octreeMin, FString actorName, bool fill){
+    // Hold on to the collision settings for the whole build, so ignoring actors meanwhile doesn't change them under us
+    TSharedRef<const FCollisionQueryParams, ESPMode::ThreadSafe> params = ctx.getParams();
+    return makeOctree(ctx, *params, FTransform::Identity, center, octreeSize, octreeMin, actorName, fill);
+}
+
+Octree* Octree::makeOctree(OctreeContext& ctx, const FCollisionQueryParams& params, const FTransform& frame, FVector center, float octreeSize, float octreeMin, const FString& actorName, bool fill){
+    UWorld* World = ctx.World;
+    FVector at = frame.TransformPosition(center);
+    FQuat rot = frame.GetRotation();
     FHitResult hit = FHitResult();
     bool occup;
-    if(octreeSize == Octree::OctreeMin || actorName != ""){
-        occup = World->SweepSingleByChannel(hit, center, center+FVector(0.01, 0.01, 0.01), FQuat::Identity, ECollisionChannel::ECC_WorldStatic, FCollisionShape::MakeBox(FVector(octreeSize/2)), params);
+    if((fill && octreeSize == octreeMin) || actorName != ""){
+        occup = World->SweepSingleByChannel(hit, at, at+FVector(0.01, 0.01, 0.01), rot, ECollisionChannel::ECC_WorldStatic, FCollisionShape::MakeBox(FVector(octreeSize/2)), params);
     }
     else{
-        occup = World->OverlapBlockingTestByChannel(center, FQuat::Identity, ECollisionChannel::ECC_WorldStatic, FCollisionShape::MakeBox(FVector(octreeSize/2)), params);
+        occup = World->OverlapBlockingTestByChannel(at, rot, ECollisionChannel::ECC_WorldStatic, FCollisionShape::MakeBox(FVector(octreeSize/2)), params);
     }
 
     // if we're making for an actor, make sure we're hitting it and not something else
@@ -157,11 +414,11 @@ Octree* Octree::makeOctree(FVector center, float octreeSize, float octreeMin, FS
         float distToCorner = octreeSize/2 - cornerSize;
         for(FVector side : sides){
             if(!full) break;
-            full = World->OverlapBlockingTestByChannel(center+(side*distToCorner), FQuat::Identity, ECollisionChannel::ECC_WorldStatic, FCollisionShape::MakeBox(FVector(cornerSize)), params);
+            full = World->OverlapBlockingTestByChannel(frame.TransformPosition(center+(side*distToCorner)), rot, ECollisionChannel::ECC_WorldStatic, FCollisionShape::MakeBox(FVector(cornerSize)), params);
         }
         for(FVector corner : corners){
             if(!full) break;
-            full = World->OverlapBlockingTestByChannel(center+(corner*distToCorner), FQuat::Identity, ECollisionChannel::ECC_WorldStatic, FCollisionShape::MakeBox(FVector(cornerSize)), params);
+            full = World->OverlapBlockingTestByChannel(frame.TransformPosition(center+(corner*distToCorner)), rot, ECollisionChannel::ECC_WorldStatic, FCollisionShape::MakeBox(FVector(cornerSize)), params);
         }
 
         if(!full){
@@ -171,23 +428,24 @@ Octree* Octree::makeOctree(FVector center, float octreeSize, float octreeMin, FS
             // if it still needs to be broken down, iterate through corners
             if(octreeSize > octreeMin){
                 for(FVector off : corners){
-                    Octree* l = makeOctree(center+(off*octreeSize/4), octreeSize/2, octreeMin, actorName);
+                    Octree* l = makeOctree(ctx, params, frame, center+(off*octreeSize/4), octreeSize/2, octreeMin, actorName, fill);
                     if(l) child->leaves.Add(l);
                 }
             }
 
             // if it's all the way broken down, save the normal
-            else if(octreeSize == Octree::OctreeMin){
-                child->normal = hit.Normal;
+            else if(fill){
+                child->normal = frame.InverseTransformVectorNoScale(hit.Normal);
 
                 // Get material (there is tons of these!)
-                child->fillMaterialProperties(getMaterialName(hit));
+                child->fillMaterialProperties(ctx, getMaterialName(hit));
 
                 // clean normal
                 if(isnan(child->normal.X)) child->normal.X = sign(child->normal.X); 
                 if(isnan(child->normal.Y)) child->normal.Y = sign(child->normal.Y); 
                 if(isnan(child->normal.Z)) child->normal.Z = sign(child->normal.Z); 
                 if(hit.Normal.ContainsNaN()){
+                    OctreeStats::nanNormal();
                     UE_LOG(LogHolodeck, Warning, TEXT("Found position: %s"), *child->loc.ToString());
                     UE_LOG(LogHolodeck, Warning, TEXT("Found nan: %s"), *child->normal.ToString());
                 }
@@ -203,6 +461,45 @@ Octree* Octree::makeOctree(FVector center, float octreeSize, float octreeMin, FS
     return nullptr;
 }
 
+Octree* Octree::makeAgentOctree(OctreeContext& ctx, AActor* actor, const FString& mesh, const FBox& bounds, float octreeMin){
+    // Smallest cube the mesh fits in
+    float octreeSize = octreeMin;
+    while(octreeSize < bounds.GetExtent().GetAbsMax()*2){
+        octreeSize *= 2;
+    }
+
+    // Named by the mesh and sizes the same way the environment's folders are
+    FString key = FPaths::MakeValidFileName(mesh.Replace(TEXT("/"), TEXT("_")), '_') + "_min" + FString::FromInt((int)octreeMin) + "_max" + FString::FromInt((int)octreeSize);
+    Octree* shared = ctx.findAgentOctree(key);
+    if(shared) return shared;
+    HOLODECK_PROFILE_ZONE("Octree::makeAgentOctree");
+
+    Octree* tree = new Octree(bounds.GetCenter(), octreeSize, ctx.agentCacheDir() + "/" + key + ".oct");
+    tree->makeTill = octreeMin;
+    tree->isAgent = true;
+    FFileManagerGeneric().MakeDirectory(*ctx.agentCacheDir(), true);
+
+    // Only one process builds it, the others wait and load what it saved
+    TileLock lock(tree->file + ".lock");
+    if(!tree->loadPacked(ctx)){
+        UE_LOG(LogHolodeck, Log, TEXT("Octree::Making agent octree %s"), *key);
+
+        // Probe the actor where it is, but in its own frame so the octree fits every actor with its mesh
+        FCollisionQueryParams params = OctreeContext::agentParams();
+        FTransform frame(actor->GetActorQuat(), actor->GetActorLocation());
+        Octree* made = makeOctree(ctx, params, frame, tree->loc, octreeSize, octreeMin, actor->GetName(), true);
+        if(made == nullptr){
+            delete tree;
+            return nullptr;
+        }
+        tree->leaves = MoveTemp(made->leaves);
+        delete made;
+        tree->toPacked();
+    }
+
+    return ctx.addAgentOctree(key, tree);
+}
+
 int Octree::numLeaves(){
     if(leaves.Num()==0){
         return 1;
@@ -220,28 +517,24 @@ void Octree::toJson(){
     // make directory
     FFileManagerGeneric().MakeDirectory(*FPaths::GetPath(file), true);
 
-    // calculate buffer size and make writer
+    // How long the json is depends on how many digits the numbers take, so grow the buffer till it fits
     int num = numLeaves()*100;
-    char* buffer = new char[num]();
-    gason::JSonBuilder doc(buffer, num-1);
-
-    // fill in buffer
-    toJson(doc);
+    while(true){
+        char* buffer = new char[num]();
+        gason::JSonBuilder doc(buffer, num-1);
+        toJson(doc, tile ? makeTill : 0);
 
-    if( doc.isBufferAdequate() ){
-        // String to file
-        FILE* fp = fopen(TCHAR_TO_ANSI(*file), "w+t");
-        fwrite(buffer, strlen(buffer), 1, fp);
-        fclose(fp);
-    }
-    else{
-        UE_LOG(LogHolodeck, Warning, TEXT("Octree: The buffer is too small and the output json for file %s is not valid."), *file);
+        if( doc.isBufferAdequate() ){
+            writeTile(file, buffer, strlen(buffer));
+            delete[] buffer;
+            return;
+        }
+        delete[] buffer;
+        num *= 2;
     }
-
-    delete[] buffer;
 }
 
-void Octree::toJson(gason::JSonBuilder& doc){
+void Octree::toJson(gason::JSonBuilder& doc, float leafSize){
     doc.startObject()
         .startArray("p")
             .addValue((int)loc[0])
@@ -252,11 +545,11 @@ void Octree::toJson(gason::JSonBuilder& doc){
     if(leaves.Num() != 0){
         doc.startArray("l");
         for(Octree* l : leaves){
-            l->toJson(doc);
+            l->toJson(doc, leafSize);
         }
         doc.endArray();
     }
-    if(size == OctreeMin){
+    if(size == leafSize){
         doc.startArray("n")
                 .addValue(normal[0])
                 .addValue(normal[1])
@@ -268,48 +561,454 @@ void Octree::toJson(gason::JSonBuilder& doc){
     doc.endObject();
 }
 
-void Octree::load(){
+void Octree::load(OctreeContext& ctx){
+    if(index){
+        if(!indexed) loadIndex(ctx);
+        return;
+    }
+
     // if it's not already loaded
-    if(leaves.Num() == 0){
-        // if it's been saved as a json, load it
-        if(FPaths::FileExists(file)){
-            // UE_LOG(LogHolodeck, Log, TEXT("Loading Octree %s"), *file);
-            // load file to a string
-            gason::JsonAllocator allocator;
-            std::ifstream t(TCHAR_TO_ANSI(*file));
-            std::string str((std::istreambuf_iterator<char>(t)),
-                            std::istreambuf_iterator<char>());
-            char* source = &str[0];
-
-            // process json
-            char* endptr;
-            gason::JsonValue json;
-            int status = gason::jsonParse(source, &endptr, &json, allocator);
-
-            // load in leaves
-            for(gason::JsonNode* o : json){
-                if(o->key[0] == 'l'){
-                    for(gason::JsonNode* l : o->value){
-                        loadJson(l->value, leaves, size/2);
-                    }
-                }
+    if(leaves.Num() == 0 && dag == nullptr && shared == nullptr){
+        HOLODECK_PROFILE_ZONE("Octree::load");
+        // if another instance has it loaded, use theirs
+        if(OctreeTileCache::load(this)){
+            if(tile) OctreeStats::tileLoaded(this, OctreeStats::SharedCache);
+            return;
+        }
+
+        // if it's been saved, load it
+        if(loadFile(ctx, false)){
+            OctreeTileCache::store(this);
+            if(tile) OctreeStats::tileLoaded(this, OctreeStats::Disk);
+            return;
+        }
+
+        // Otherwise build it & save for later. Only one process builds a tile at a time,
+        // the others wait here and then load what it saved
+        TileLock lock(file + ".lock");
+        if(loadFile(ctx, true)){
+            OctreeTileCache::store(this);
+            if(tile) OctreeStats::tileLoaded(this, OctreeStats::Disk);
+            return;
+        }
+
+        // Tiles older versions saved as json are converted instead of built again
+        if(isTile() && loadJson(ctx, FPaths::ChangeExtension(file, "json"))){
+            save();
+            OctreeTileCache::store(this);
+            OctreeStats::tileLoaded(this, OctreeStats::Converted);
+            return;
+        }
+
+        // Or merge it from a finer cache, which is much quicker than building it
+        if(isTile() && deriveFromFiner(ctx)){
+            save();
+            OctreeTileCache::store(this);
+            OctreeStats::tileLoaded(this, OctreeStats::Derived);
+            return;
+        }
+
+        // UE_LOG(LogHolodeck, Log, TEXT("Making Octree %s"), *file);
+        if(tile) OctreeStats::startBuild();
+        build(ctx);
+        if(tile) OctreeStats::finishBuild(this);
+        save();
+        OctreeTileCache::store(this);
+        if(tile) OctreeStats::tileLoaded(this, OctreeStats::Built);
+    }
+}
+
+void Octree::build(OctreeContext& ctx){
+    HOLODECK_PROFILE_ZONE("Octree::makeOctree");
+
+    // Landscapes in the tile are filled from their heights, which is much quicker than probing them
+    TArray<const OctreeContext::Heightfield*> heightfields;
+    if(tile){
+        FBox box(loc - FVector(size/2), loc + FVector(size/2));
+        for(const OctreeContext::Heightfield& heightfield : ctx.Heightfields){
+            if(heightfield.bounds.Intersect(box)) heightfields.Add(&heightfield);
+        }
+    }
+
+    // So the rest only has to probe whatever's sitting on them
+    FCollisionQueryParams params = *ctx.getParams();
+    for(const OctreeContext::Heightfield* heightfield : heightfields){
+        params.AddIgnoredActor(heightfield->landscape);
+    }
+    for(FVector off : corners){
+        Octree* l = makeOctree(ctx, params, FTransform::Identity, loc+(off*size/4), size/2, makeTill, "", tile);
+        if(l) leaves.Add(l);
+    }
+
+    // Meshes resting on the landscape keep their leaves where the two meet
+    for(const OctreeContext::Heightfield* heightfield : heightfields){
+        fillFromHeightfield(ctx, *heightfield);
+    }
+}
+
+void Octree::fillFromHeightfield(OctreeContext& ctx, const OctreeContext::Heightfield& heightfield){
+    HOLODECK_PROFILE_ZONE("Octree::fillFromHeightfield");
+    ALandscapeProxy* landscape = heightfield.landscape;
+    FBox box(loc - FVector(size/2), loc + FVector(size/2));
+
+    // Landscapes are straight between their vertices, so they're only sampled there. Go one
+    // past the tile on each side so every leaf has heights around it
+    FVector origin = landscape->GetActorLocation();
+    FVector scale = landscape->GetActorScale3D();
+    int32 x0 = FMath::FloorToInt((box.Min.X - origin.X) / scale.X);
+    int32 y0 = FMath::FloorToInt((box.Min.Y - origin.Y) / scale.Y);
+    int32 nx = FMath::CeilToInt((box.Max.X - origin.X) / scale.X) - x0 + 1;
+    int32 ny = FMath::CeilToInt((box.Max.Y - origin.Y) / scale.Y) - y0 + 1;
+
+    // Holes and anything off the edge stay NaN
+    TArray<float> heights;
+    heights.Init(NAN, nx*ny);
+    FCollisionQueryParams params(FName("OctreeHeightfield"), false);
+    bool any = false;
+    for(int32 j = 0; j < ny; j++){
+        for(int32 i = 0; i < nx; i++){
+            float x = origin.X + (x0 + i)*scale.X;
+            float y = origin.Y + (y0 + j)*scale.Y;
+            FHitResult hit;
+            if(landscape->ActorLineTraceSingle(hit, FVector(x, y, heightfield.bounds.Max.Z + 1), FVector(x, y, heightfield.bounds.Min.Z - 1), ECC_WorldStatic, params)){
+                heights[j*nx + i] = hit.ImpactPoint.Z;
+                any = true;
             }
         }
+    }
+    if(!any) return;
 
-        // Otherwise build it & save for later
-        else{
-            // UE_LOG(LogHolodeck, Log, TEXT("Making Octree %s"), *file);
-            for(FVector off : corners){
-                Octree* l = makeOctree(loc+(off*size/4), size/2, makeTill);
-                if(l) leaves.Add(l);
+    auto heightAt = [&](float x, float y){
+        float fx = (x - origin.X) / scale.X - x0;
+        float fy = (y - origin.Y) / scale.Y - y0;
+        int32 i = FMath::Clamp(FMath::FloorToInt(fx), 0, nx - 2);
+        int32 j = FMath::Clamp(FMath::FloorToInt(fy), 0, ny - 2);
+        return FMath::BiLerp(heights[j*nx + i], heights[j*nx + i + 1], heights[(j + 1)*nx + i], heights[(j + 1)*nx + i + 1], fx - i, fy - j);
+    };
+
+    FString mat = landscape->LandscapeMaterial != nullptr ? landscape->LandscapeMaterial->GetFName().ToString() : "MaterialNotFound";
+    float impedance = ctx.getImpedance(mat);
+
+    // A leaf is on the surface if the heights across it cross its bottom or top
+    float leafSize = makeTill;
+    int32 n = FMath::RoundToInt(size / leafSize);
+    for(int32 j = 0; j < n; j++){
+        for(int32 i = 0; i < n; i++){
+            float x = box.Min.X + (i + .5f)*leafSize;
+            float y = box.Min.Y + (j + .5f)*leafSize;
+            float h00 = heightAt(x - leafSize/2, y - leafSize/2);
+            float h10 = heightAt(x + leafSize/2, y - leafSize/2);
+            float h01 = heightAt(x - leafSize/2, y + leafSize/2);
+            float h11 = heightAt(x + leafSize/2, y + leafSize/2);
+            if(FMath::IsNaN(h00 + h10 + h01 + h11)) continue;
+
+            float lo = FMath::Min(FMath::Min(h00, h10), FMath::Min(h01, h11));
+            float hi = FMath::Max(FMath::Max(h00, h10), FMath::Max(h01, h11));
+            int32 k0 = FMath::Max(0, FMath::FloorToInt((lo - box.Min.Z) / leafSize));
+            int32 k1 = FMath::Min(n - 1, FMath::FloorToInt((hi - box.Min.Z) / leafSize));
+            if(k0 > k1) continue;
+
+            // Slope across the leaf
+            FVector normal = FVector(((h00 + h01) - (h10 + h11)) / (2*leafSize), ((h00 + h10) - (h01 + h11)) / (2*leafSize), 1).GetSafeNormal();
+            for(int32 k = k0; k <= k1; k++){
+                Octree* leaf = addLeaf(FVector(x, y, box.Min.Z + (k + .5f)*leafSize), leafSize);
+                if(leaf == nullptr) continue;
+                leaf->normal = normal;
+                leaf->material = mat;
+                leaf->z = impedance;
+            }
+        }
+    }
+}
+
+Octree* Octree::addLeaf(const FVector& center, float leafSize){
+    Octree* node = this;
+    while(node->size > leafSize){
+        int32 slot = OctreeCodec::slotOf(center - node->loc);
+        Octree* child = nullptr;
+        for(Octree* l : node->leaves){
+            if(OctreeCodec::slotOf(l->loc - node->loc) == slot){
+                child = l;
+                break;
+            }
+        }
+
+        if(child == nullptr){
+            child = new Octree(node->loc + OctreeCodec::cornerOf(slot)*node->size/4, node->size/2);
+            node->leaves.Add(child);
+            if(child->size == leafSize) return child;
+        }
+        else if(child->size == leafSize){
+            return nullptr;
+        }
+        node = child;
+    }
+    return nullptr;
+}
+
+bool Octree::loadFile(OctreeContext& ctx, bool quarantineCorrupt){
+    if(!FPaths::FileExists(file)) return false;
+
+    // UE_LOG(LogHolodeck, Log, TEXT("Loading Octree %s"), *file);
+    bool loaded = isDagTile() ? loadDag(ctx) : isTile() ? loadPacked(ctx) : loadJson(ctx, file);
+    if(!loaded && quarantineCorrupt){
+        UE_LOG(LogHolodeck, Warning, TEXT("Octree: %s is partial or corrupt, moving it to %s.corrupt and building it again."), *file, *file);
+        replaceFile(file, file + ".corrupt");
+    }
+    return loaded;
+}
+
+bool Octree::loadJson(OctreeContext& ctx, const FString& path){
+    if(!FPaths::FileExists(path)) return false;
+
+    // load file to a string
+    gason::JsonAllocator allocator;
+    std::ifstream t(TCHAR_TO_ANSI(*path));
+    std::string str((std::istreambuf_iterator<char>(t)),
+                    std::istreambuf_iterator<char>());
+
+    // process json, anything cut off or mangled won't parse to an object
+    char* endptr;
+    gason::JsonValue json;
+    int status = str.empty() ? gason::JSON_PARSE_BREAKING_BAD : gason::jsonParse(&str[0], &endptr, &json, allocator);
+    if(status != gason::JSON_PARSE_OK || !json.isObject()) return false;
+
+    // load in leaves
+    for(gason::JsonNode* o : json){
+        if(o->key[0] == 'l'){
+            for(gason::JsonNode* l : o->value){
+                loadJson(ctx, l->value, leaves, size/2);
+            }
+        }
+    }
+    return true;
+}
+
+void Octree::save(){
+    if(isDagTile()) toDag();
+    else if(isTile()) toPacked();
+    else toJson();
+}
+
+void Octree::toPacked(){
+    HOLODECK_PROFILE_ZONE("Octree::toPacked");
+    FFileManagerGeneric().MakeDirectory(*FPaths::GetPath(file), true);
+    TArray<uint8> bytes;
+    OctreeCodec::encode(this, bytes);
+    writeTile(file, bytes.GetData(), bytes.Num());
+}
+
+bool Octree::loadPacked(OctreeContext& ctx){
+    TArray<uint8> bytes;
+    return FFileHelper::LoadFileToArray(bytes, *file) && OctreeCodec::decode(bytes, this, makeTill, ctx);
+}
+
+bool Octree::deriveFromFiner(OctreeContext& ctx){
+    const OctreeContext::Resolution& res = ctx.resolution(makeTill);
+    if(res.finerDir.IsEmpty()) return false;
+    HOLODECK_PROFILE_ZONE("Octree::deriveFromFiner");
+    TMap<FString, TBitArray<>> seen;
+    bool known;
+
+    // The finer tile this one's in if those are the same size or bigger
+    if(res.finerMax >= size){
+        Octree finer(nodeAt(ctx, res.root, res.finerMax, loc), res.finerMax);
+        if(!finerTilePresent(ctx, res, finer.loc, seen, known)){
+            // The finer cache has nothing here, so neither do we
+            return known;
+        }
+        if(!loadFiner(ctx, &finer, res)) return false;
+
+        // Walk down to this tile
+        Octree* node = &finer;
+        while(node->size > size){
+            int32 slot = OctreeCodec::slotOf(loc - node->loc);
+            Octree* next = nullptr;
+            for(Octree* l : node->leaves){
+                if(OctreeCodec::slotOf(l->loc - node->loc) == slot) next = l;
+            }
+            if(next == nullptr) return true;
+            node = next;
+        }
+        leaves = MoveTemp(node->leaves);
+    }
+    // Or the finer tiles in it if those are smaller
+    else{
+        Octree node(loc, size);
+        int32 n = FMath::Cube(FMath::RoundToInt(size / res.finerMax));
+        for(int32 i = 0; i < n; i++){
+            FVector at = regionTile(loc, size, res.finerMax, i);
+            if(finerTilePresent(ctx, res, at, seen, known)){
+                node.addLeaf(at, res.finerMax);
             }
-            toJson();
+            else if(!known){
+                return false;
+            }
+        }
+        if(!loadFiner(ctx, &node, res)) return false;
+        leaves = MoveTemp(node.leaves);
+    }
+
+    for(int32 i = leaves.Num() - 1; i >= 0; i--){
+        if(!coarsen(ctx, leaves[i], res)){
+            delete leaves[i];
+            leaves.RemoveAt(i);
+        }
+    }
+    return true;
+}
+
+bool Octree::finerTilePresent(OctreeContext& ctx, const OctreeContext::Resolution& res, const FVector& loc, TMap<FString, TBitArray<>>& seen, bool& known){
+    float finerRegion = regionSize(res.finerMax, res.root);
+    FVector regionLoc = nodeAt(ctx, res.root, finerRegion, loc);
+    FString path = regionFile(res.finerDir, regionLoc);
+
+    TBitArray<>* bits = seen.Find(path);
+    if(bits == nullptr){
+        TBitArray<> loaded;
+        if(!loadRegion(path, FMath::Cube(FMath::RoundToInt(finerRegion / res.finerMax)), loaded)){
+            known = false;
+            return false;
+        }
+        bits = &seen.Add(path, MoveTemp(loaded));
+    }
+    known = true;
+    return (*bits)[regionBit(regionLoc, finerRegion, res.finerMax, loc)];
+}
+
+bool Octree::loadFiner(OctreeContext& ctx, Octree* tree, const OctreeContext::Resolution& res){
+    if(tree->size > res.finerMax){
+        for(Octree* l : tree->leaves){
+            if(!loadFiner(ctx, l, res)) return false;
+        }
+        return true;
+    }
+    // Already loaded, or part of a tile that is
+    if(tree->size < res.finerMax || tree->leaves.Num() != 0) return true;
+
+    TArray<uint8> bytes;
+    FString path = res.finerDir + "/" + tileName(tree->loc) + ".oct";
+    return FFileHelper::LoadFileToArray(bytes, *path, FILEREAD_Silent) && OctreeCodec::decode(bytes, tree, res.finerMin, ctx);
+}
+
+bool Octree::coarsen(OctreeContext& ctx, Octree* tree, const OctreeContext::Resolution& res){
+    if(tree->size > res.min){
+        for(int32 i = tree->leaves.Num() - 1; i >= 0; i--){
+            if(!coarsen(ctx, tree->leaves[i], res)){
+                delete tree->leaves[i];
+                tree->leaves.RemoveAt(i);
+            }
+        }
+        return true;
+    }
+
+    // Add up the finer leaves under it
+    FVector normal = FVector::ZeroVector;
+    TMap<FString, int32> counts;
+    std::function<void(Octree*)> gather;
+    gather = [&res, &normal, &counts, &gather](Octree* t){
+        if(t->size == res.finerMin){
+            normal += t->normal;
+            counts.FindOrAdd(t->material)++;
         }
+        for(Octree* l : t->leaves) gather(l);
+    };
+    gather(tree);
+    for(Octree* l : tree->leaves) delete l;
+    tree->leaves.Reset();
+    if(counts.Num() == 0) return false;
+
+    // It faces the average way, and is made of whatever most of it is made of
+    tree->normal = normal.GetSafeNormal();
+    if(tree->normal.IsZero()) tree->normal = FVector::UpVector;
+    counts.ValueSort(TGreater<int32>());
+    tree->fillMaterialProperties(ctx, counts.CreateConstIterator().Key());
+    return true;
+}
 
+int Octree::deriveAll(OctreeContext& ctx){
+    HOLODECK_PROFILE_ZONE("Octree::deriveAll");
+    const OctreeContext::Resolution& res = ctx.resolution(ctx.OctreeMin);
+    if(res.finerDir.IsEmpty()){
+        UE_LOG(LogHolodeck, Warning, TEXT("Octree:: There's no finer octree cache to derive from."));
+        return 0;
     }
+
+    // Every tile of ours that has a finer tile with something in it, from the finer cache's regions
+    float finerRegion = regionSize(res.finerMax, res.root);
+    int32 count = FMath::Cube(FMath::RoundToInt(finerRegion / res.finerMax));
+    TArray<FString> files;
+    IFileManager::Get().FindFiles(files, *(res.finerDir + "/regions/*.reg"), true, false);
+
+    TMap<FString, Octree*> found;
+    auto addTile = [&](const FVector& at){
+        FVector center = nodeAt(ctx, res.root, res.max, at);
+        FString file = res.dir + "/" + tileName(center) + (useDag ? ".dag" : ".oct");
+        if(found.Contains(file) || FPaths::FileExists(file)) return;
+        Octree* tile = new Octree(center, res.max, file);
+        tile->tile = true;
+        tile->makeTill = res.min;
+        found.Add(file, tile);
+    };
+    for(const FString& name : files){
+        // Named by their center, rounded, which is still well inside them
+        TArray<FString> parts;
+        FPaths::GetBaseFilename(name).ParseIntoArray(parts, TEXT("_"));
+        if(parts.Num() != 3) continue;
+        FVector regionLoc = nodeAt(ctx, res.root, finerRegion, FVector(FCString::Atof(*parts[0]), FCString::Atof(*parts[1]), FCString::Atof(*parts[2])));
+
+        TBitArray<> bits;
+        if(!loadRegion(res.finerDir + "/regions/" + name, count, bits)) continue;
+        for(TConstSetBitIterator<> it(bits); it; ++it){
+            FVector finer = regionTile(regionLoc, finerRegion, res.finerMax, it.GetIndex());
+            if(res.max >= res.finerMax){
+                addTile(finer);
+            }
+            else{
+                int32 n = FMath::Cube(FMath::RoundToInt(res.finerMax / res.max));
+                for(int32 i = 0; i < n; i++) addTile(regionTile(finer, res.finerMax, res.max, i));
+            }
+        }
+    }
+    TArray<Octree*> tiles;
+    found.GenerateValueArray(tiles);
+
+    // Merging doesn't touch the world, so the tiles can all be done at once
+    std::atomic<int32> made{ 0 };
+    ParallelFor(tiles.Num(), [&](int32 i){
+        Octree* tile = tiles[i];
+        TileLock lock(tile->file + ".lock");
+        if(!FPaths::FileExists(tile->file) && tile->deriveFromFiner(ctx)){
+            tile->save();
+            ++made;
+        }
+        delete tile;
+    });
+
+    UE_LOG(LogHolodeck, Log, TEXT("Octree:: Derived %d of %d missing tiles from %s"), made.load(), tiles.Num(), *res.finerDir);
+    return made;
 }
 
-void Octree::loadJson(gason::JsonValue& json, TArray<Octree*>& parent, float size){
+void Octree::toDag(){
+    HOLODECK_PROFILE_ZONE("Octree::toDag");
+    dag = OctreeDag::fromTree(this);
+    for(Octree* leaf : leaves) delete leaf;
+    leaves.Reset();
+
+    FFileManagerGeneric().MakeDirectory(*FPaths::GetPath(file), true);
+    TArray<uint8> bytes;
+    dag->serialize(bytes);
+    writeTile(file, bytes.GetData(), bytes.Num());
+}
+
+bool Octree::loadDag(OctreeContext& ctx){
+    TArray<uint8> bytes;
+    if(!FFileHelper::LoadFileToArray(bytes, *file)) return false;
+    dag = OctreeDag::deserialize(bytes, FMath::RoundToInt(size / makeTill), ctx);
+    return dag != nullptr;
+}
+
+void Octree::loadJson(OctreeContext& ctx, gason::JsonValue& json, TArray<Octree*>& parent, float size){
     Octree* child = new Octree;
     for(gason::JsonNode* o : json){
         if(o->key[0] == 'p'){
@@ -318,7 +1017,7 @@ void Octree::loadJson(gason::JsonValue& json, TArray<Octree*>& parent, float siz
         }
         if(o->key[0] == 'l'){
             for(gason::JsonNode* l : o->value){
-                loadJson(l->value, child->leaves, size/2);
+                loadJson(ctx, l->value, child->leaves, size/2);
             }
         }
         if(o->key[0] == 'n'){
@@ -326,7 +1025,7 @@ void Octree::loadJson(gason::JsonValue& json, TArray<Octree*>& parent, float siz
             child->normal = FVector(arr->value.toNumber(), arr->next->value.toNumber(), arr->next->next->value.toNumber());
         }
         if(o->key[0] == 'm'){
-            child->fillMaterialProperties( FString(o->value.toString()) );
+            child->fillMaterialProperties(ctx, FString(o->value.toString()) );
         }
     }
     child->size = size;
@@ -334,40 +1033,36 @@ void Octree::loadJson(gason::JsonValue& json, TArray<Octree*>& parent, float siz
 }
 
 void Octree::unload(){
-    if(!isAgent && leaves.Num() != 0){
+    // The index is made again from the region bitmaps the next time it's needed
+    if(index){
+        for(Octree* leaf : leaves) delete leaf;
+        leaves.Reset();
+        indexed = false;
+        return;
+    }
+
+    if(!isAgent && (leaves.Num() != 0 || dag != nullptr || shared != nullptr)){
         // if we need to unload children
-        if(size > Octree::OctreeMax){
+        if(!tile){
             for(Octree* leaf : leaves) leaf->unload();
         }
 
         // if we need to unload this one
-        else if(size == Octree::OctreeMax){
+        else{
             // UE_LOG(LogHolodeck, Log, TEXT("Unloading Octree %s"), *file);
+            OctreeStats::tileUnloaded(this);
+            OctreeTileCache::release(this);
             for(Octree* leaf : leaves) delete leaf;
             leaves.Reset();
+            delete dag;
+            dag = nullptr;
         }
     }
 }
 
-void Octree::fillMaterialProperties(FString mat){
+void Octree::fillMaterialProperties(OctreeContext& ctx, FString mat){
     material = mat;
-    float matProp;
-    bool found = materials.Find(material, matProp);
-    if(!found){
-        UE_LOG(LogHolodeck, Warning, TEXT("Missing material information for %s, adding in blank row to csv"), *this->material);
-
-        // Add default line to material file to fill in later
-        FString filePath = FPaths::ProjectDir() + "../../materials.csv";
-        FString line = "\n" + material + ", 10000, 10000";
-        FFileHelper::SaveStringToFile(line, *filePath, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), EFileWrite::FILEWRITE_Append);
-
-        // Default to something really high to get full reflection for this time
-        z = 10000*10000;
-        materials.Add(material, z);
-    }
-    else{
-        z = matProp;
-    }
+    z = ctx.getImpedance(material);
 }
 
 FString Octree::getMaterialName(FHitResult hit){
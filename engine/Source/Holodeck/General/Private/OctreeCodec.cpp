@@ -0,0 +1,185 @@
+// MIT License (c) 2021 BYU FRoStLab see LICENSE file
+
+#include "Holodeck.h"
+#include "OctreeCodec.h"
+#include "Octree.h"
+#include "OctreeContext.h"
+#include "Misc/Compression.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+static const uint32 TileMagic = 0x4C49544F;  // "OTIL"
+static const uint32 TileVersion = 1;
+
+// Flags in the header
+static const uint32 TileCompressed = 1;
+static const int32 HeaderSize = 4*sizeof(uint32);
+
+bool OctreeCodec::compress = false;
+
+void OctreeCodec::encodeNormal(const FVector& normal, uint16& u, uint16& v){
+    // Project onto the octahedron, folding the bottom half out over the corners
+    float sum = FMath::Abs(normal.X) + FMath::Abs(normal.Y) + FMath::Abs(normal.Z);
+    float x = sum > 0 ? normal.X / sum : 0;
+    float y = sum > 0 ? normal.Y / sum : 0;
+    if(normal.Z < 0){
+        float folded = (1 - FMath::Abs(y)) * (x >= 0 ? 1 : -1);
+        y = (1 - FMath::Abs(x)) * (y >= 0 ? 1 : -1);
+        x = folded;
+    }
+    u = (uint16)FMath::RoundToInt((FMath::Clamp(x, -1.0f, 1.0f) * .5f + .5f) * 65535);
+    v = (uint16)FMath::RoundToInt((FMath::Clamp(y, -1.0f, 1.0f) * .5f + .5f) * 65535);
+}
+
+FVector OctreeCodec::decodeNormal(uint16 u, uint16 v){
+    float x = u / 65535.0f * 2 - 1;
+    float y = v / 65535.0f * 2 - 1;
+    float z = 1 - FMath::Abs(x) - FMath::Abs(y);
+    if(z < 0){
+        float unfolded = (1 - FMath::Abs(y)) * (x >= 0 ? 1 : -1);
+        y = (1 - FMath::Abs(x)) * (y >= 0 ? 1 : -1);
+        x = unfolded;
+    }
+    return FVector(x, y, z).GetSafeNormal();
+}
+
+void OctreeCodec::encode(Octree* tile, TArray<uint8>& bytes){
+    Streams streams;
+    streams.leafSize = tile->makeTill;
+    TMap<FString, uint16> materialIds;
+    encode(tile, streams, materialIds);
+
+    TArray<uint8> raw;
+    FMemoryWriter ar(raw);
+    ar << streams.materials << streams.masks << streams.normals << streams.materialIds;
+    pack(TileMagic, TileVersion, raw, bytes);
+}
+
+void OctreeCodec::encode(Octree* tree, Streams& streams, TMap<FString, uint16>& materialIds){
+    if(tree->size == streams.leafSize){
+        uint16 u, v;
+        encodeNormal(tree->normal, u, v);
+        streams.normals.Add((uint16)(u - streams.u));
+        streams.normals.Add((uint16)(v - streams.v));
+        streams.u = u;
+        streams.v = v;
+
+        uint16* material = materialIds.Find(tree->material);
+        if(material == nullptr){
+            material = &materialIds.Add(tree->material, (uint16)streams.materials.Num());
+            streams.materials.Add(tree->material);
+        }
+        streams.materialIds.Add(*material);
+        return;
+    }
+
+    Octree* children[8] = {};
+    uint8 mask = 0;
+    for(Octree* l : tree->leaves){
+        int32 slot = slotOf(l->loc - tree->loc);
+        mask |= 1 << slot;
+        children[slot] = l;
+    }
+    streams.masks.Add(mask);
+    for(Octree* child : children){
+        if(child) encode(child, streams, materialIds);
+    }
+}
+
+bool OctreeCodec::decode(const TArray<uint8>& bytes, Octree* tile, float leafSize, OctreeContext& ctx){
+    TArray<uint8> raw;
+    if(!unpack(TileMagic, TileVersion, bytes, raw)) return false;
+
+    Streams streams;
+    streams.leafSize = leafSize;
+    FMemoryReader ar(raw);
+    ar << streams.materials << streams.masks << streams.normals << streams.materialIds;
+    if(ar.IsError() || !ar.AtEnd() || streams.normals.Num() != 2*streams.materialIds.Num()) return false;
+
+    // Look each material up once instead of for every leaf
+    TArray<float> impedance;
+    for(const FString& material : streams.materials){
+        impedance.Add(ctx.getImpedance(material));
+    }
+
+    // Anything cut off or mangled runs out of masks or leaves, or has some left over
+    if(!decode(tile, streams, impedance) || streams.nextMask != streams.masks.Num() || streams.nextLeaf != streams.materialIds.Num()){
+        for(Octree* leaf : tile->leaves) delete leaf;
+        tile->leaves.Reset();
+        return false;
+    }
+    return true;
+}
+
+bool OctreeCodec::decode(Octree* tree, Streams& streams, const TArray<float>& impedance){
+    if(streams.nextMask >= streams.masks.Num()) return false;
+    uint8 mask = streams.masks[streams.nextMask++];
+
+    float childSize = tree->size/2;
+    tree->leaves.Reserve(FMath::CountBits(mask));
+    for(int32 slot = 0; slot < 8; slot++){
+        if(!(mask & 1 << slot)) continue;
+        Octree* child = new Octree(tree->loc + cornerOf(slot)*tree->size/4, childSize);
+        tree->leaves.Add(child);
+
+        if(childSize != streams.leafSize){
+            if(!decode(child, streams, impedance)) return false;
+            continue;
+        }
+
+        int32 leaf = streams.nextLeaf++;
+        if(leaf >= streams.materialIds.Num()) return false;
+        uint16 material = streams.materialIds[leaf];
+        if(material >= streams.materials.Num()) return false;
+
+        streams.u += streams.normals[2*leaf];
+        streams.v += streams.normals[2*leaf + 1];
+        child->normal = decodeNormal(streams.u, streams.v);
+        child->material = streams.materials[material];
+        child->z = impedance[material];
+    }
+    return true;
+}
+
+void OctreeCodec::pack(uint32 magic, uint32 version, const TArray<uint8>& raw, TArray<uint8>& bytes){
+    uint32 flags = 0;
+    uint32 rawSize = raw.Num();
+    bytes.SetNumUninitialized(HeaderSize);
+
+    if(compress){
+        int32 size = FCompression::CompressMemoryBound(NAME_Zlib, raw.Num());
+        bytes.SetNumUninitialized(HeaderSize + size);
+        if(FCompression::CompressMemory(NAME_Zlib, bytes.GetData() + HeaderSize, size, raw.GetData(), raw.Num())){
+            bytes.SetNum(HeaderSize + size, false);
+            flags |= TileCompressed;
+        }
+        else{
+            bytes.SetNum(HeaderSize, false);
+        }
+    }
+    if(!(flags & TileCompressed)){
+        bytes.Append(raw);
+    }
+
+    FMemoryWriter ar(bytes);
+    ar << magic << version << flags << rawSize;
+}
+
+bool OctreeCodec::unpack(uint32 magic, uint32 version, const TArray<uint8>& bytes, TArray<uint8>& raw){
+    if(bytes.Num() < HeaderSize) return false;
+
+    uint32 fileMagic, fileVersion, flags, rawSize;
+    FMemoryReader ar(bytes);
+    ar << fileMagic << fileVersion << flags << rawSize;
+    if(fileMagic != magic || fileVersion != version || rawSize > (1u << 30)) return false;
+
+    const uint8* data = bytes.GetData() + HeaderSize;
+    int32 size = bytes.Num() - HeaderSize;
+    if(flags & TileCompressed){
+        raw.SetNumUninitialized(rawSize);
+        return FCompression::UncompressMemory(NAME_Zlib, raw.GetData(), rawSize, data, size);
+    }
+    if((uint32)size != rawSize) return false;
+    raw.Append(data, size);
+    return true;
+}
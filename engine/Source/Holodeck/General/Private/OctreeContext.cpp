@@ -0,0 +1,376 @@
+// MIT License (c) 2021 BYU FRoStLab see LICENSE file
+
+#include "Holodeck.h"
+#include "OctreeContext.h"
+#include "Octree.h"
+#include "Conversion.h"
+#include "EngineUtils.h"
+#include "LandscapeProxy.h"
+#include "GameFramework/Pawn.h"
+#include "Async/Async.h"
+#include "Misc/Guid.h"
+
+OctreeContext::OctreeContext(UWorld* world, const FVector& envMin, const FVector& envMax, float octreeMin, float octreeMax)
+    : World(world), params(MakeShared<FCollisionQueryParams, ESPMode::ThreadSafe>(initParams())) {
+    // Clean environment size
+    EnvMin = FVector((int)FGenericPlatformMath::Min(envMin.X, envMax.X), (int)FGenericPlatformMath::Min(envMin.Y, envMax.Y), (int)FGenericPlatformMath::Min(envMin.Z, envMax.Z));
+    EnvMax = FVector((int)FGenericPlatformMath::Max(envMin.X, envMax.X), (int)FGenericPlatformMath::Max(envMin.Y, envMax.Y), (int)FGenericPlatformMath::Max(envMin.Z, envMax.Z));
+    UE_LOG(LogHolodeck, Log, TEXT("Octree:: EnvMin: %s"), *EnvMin.ToString());
+    UE_LOG(LogHolodeck, Log, TEXT("Octree:: EnvMax: %s"), *EnvMax.ToString());
+
+    // Calculate where/how big is biggest octree
+    EnvCenter = (EnvMax + EnvMin) / 2;
+
+    loadMaterials();
+    findHeightfields();
+    watchProps();
+    sessionDir = FPaths::ProjectSavedDir() + "Octrees/" + FGuid::NewGuid().ToString();
+
+    // Make max/root a multiple of min
+    maxGiven = octreeMax;
+    const Resolution& res = resolution(octreeMin);
+    OctreeMin = res.min;
+    OctreeMax = res.max;
+    OctreeRoot = res.root;
+    UE_LOG(LogHolodeck, Log, TEXT("Octree:: OctreeMin: %f, OctreeMax: %f, OctreeRoot: %f"), OctreeMin, OctreeMax, OctreeRoot);
+}
+
+OctreeContext::~OctreeContext(){
+    rebuildCancel = true;
+    if(rebuildTask.IsValid()) rebuildTask.Wait();
+    IFileManager::Get().DeleteDirectory(*sessionDir, false, true);
+    for(auto& res : resolutions) delete res.Value;
+    for(auto& agent : agentOctrees) delete agent.Value;
+}
+
+OctreeContext* OctreeContext::fromCommandLine(UWorld* world){
+    // Load environment size
+    FVector envMin, envMax;
+    if (!FParse::Value(FCommandLine::Get(), TEXT("EnvMinX="), envMin.X)) envMin.X = -10;
+    if (!FParse::Value(FCommandLine::Get(), TEXT("EnvMinY="), envMin.Y)) envMin.Y = -10;
+    if (!FParse::Value(FCommandLine::Get(), TEXT("EnvMinZ="), envMin.Z)) envMin.Z = -10;
+    if (!FParse::Value(FCommandLine::Get(), TEXT("EnvMaxX="), envMax.X)) envMax.X = 10;
+    if (!FParse::Value(FCommandLine::Get(), TEXT("EnvMaxY="), envMax.Y)) envMax.Y = 10;
+    if (!FParse::Value(FCommandLine::Get(), TEXT("EnvMaxZ="), envMax.Z)) envMax.Z = 10;
+
+    // Get octree min/max
+    float octreeMin, octreeMax;
+    if (!FParse::Value(FCommandLine::Get(), TEXT("OctreeMin="), octreeMin)) octreeMin = .1;
+    if (!FParse::Value(FCommandLine::Get(), TEXT("OctreeMax="), octreeMax)) octreeMax = 5;
+
+    // These are the same for every world in the process
+    Octree::useDag = FParse::Param(FCommandLine::Get(), TEXT("OctreeDag"));
+    OctreeCodec::compress = FParse::Param(FCommandLine::Get(), TEXT("OctreeCompress"));
+    if(Octree::useDag) UE_LOG(LogHolodeck, Log, TEXT("Octree:: Keeping tiles as DAGs"));
+    OctreeTileCache::init();
+
+    return new OctreeContext(world, ConvertLinearVector(envMin, ClientToUE), ConvertLinearVector(envMax, ClientToUE), octreeMin*100, octreeMax*100);
+}
+
+FCollisionQueryParams OctreeContext::initParams(){
+    FCollisionQueryParams p;
+    p.bTraceComplex = false;
+    p.TraceTag = "";
+    // p.bFindInitialOverlaps = true;
+    // p.bReturnPhysicalMaterial = true;
+    // p.bReturnFaceIndex = true;
+    return p;
+}
+
+void OctreeContext::ignoreActor(const AActor* actor){
+    FScopeLock lock(&paramsLock);
+    if(params->GetIgnoredActors().Contains(actor->GetUniqueID())) return;
+
+    // Builds that are running hold on to the old ones, so change a copy
+    TSharedRef<FCollisionQueryParams, ESPMode::ThreadSafe> changed = MakeShared<FCollisionQueryParams, ESPMode::ThreadSafe>(*params);
+    changed->AddIgnoredActor(actor);
+    params = changed;
+}
+
+void OctreeContext::resetParams(){
+    FScopeLock lock(&paramsLock);
+    params = MakeShared<FCollisionQueryParams, ESPMode::ThreadSafe>(initParams());
+}
+
+TSharedRef<const FCollisionQueryParams, ESPMode::ThreadSafe> OctreeContext::getParams(){
+    FScopeLock lock(&paramsLock);
+    return params;
+}
+
+FCollisionQueryParams OctreeContext::agentParams(){
+    return initParams();
+}
+
+const OctreeContext::Resolution& OctreeContext::resolution(float min){
+    FScopeLock lock(&resolutionLock);
+    Resolution** found = resolutions.Find(min);
+    if(found) return **found;
+
+    // Make max/root a multiple of min
+    Resolution* res = new Resolution;
+    res->min = min;
+    res->max = min;
+    while(res->max < maxGiven){
+        res->max *= 2;
+    }
+    res->root = res->max;
+    while(res->root < (EnvMax - EnvMin).GetAbsMax()){
+        res->root *= 2;
+    }
+    res->dir = cacheDir(res->min, res->max);
+    if(propsChanged){
+        // Tiles built now would have the changed props in them, and finer caches don't
+        res->dir = sessionDir / FPaths::GetCleanFilename(res->dir);
+        UE_LOG(LogHolodeck, Log, TEXT("Octree:: Props have changed, keeping tiles for OctreeMin %f in %s"), min, *res->dir);
+    }
+    else{
+        findFinerCache(*res);
+    }
+
+    resolutions.Add(min, res);
+    return *res;
+}
+
+TArray<const OctreeContext::Resolution*> OctreeContext::getResolutions(){
+    FScopeLock lock(&resolutionLock);
+    TArray<const Resolution*> found;
+    for(auto& res : resolutions) found.Add(res.Value);
+    return found;
+}
+
+FString OctreeContext::cacheDir(int min, int max) const {
+    return FPaths::ProjectDir() + "Octrees/" + World->GetMapName() + "/min" + FString::FromInt(min) + "_max" + FString::FromInt(max);
+}
+
+void OctreeContext::findHeightfields(){
+    if(World == nullptr) return;
+    for(TActorIterator<ALandscapeProxy> it(World); it; ++it){
+        ALandscapeProxy* landscape = *it;
+        FVector scale = landscape->GetActorScale3D();
+        if(!landscape->GetActorRotation().IsNearlyZero() || scale.X <= 0 || scale.Y <= 0) continue;
+        Heightfields.Add({landscape, landscape->GetComponentsBoundingBox()});
+    }
+    UE_LOG(LogHolodeck, Log, TEXT("Octree:: Filling tiles from %d landscapes' heights"), Heightfields.Num());
+}
+
+FString OctreeContext::agentCacheDir() const {
+    return FPaths::ProjectDir() + "Octrees/Agents";
+}
+
+Octree* OctreeContext::findAgentOctree(const FString& key){
+    FScopeLock lock(&agentLock);
+    Octree** found = agentOctrees.Find(key);
+    return found ? *found : nullptr;
+}
+
+Octree* OctreeContext::addAgentOctree(const FString& key, Octree* tree){
+    FScopeLock lock(&agentLock);
+    Octree** found = agentOctrees.Find(key);
+    if(found){
+        delete tree;
+        return *found;
+    }
+    return agentOctrees.Add(key, tree);
+}
+
+bool OctreeContext::isProp(AActor* actor, FBox& bounds){
+    for(AActor* parent = actor; parent != nullptr; parent = parent->GetAttachParentActor()){
+        if(parent->IsA<APawn>()) return false;
+    }
+    if(actor->IsA<ALandscapeProxy>()) return false;
+    bounds = actor->GetComponentsBoundingBox();
+    return bounds.IsValid != 0;
+}
+
+void OctreeContext::watchProps(){
+    if(World == nullptr) return;
+    for(TActorIterator<AActor> it(World); it; ++it){
+        FBox bounds;
+        if(isProp(*it, bounds)) props.Add({*it, bounds, bounds});
+    }
+    spawnHandle = World->AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateRaw(this, &OctreeContext::onActorSpawned));
+    UE_LOG(LogHolodeck, Log, TEXT("Octree:: Watching %d props for changes"), props.Num());
+}
+
+void OctreeContext::onActorSpawned(AActor* actor){
+    spawned.Add(actor);
+}
+
+void OctreeContext::stop(){
+    if(spawnHandle.IsValid()){
+        World->RemoveOnActorSpawnedHandler(spawnHandle);
+        spawnHandle.Reset();
+    }
+    if(rebuildTask.IsValid()){
+        rebuildCancel = true;
+        rebuildTask.Wait();
+        rebuildTask = TFuture<void>();
+    }
+}
+
+static bool sameBox(const FBox& a, const FBox& b){
+    return a.IsValid == b.IsValid && a.Min.Equals(b.Min, .1f) && a.Max.Equals(b.Max, .1f);
+}
+
+void OctreeContext::update(){
+    for(const TWeakObjectPtr<AActor>& actor : spawned){
+        FBox bounds;
+        if(!actor.IsValid() || !isProp(actor.Get(), bounds)) continue;
+        props.Add({actor, bounds, bounds});
+        dirty.Add(bounds);
+    }
+    spawned.Reset();
+
+    for(int32 i = props.Num() - 1; i >= 0; i--){
+        Prop& prop = props[i];
+        if(!prop.actor.IsValid()){
+            dirty.Add(prop.bounds);
+            props.RemoveAtSwap(i);
+            continue;
+        }
+        if(!prop.actor->IsRootComponentMovable()) continue;
+
+        // Props are left till they stop moving, so ones that keep moving don't rebuild their tiles every tick
+        FBox now = prop.actor->GetComponentsBoundingBox();
+        if(!sameBox(now, prop.seen)){
+            prop.seen = now;
+        }
+        else if(!sameBox(now, prop.bounds)){
+            if(prop.bounds.IsValid) dirty.Add(prop.bounds);
+            if(now.IsValid) dirty.Add(now);
+            prop.bounds = now;
+        }
+    }
+
+    if(dirty.Num() != 0) propsChanged = true;
+    if(rebuildTask.IsValid() && rebuildTask.IsReady()) finishRebuild();
+    if(dirty.Num() != 0 && !rebuildTask.IsValid()) startRebuild();
+}
+
+void OctreeContext::startRebuild(){
+    UE_LOG(LogHolodeck, Log, TEXT("Octree:: Rebuilding tiles around %d changed props"), dirty.Num());
+    TArray<FBox> boxes = MoveTemp(dirty);
+    dirty.Reset();
+    rebuilt.Reset();
+    rebuiltRegions.Reset();
+    rebuildCancel = false;
+    int32 generation = ++rebuilds;
+
+    // Nothing on the game thread touches rebuilt or rebuiltRegions till it's done
+    rebuildTask = Async(EAsyncExecution::ThreadPool, [this, boxes, generation](){
+        Octree::rebuildTiles(*this, boxes, generation, rebuildCancel, rebuilt, rebuiltRegions);
+    });
+}
+
+void OctreeContext::finishRebuild(){
+    rebuildTask = TFuture<void>();
+    FScopeLock lock(&updateLock);
+    for(const TileUpdate& tile : rebuilt){
+        updates.Add(tile);
+        replacedFiles.Add(tile.replaces, tile.file);
+    }
+    for(auto& region : rebuiltRegions){
+        replacedRegions.Add(region.Key, region.Value);
+    }
+    UE_LOG(LogHolodeck, Log, TEXT("Octree:: Rebuilt %d tiles"), rebuilt.Num());
+}
+
+int32 OctreeContext::updatesSince(int32 generation, TArray<TileUpdate>& found){
+    FScopeLock lock(&updateLock);
+    for(int32 i = generation; i < updates.Num(); i++){
+        found.Add(updates[i]);
+    }
+    return updates.Num();
+}
+
+FString OctreeContext::tileFile(const FString& file){
+    FScopeLock lock(&updateLock);
+    const FString* replaced = replacedFiles.Find(file);
+    return replaced ? *replaced : file;
+}
+
+bool OctreeContext::findRegion(const FString& path, TBitArray<>& bits){
+    FScopeLock lock(&updateLock);
+    const TBitArray<>* replaced = replacedRegions.Find(path);
+    if(replaced) bits = *replaced;
+    return replaced != nullptr;
+}
+
+FString OctreeContext::rebuildDir(const Resolution& res) const {
+    return sessionDir / FPaths::GetCleanFilename(res.dir);
+}
+
+void OctreeContext::findFinerCache(Resolution& res){
+    // Cache folders are named by whole centimeters
+    if(res.min != (int)res.min) return;
+
+    FString mapDir = FPaths::ProjectDir() + "Octrees/" + World->GetMapName();
+    TArray<FString> dirs;
+    IFileManager::Get().FindFiles(dirs, *(mapDir / TEXT("*")), false, true);
+
+    float extent = (EnvMax - EnvMin).GetAbsMax();
+    for(const FString& dir : dirs){
+        FString minPart, maxPart;
+        if(!dir.StartsWith(TEXT("min")) || !dir.Split(TEXT("_max"), &minPart, &maxPart)) continue;
+        int min = FCString::Atoi(*minPart.RightChop(3));
+        int max = FCString::Atoi(*maxPart);
+
+        // Its nodes only line up with ours if its OctreeMin is ours halved some number of times,
+        // and its root is the same size
+        int ratio = min > 0 ? (int)res.min / min : 0;
+        if(ratio < 2 || ratio*min != (int)res.min || !FMath::IsPowerOfTwo(ratio)) continue;
+        float root = max;
+        while(root < extent) root *= 2;
+        if(root != res.root) continue;
+
+        // The closest one has the least to merge
+        if(!res.finerDir.IsEmpty() && min <= res.finerMin) continue;
+        if(!FPaths::DirectoryExists(mapDir / dir / TEXT("regions"))) continue;
+        res.finerDir = mapDir / dir;
+        res.finerMin = min;
+        res.finerMax = max;
+    }
+
+    if(!res.finerDir.IsEmpty()){
+        UE_LOG(LogHolodeck, Log, TEXT("Octree:: Tiles in %s that aren't saved will be derived from %s"), *res.dir, *res.finerDir);
+    }
+}
+
+void OctreeContext::loadMaterials(){
+    // Load material lookup table
+    FString filePath = FPaths::ProjectDir() + "../../materials.csv";
+    TArray<FString> lines;
+	FFileHelper::LoadANSITextFileToStrings(*filePath, NULL, lines);
+	for (int i = 1; i < lines.Num(); i++)
+	{
+        // Split line into elements
+		TArray<FString> stringArray = {};
+		lines[i].ParseIntoArray(stringArray, TEXT(","), false);
+
+        // Put elements into lookup table
+        FString key = stringArray[0];
+        if(stringArray.Num() == 3){
+            // density, speed of sound
+            float z = FCString::Atof(*stringArray[1]) * FCString::Atof(*stringArray[2]);
+            materials.Add(key, z);
+        }
+	}
+}
+
+float OctreeContext::getImpedance(const FString& material){
+    float matProp;
+    bool found = materials.Find(material, matProp);
+    if(!found){
+        UE_LOG(LogHolodeck, Warning, TEXT("Missing material information for %s, adding in blank row to csv"), *material);
+
+        // Add default line to material file to fill in later
+        FString filePath = FPaths::ProjectDir() + "../../materials.csv";
+        FString line = "\n" + material + ", 10000, 10000";
+        FFileHelper::SaveStringToFile(line, *filePath, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), EFileWrite::FILEWRITE_Append);
+
+        // Default to something really high to get full reflection for this time
+        matProp = 10000*10000;
+        materials.Add(material, matProp);
+    }
+    return matProp;
+}
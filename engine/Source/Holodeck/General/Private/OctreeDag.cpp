@@ -0,0 +1,146 @@
+// MIT License (c) 2021 BYU FRoStLab see LICENSE file
+
+#include "Holodeck.h"
+#include "OctreeDag.h"
+#include "Octree.h"
+#include "OctreeContext.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+#include <map>
+#include <vector>
+
+static const uint32 DagMagic = 0x4741444F;  // "ODAG"
+static const uint32 DagVersion = 2;
+
+// What's been added so far, so repeats are found
+struct OctreeDag::Builder {
+    // The tile's OctreeMin
+    float leafSize;
+    // A node's size in OctreeMins, its child mask and its children
+    std::map<std::vector<uint32>, int32> nodeIds;
+    // A leaf's normal and material packed together
+    TMap<uint64, int32> leafIds;
+    TMap<FString, uint16> materialIds;
+};
+
+OctreeDag* OctreeDag::fromTree(Octree* tile){
+    OctreeDag* dag = new OctreeDag;
+    dag->scale = FMath::RoundToInt(tile->size / tile->makeTill);
+    Builder builder;
+    builder.leafSize = tile->makeTill;
+    dag->root = dag->add(tile, builder);
+    dag->nodes.Shrink();
+    dag->leaves.Shrink();
+    dag->normals.Shrink();
+    return dag;
+}
+
+int32 OctreeDag::add(Octree* tree, Builder& builder){
+    // Leaves are the same if their quantized normal and material are
+    if(tree->size == builder.leafSize){
+        Leaf leaf;
+        OctreeCodec::encodeNormal(tree->normal, leaf.normal[0], leaf.normal[1]);
+        uint16* material = builder.materialIds.Find(tree->material);
+        if(material == nullptr){
+            material = &builder.materialIds.Add(tree->material, (uint16)materials.Num());
+            materials.Add(tree->material);
+            impedance.Add(tree->z);
+        }
+        leaf.material = *material;
+
+        uint64 key = (uint64)leaf.normal[0] | (uint64)leaf.normal[1] << 16 | (uint64)leaf.material << 32;
+        int32* id = builder.leafIds.Find(key);
+        if(id == nullptr){
+            id = &builder.leafIds.Add(key, leaves.Num());
+            leaves.Add(leaf);
+            normals.Add(OctreeCodec::decodeNormal(leaf.normal[0], leaf.normal[1]));
+        }
+        return *id;
+    }
+
+    // Nodes are the same if they're the same size and their children are
+    uint32 mask = 0;
+    uint32 children[8];
+    for(Octree* l : tree->leaves){
+        int32 id = add(l, builder);
+        if(id == INDEX_NONE) continue;
+        int32 slot = OctreeCodec::slotOf(l->loc - tree->loc);
+        mask |= 1 << slot;
+        children[slot] = id;
+    }
+    // Nothing under it shows up on the sonar
+    if(mask == 0) return INDEX_NONE;
+
+    std::vector<uint32> key = {(uint32)FMath::RoundToInt(tree->size / builder.leafSize), mask};
+    for(int32 slot = 0; slot < 8; slot++){
+        if(mask & 1 << slot) key.push_back(children[slot]);
+    }
+    auto it = builder.nodeIds.find(key);
+    if(it != builder.nodeIds.end()) return it->second;
+
+    int32 id = nodes.Num();
+    nodes.Append(key.data() + 1, (int32)key.size() - 1);
+    builder.nodeIds.emplace(std::move(key), id);
+    return id;
+}
+
+void OctreeDag::serialize(TArray<uint8>& bytes){
+    TArray<uint8> raw;
+    FMemoryWriter ar(raw);
+    int32 numLeaves = leaves.Num();
+    ar << scale << root << nodes << materials << numLeaves;
+    ar.Serialize(leaves.GetData(), numLeaves*sizeof(Leaf));
+    OctreeCodec::pack(DagMagic, DagVersion, raw, bytes);
+}
+
+OctreeDag* OctreeDag::deserialize(const TArray<uint8>& bytes, uint32 tileScale, OctreeContext& ctx){
+    TArray<uint8> raw;
+    if(!OctreeCodec::unpack(DagMagic, DagVersion, bytes, raw)) return nullptr;
+
+    FMemoryReader ar(raw);
+    OctreeDag* dag = new OctreeDag;
+    int32 numLeaves = -1;
+    ar << dag->scale << dag->root << dag->nodes << dag->materials << numLeaves;
+    if(!ar.IsError() && numLeaves >= 0 && ar.TotalSize() - ar.Tell() == (int64)numLeaves*sizeof(Leaf)){
+        dag->leaves.SetNumUninitialized(numLeaves);
+        ar.Serialize(dag->leaves.GetData(), numLeaves*sizeof(Leaf));
+    }
+
+    // Anything cut off or mangled either runs off the end or points outside the arrays
+    TSet<int32> checked;
+    if(ar.IsError() || !ar.AtEnd() || dag->scale != tileScale ||
+            (dag->root != INDEX_NONE && !dag->check(dag->root, dag->scale, checked))){
+        delete dag;
+        return nullptr;
+    }
+
+    for(const FString& material : dag->materials){
+        dag->impedance.Add(ctx.getImpedance(material));
+    }
+    for(const Leaf& leaf : dag->leaves){
+        dag->normals.Add(OctreeCodec::decodeNormal(leaf.normal[0], leaf.normal[1]));
+    }
+    return dag;
+}
+
+bool OctreeDag::check(int32 node, uint32 nodeScale, TSet<int32>& checked) const {
+    if(node < 0 || node >= nodes.Num() || nodeScale < 2) return false;
+    if(checked.Contains(node)) return true;
+
+    uint32 mask = nodes[node];
+    int32 numChildren = FMath::CountBits(mask);
+    if(mask == 0 || mask > 0xFF || node + numChildren >= nodes.Num()) return false;
+
+    for(int32 i = 1; i <= numChildren; i++){
+        int32 child = (int32)nodes[node + i];
+        if(nodeScale == 2){
+            if(child < 0 || child >= leaves.Num() || leaves[child].material >= materials.Num()) return false;
+        }
+        else if(!check(child, nodeScale/2, checked)){
+            return false;
+        }
+    }
+    checked.Add(node);
+    return true;
+}
@@ -0,0 +1,150 @@
+// MIT License (c) 2021 BYU FRoStLab see LICENSE file
+
+#include "Holodeck.h"
+#include "OctreeStats.h"
+#include "Octree.h"
+#include "OctreeContext.h"
+
+FCriticalSection OctreeStats::lock;
+TMap<float, OctreeStats::Counts> OctreeStats::counts;
+double OctreeStats::lastWrite = 0;
+int64 OctreeStats::lastLoads = 0;
+int64 OctreeStats::lastUnloads = 0;
+
+// The build running on this thread
+static thread_local double buildStart = 0;
+static thread_local int64 buildNans = 0;
+
+static const TCHAR* SourceNames[OctreeStats::NumSources] = {
+    TEXT("disk"), TEXT("shared_cache"), TEXT("built"), TEXT("derived"), TEXT("converted")
+};
+
+void OctreeStats::tileLoaded(Octree* tile, Source source){
+    if(tile->leaves.Num() == 0 && tile->dag == nullptr && tile->shared == nullptr) return;
+    int64 bytes = residentBytes(tile);
+
+    FScopeLock scope(&lock);
+    Counts& c = counts.FindOrAdd(tile->makeTill);
+    c.loads[source]++;
+    c.residentTiles++;
+    c.residentBytes += bytes;
+    c.peakBytes = FMath::Max(c.peakBytes, c.residentBytes);
+    tile->resident = true;
+}
+
+void OctreeStats::tileUnloaded(Octree* tile){
+    if(!tile->resident) return;
+    int64 bytes = residentBytes(tile);
+
+    FScopeLock scope(&lock);
+    Counts& c = counts.FindOrAdd(tile->makeTill);
+    c.unloads++;
+    c.residentTiles--;
+    c.residentBytes -= bytes;
+    tile->resident = false;
+}
+
+void OctreeStats::startBuild(){
+    buildStart = FPlatformTime::Seconds();
+    buildNans = 0;
+}
+
+void OctreeStats::nanNormal(){
+    buildNans++;
+}
+
+void OctreeStats::finishBuild(Octree* tile){
+    double seconds = FPlatformTime::Seconds() - buildStart;
+    int64 nodes = 0, leaves = 0, bytes = 0;
+    count(tile, tile->makeTill, nodes, leaves, bytes);
+
+    FScopeLock scope(&lock);
+    Counts& c = counts.FindOrAdd(tile->makeTill);
+    c.builds++;
+    c.buildSeconds += seconds;
+    c.nanNormals += buildNans;
+
+    // Kept next to the tiles, so it covers every session that's added to the cache
+    FString path = FPaths::GetPath(tile->file) / TEXT("builds.csv");
+    FString line;
+    if(!FPaths::FileExists(path)) line = TEXT("tile,ms,leaves,nan_normals\n");
+    line += FString::Printf(TEXT("%s,%.3f,%lld,%lld\n"), *FPaths::GetBaseFilename(tile->file), seconds*1000, leaves, buildNans);
+    FFileManagerGeneric().MakeDirectory(*FPaths::GetPath(path), true);
+    FFileHelper::SaveStringToFile(line, *path, FFileHelper::EEncodingOptions::ForceAnsi, &IFileManager::Get(), EFileWrite::FILEWRITE_Append);
+}
+
+void OctreeStats::count(Octree* tree, float leafSize, int64& nodes, int64& leaves, int64& bytes){
+    nodes++;
+    bytes += sizeof(Octree) + tree->leaves.GetAllocatedSize() + tree->material.GetAllocatedSize();
+    if(tree->size == leafSize) leaves++;
+    for(Octree* l : tree->leaves){
+        count(l, leafSize, nodes, leaves, bytes);
+    }
+}
+
+int64 OctreeStats::residentBytes(Octree* tile){
+    OctreeDag* dag = tile->dag;
+    if(dag){
+        int64 bytes = sizeof(OctreeDag) + dag->nodes.GetAllocatedSize() + dag->leaves.GetAllocatedSize() +
+            dag->materials.GetAllocatedSize() + dag->impedance.GetAllocatedSize() + dag->normals.GetAllocatedSize();
+        for(const FString& material : dag->materials) bytes += material.GetAllocatedSize();
+        return bytes;
+    }
+
+    // Shared with every instance that has it loaded, but counted by each of them
+    if(tile->shared){
+        return (tile->shared->numNodes - 1) * sizeof(OctreeTileCache::Node);
+    }
+
+    // The tile's own node isn't unloaded with it
+    int64 nodes = 0, leaves = 0, bytes = 0;
+    for(Octree* l : tile->leaves){
+        count(l, tile->makeTill, nodes, leaves, bytes);
+    }
+    return bytes + tile->leaves.GetAllocatedSize();
+}
+
+bool OctreeStats::write(OctreeContext& ctx, const FString& path){
+    double now = FPlatformTime::Seconds();
+    double uptime = FMath::Max(now - GStartTime, 1e-3);
+
+    TArray<FString> resolutions;
+    int64 loads = 0, unloads = 0;
+    {
+        FScopeLock scope(&lock);
+        for(const OctreeContext::Resolution* res : ctx.getResolutions()){
+            Counts c = counts.FindRef(res->min);
+            TArray<FString> sources;
+            int64 resLoads = 0;
+            for(int32 i = 0; i < NumSources; i++){
+                sources.Add(FString::Printf(TEXT("\"%s\":%lld"), SourceNames[i], c.loads[i]));
+                resLoads += c.loads[i];
+            }
+            loads += resLoads;
+            unloads += c.unloads;
+
+            resolutions.Add(FString::Printf(TEXT("{\"min\":%f,\"max\":%f,\"root\":%f,\"dir\":\"%s\",\"loads\":{%s},\"unloads\":%lld,")
+                TEXT("\"resident_tiles\":%lld,\"resident_bytes\":%lld,\"peak_resident_bytes\":%lld,\"builds\":%lld,\"build_s\":%.3f,\"nan_normals\":%lld}"),
+                res->min, res->max, res->root, *FPaths::ConvertRelativePathToFull(res->dir).ReplaceCharWithEscapedChar(),
+                *FString::Join(sources, TEXT(",")), c.unloads, c.residentTiles, c.residentBytes, c.peakBytes, c.builds, c.buildSeconds, c.nanNormals));
+        }
+    }
+
+    // Rates over the whole session, and since the last time they were written out
+    double since = now - (lastWrite > 0 ? lastWrite : GStartTime);
+    since = FMath::Max(since, 1e-3);
+    FString json = FString::Printf(TEXT("{\"map\":\"%s\",\"uptime_s\":%.3f,\"loads\":%lld,\"unloads\":%lld,")
+        TEXT("\"load_rate\":%f,\"unload_rate\":%f,\"recent_s\":%.3f,\"recent_load_rate\":%f,\"recent_unload_rate\":%f,\n\"resolutions\":[\n%s\n]}\n"),
+        *ctx.World->GetMapName(), uptime, loads, unloads, loads / uptime, unloads / uptime,
+        since, (loads - lastLoads) / since, (unloads - lastUnloads) / since, *FString::Join(resolutions, TEXT(",\n")));
+    lastWrite = now;
+    lastLoads = loads;
+    lastUnloads = unloads;
+
+    if(!FFileHelper::SaveStringToFile(json, *path)){
+        UE_LOG(LogHolodeck, Error, TEXT("OctreeStats:: Unable to write octree stats to %s"), *path);
+        return false;
+    }
+    UE_LOG(LogHolodeck, Log, TEXT("OctreeStats:: Wrote octree stats to %s"), *path);
+    return true;
+}
@@ -0,0 +1,247 @@
+// MIT License (c) 2021 BYU FRoStLab see LICENSE file
+
+#include "Holodeck.h"
+#include "OctreeTileCache.h"
+#include "Octree.h"
+#include "HolodeckProfiler.h"
+#include "Hash/CityHash.h"
+
+#include <new>
+#include <cstdio>
+#include <cstring>
+
+#if PLATFORM_WINDOWS
+#include "AllowWindowsPlatformTypes.h"
+#include <windows.h>
+#include "HideWindowsPlatformTypes.h"
+#elif PLATFORM_LINUX
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool OctreeTileCache::enabled = false;
+FCriticalSection OctreeTileCache::lock;
+std::map<std::string, OctreeTileCache::Mapping> OctreeTileCache::mapped;
+
+// Held by every instance while it takes or drops a reference to a cached tile. Otherwise the last
+// instance to drop one could take it out of the cache just as another picks it up. Windows frees a
+// mapping once its last handle is closed, so there it isn't needed
+struct CacheLock {
+    CacheLock(){
+        #if PLATFORM_LINUX
+        // Next to the cached tiles, but not named like them so clearing out leftover tiles leaves it be.
+        // It's never removed, since an instance could be holding it
+        fd = open("/dev/shm/HOLODECK_TILECACHE.lock", O_CREAT | O_RDWR, 0666);
+        if(fd == -1 || flock(fd, LOCK_EX) == -1){
+            UE_LOG(LogHolodeck, Warning, TEXT("OctreeTileCache:: Couldn't lock the shared tile cache"));
+        }
+        #endif
+    }
+
+    ~CacheLock(){
+        #if PLATFORM_LINUX
+        if(fd != -1) close(fd);
+        #endif
+    }
+
+    #if PLATFORM_LINUX
+    int fd = -1;
+    #endif
+};
+
+void OctreeTileCache::init(){
+    enabled = FParse::Param(FCommandLine::Get(), TEXT("OctreeSharedCache"));
+    if(enabled) UE_LOG(LogHolodeck, Log, TEXT("OctreeTileCache:: Sharing loaded octree tiles with other instances"));
+}
+
+std::string OctreeTileCache::makeName(const FString& file){
+    FTCHARToUTF8 key(*file);
+    char name[64];
+    #if PLATFORM_WINDOWS
+    snprintf(name, sizeof(name), "Local\\HOLODECK_OCTREE_%016llx", (unsigned long long)CityHash64(key.Get(), key.Length()));
+    #else
+    snprintf(name, sizeof(name), "/HOLODECK_OCTREE_%016llx", (unsigned long long)CityHash64(key.Get(), key.Length()));
+    #endif
+    return name;
+}
+
+OctreeTileCache::Mapping OctreeTileCache::mapTile(const std::string& name, uint64 size, bool create){
+    Mapping mapping;
+
+    #if PLATFORM_WINDOWS
+    HANDLE handle;
+    if(create){
+        handle = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (DWORD)(size >> 32), (DWORD)size, name.c_str());
+        // Someone else already cached it
+        if(handle != NULL && GetLastError() == ERROR_ALREADY_EXISTS){
+            CloseHandle(handle);
+            return mapping;
+        }
+    }
+    else{
+        handle = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+    }
+    if(handle == NULL) return mapping;
+
+    void* ptr = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, create ? size : 0);
+    if(ptr == NULL){
+        CloseHandle(handle);
+        return mapping;
+    }
+    if(!create){
+        MEMORY_BASIC_INFORMATION info;
+        VirtualQuery(ptr, &info, sizeof(info));
+        size = info.RegionSize;
+    }
+    mapping.handle = handle;
+
+    #elif PLATFORM_LINUX
+    int fd = shm_open(name.c_str(), create ? O_CREAT | O_EXCL | O_RDWR : O_RDWR, 0666);
+    // Either it isn't cached, or someone else already cached it
+    if(fd == -1) return mapping;
+
+    if(create){
+        if(ftruncate(fd, size) == -1){
+            ::close(fd);
+            shm_unlink(name.c_str());
+            return mapping;
+        }
+    }
+    else{
+        struct stat st;
+        if(fstat(fd, &st) == -1){
+            ::close(fd);
+            return mapping;
+        }
+        size = st.st_size;
+    }
+
+    void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(ptr == MAP_FAILED) return mapping;
+    #else
+    void* ptr = nullptr;
+    #endif
+
+    mapping.ptr = ptr;
+    mapping.size = size;
+    return mapping;
+}
+
+void OctreeTileCache::unmapTile(const std::string& name, Mapping& mapping, bool unlink){
+    #if PLATFORM_WINDOWS
+    // Windows frees the memory itself once the last handle is closed
+    UnmapViewOfFile(mapping.ptr);
+    CloseHandle(mapping.handle);
+    #elif PLATFORM_LINUX
+    munmap(mapping.ptr, mapping.size);
+    if(unlink) shm_unlink(name.c_str());
+    #endif
+    mapping.ptr = nullptr;
+}
+
+void OctreeTileCache::encode(Octree* tree, Node*& out){
+    Node* node = out;
+    node->loc = tree->loc;
+    node->z = tree->z;
+    node->normal = tree->normal;
+    node->numLeaves = tree->leaves.Num();
+    ++out;
+    for(Octree* l : tree->leaves){
+        encode(l, out);
+    }
+    node->numNodes = out - node;
+}
+
+void OctreeTileCache::useMapping(Octree* tree, const Mapping& mapping){
+    for(Octree* l : tree->leaves) delete l;
+    tree->leaves.Empty();
+    tree->shared = reinterpret_cast<const Node*>(static_cast<const Header*>(mapping.ptr) + 1);
+    tree->cached = true;
+}
+
+bool OctreeTileCache::load(Octree* tree){
+    if(!enabled || !tree->isTile() || tree->cached || tree->isDagTile()) return false;
+    HOLODECK_PROFILE_ZONE("OctreeTileCache::load");
+
+    std::string name = makeName(tree->file);
+    FScopeLock scope(&lock);
+    auto it = mapped.find(name);
+    if(it == mapped.end()){
+        CacheLock shared;
+        Mapping fresh = mapTile(name, 0, false);
+        if(fresh.ptr == nullptr) return false;
+
+        // Skip it if it's still being written, or another tile hashed to the same name
+        Header* header = static_cast<Header*>(fresh.ptr);
+        if(fresh.size < sizeof(Header) || header->state.load(std::memory_order_acquire) != 1 ||
+                strncmp(header->key, TCHAR_TO_UTF8(*tree->file), sizeof(header->key)) != 0 ||
+                fresh.size < sizeof(Header) + (uint64)header->numNodes*sizeof(Node)){
+            unmapTile(name, fresh, false);
+            return false;
+        }
+
+        ++header->refs;
+        it = mapped.emplace(name, fresh).first;
+    }
+    ++it->second.localRefs;
+
+    // Holding a reference keeps it mapped, the nodes are read where they are
+    useMapping(tree, it->second);
+    return true;
+}
+
+void OctreeTileCache::store(Octree* tree){
+    if(!enabled || !tree->isTile() || tree->cached || tree->isDagTile()) return;
+    HOLODECK_PROFILE_ZONE("OctreeTileCache::store");
+
+    std::string name = makeName(tree->file);
+    FScopeLock scope(&lock);
+
+    // Another sonar in this process already has it cached
+    auto it = mapped.find(name);
+    if(it != mapped.end()){
+        ++it->second.localRefs;
+        useMapping(tree, it->second);
+        return;
+    }
+
+    uint32 numNodes = tree->numLeaves();
+    CacheLock shared;
+    Mapping mapping = mapTile(name, sizeof(Header) + (uint64)numNodes*sizeof(Node), true);
+    if(mapping.ptr == nullptr) return;
+
+    Header* header = new (mapping.ptr) Header();
+    FTCHARToUTF8 key(*tree->file);
+    strncpy(header->key, key.Get(), sizeof(header->key) - 1);
+    header->numNodes = numNodes;
+    header->refs = 1;
+
+    Node* out = reinterpret_cast<Node*>(header + 1);
+    encode(tree, out);
+    header->state.store(1, std::memory_order_release);
+
+    mapping.localRefs = 1;
+    useMapping(tree, mapped.emplace(name, mapping).first->second);
+}
+
+void OctreeTileCache::release(Octree* tree){
+    if(!tree->cached) return;
+    tree->cached = false;
+    tree->shared = nullptr;
+
+    std::string name = makeName(tree->file);
+    FScopeLock scope(&lock);
+    auto it = mapped.find(name);
+    if(it == mapped.end() || --it->second.localRefs > 0) return;
+
+    // Last one out takes it out of the cache
+    CacheLock shared;
+    Header* header = static_cast<Header*>(it->second.ptr);
+    bool last = --header->refs == 0;
+    unmapTile(name, it->second, last);
+    mapped.erase(it);
+}
@@ -3,6 +3,7 @@
 #pragma once
 #include <random>
 #include <array>
+#include "NoiseSeed.h"
 
 /**
  * Sample from a mean 0 multivariate normal distribution
@@ -114,7 +115,7 @@ public:
         if(uncertain){
             // sample from N(0,1);
             for(int i=0;i<N;i++){
-                sam[i] = dist(gen);
+                sam[i] = dist(generator());
             }
 
             // shift by our covariance
@@ -203,10 +204,26 @@ public:
     std::array<std::array<float,N>,N> getSqrtCov(){ return sqrtCov; }
     bool isUncertain(){ return uncertain;}
 
+    // Seeds the generator directly instead of from NoiseSeed, for copies that need a stream of their own
+    void reseed(uint32_t seed){
+        gen.seed(seed);
+        seeded = true;
+    }
+
 private:
     bool uncertain = false;
     std::array<std::array<float,N>,N> sqrtCov = {{{{0}}}};
     std::normal_distribution<float> dist{0.0f, 1.0f};
-    std::random_device rd{};
-    std::mt19937 gen{ rd() };
+    std::mt19937 gen;
+    bool seeded = false;
+
+    // Seeded on first use, so generators built before the seed is set still
+    // pick it up
+    std::mt19937& generator(){
+        if(!seeded){
+            gen.seed(NoiseSeed::Next());
+            seeded = true;
+        }
+        return gen;
+    }
 };
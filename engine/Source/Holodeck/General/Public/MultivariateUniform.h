@@ -4,6 +4,7 @@
 #include <random>
 #include <cmath>
 #include <array>
+#include "NoiseSeed.h"
 
 /**
  * Sample from a min 0 multivariate uniform distribution
@@ -59,7 +60,7 @@ public:
         if(uncertain){
             // sample from N(0,1);
             for(int i=0;i<N;i++){
-                sam[i] = dist(gen)*max[i];
+                sam[i] = dist(generator())*max[i];
             }
         }
 
@@ -100,7 +101,7 @@ public:
 
         // sample
         if(uncertain){
-            float x = dist(gen);
+            float x = dist(generator());
             // https://en.wikipedia.org/wiki/Exponential_distribution#Generating_exponential_variates
             return -max[0]*std::log(x);
         }
@@ -119,10 +120,26 @@ public:
 
     bool isUncertain(){ return uncertain;}
 
+    // Seeds the generator directly instead of from NoiseSeed, for copies that need a stream of their own
+    void reseed(uint32_t seed){
+        gen.seed(seed);
+        seeded = true;
+    }
+
 private:
     bool uncertain = false;
     std::array<float,N> max = {{0}};
     std::uniform_real_distribution<float> dist{0.0f, 1.0f};
-    std::random_device rd{};
-    std::mt19937 gen{ rd() };
+    std::mt19937 gen;
+    bool seeded = false;
+
+    // Seeded on first use, so generators built before the seed is set still
+    // pick it up
+    std::mt19937& generator(){
+        if(!seeded){
+            gen.seed(NoiseSeed::Next());
+            seeded = true;
+        }
+        return gen;
+    }
 };
@@ -0,0 +1,41 @@
+// MIT License (c) 2021 BYU FRoStLab see LICENSE file
+
+#pragma once
+#include <cstdint>
+
+/**
+ * NoiseSeed
+ * Hands out the seeds used by MultivariateNormal and MultivariateUniform.
+ * Until SetSeed is called every generator gets a seed from std::random_device,
+ * like before. Once a base seed is set, generators are seeded from it in the
+ * order they first draw a sample, so a run that ticks the same sensors in the
+ * same order draws the same noise.
+ */
+class HOLODECK_API NoiseSeed
+{
+public:
+	/**
+	  * SetSeed
+	  * Sets the base seed and restarts the sequence of generator seeds.
+	  * @param Seed the base seed.
+	  */
+	static void SetSeed(uint32_t Seed);
+
+	/**
+	  * IsSeeded
+	  * @return true if a base seed has been set.
+	  */
+	static bool IsSeeded();
+
+	/**
+	  * GetSeed
+	  * @return the base seed, only meaningful if IsSeeded is true.
+	  */
+	static uint32_t GetSeed();
+
+	/**
+	  * Next
+	  * @return the seed for the next generator that gets constructed.
+	  */
+	static uint32_t Next();
+};
@@ -7,11 +7,15 @@
 #include "Misc/FileHelper.h"
 #include "HAL/FileManagerGeneric.h"
 #include "Containers/Map.h"
-#include "Containers/DiscardableKeyValueCache.h"
 #include "DrawDebugHelpers.h"
 #include "LandscapeProxy.h"
 
 #include "Conversion.h"
+#include "OctreeCodec.h"
+#include "OctreeContext.h"
+#include "OctreeDag.h"
+#include "OctreeStats.h"
+#include "OctreeTileCache.h"
 #include "gason.h"
 #include "jsonbuilder.h"
 #include <string>
@@ -22,73 +26,153 @@
 class Octree
 {
 	private:
-        // Globals used for calculations
+        // Constants used for calculations, everything else comes from the OctreeContext
         static TArray<FVector> corners;
         static TArray<FVector> sides;
-        static FCollisionQueryParams params;
         static float cornerSize;
-        static FVector EnvMin;
-        static FVector EnvMax;
-        static UWorld* World;
-        static TDiscardableKeyValueCache<FString,float> materials;
-
-        static FVector EnvCenter;
-
-        static void loadJson(gason::JsonValue& json, TArray<Octree*>& parent, float size);
-        void toJson(gason::JSonBuilder& doc);
-
-        static FCollisionQueryParams init_params(){
-            FCollisionQueryParams p;
-            p.bTraceComplex = false;
-            p.TraceTag = "";
-            // p.bFindInitialOverlaps = true;
-            // p.bReturnPhysicalMaterial = true;
-            // p.bReturnFaceIndex = true;
-            return p;
-        }
+
+        static void loadJson(OctreeContext& ctx, gason::JsonValue& json, TArray<Octree*>& parent, float size);
+        void toJson(gason::JSonBuilder& doc, float leafSize);
+        bool loadJson(OctreeContext& ctx, const FString& path);
+
+        // Tiles are saved packed, see OctreeCodec
+        void toPacked();
+        bool loadPacked(OctreeContext& ctx);
+
+        // Turns the leaves into a DAG and saves it
+        void toDag();
+        bool loadDag(OctreeContext& ctx);
+
+        // Saves in whichever of the above the octree is kept as
+        void save();
+
+        // Loads leaves or the DAG from file, returns false if it's missing or can't be parsed.
+        // Files that can't be parsed are moved aside to file.corrupt if quarantineCorrupt is set
+        bool loadFile(OctreeContext& ctx, bool quarantineCorrupt);
+
+        // Builds a tile's leaves. Landscapes are filled from their heights, everything else is probed with makeOctree
+        void build(OctreeContext& ctx);
+        // Adds leaves where the landscape's surface passes through this tile, working it out from
+        // its heights instead of probing it
+        void fillFromHeightfield(OctreeContext& ctx, const OctreeContext::Heightfield& heightfield);
+        // Makes the nodes down to an empty spot leafSize across at center and returns the leaf there,
+        // null if there's already one
+        Octree* addLeaf(const FVector& center, float leafSize);
+
+        // Does the work of makeOctree, with the collision settings it was started with. center and
+        // the normals are in frame, the world is probed with it
+        static Octree* makeOctree(OctreeContext& ctx, const FCollisionQueryParams& params, const FTransform& frame, FVector center, float octreeSize, float octreeMin, const FString& actorName, bool fill);
 
         static FString getMaterialName(FHitResult hit);
-        void fillMaterialProperties(FString mat);
+        void fillMaterialProperties(OctreeContext& ctx, FString mat);
+
+        // The name of a tile's file in its resolution's folder
+        static FString tileName(const FVector& loc);
+
+        // Tiles are found through a grid of regions, each saved as a bitmap of which of its tiles have
+        // something in them. Regions are RegionTiles tiles across, or the whole root if that's smaller
+        static const int32 RegionTiles = 16;
+        static float regionSize(float tileSize, float rootSize);
+        static FString regionFile(const FString& dir, const FVector& loc);
+        // Which of a region's tiles a point is in, as an index into its bitmap, and the other way round
+        static int32 regionBit(const FVector& regionLoc, float region, float tileSize, const FVector& at);
+        static FVector regionTile(const FVector& regionLoc, float region, float tileSize, int32 bit);
+        // Reads a region's bitmap, false if it hasn't been saved or isn't count tiles
+        static bool loadRegion(const FString& path, int32 count, TBitArray<>& bits);
+        static void saveRegion(const FString& path, TBitArray<>& bits);
+        // Works out which tiles in a region have something in them, from the finer cache's regions
+        // if it has them all or by probing the world
+        static void makeRegion(OctreeContext& ctx, const OctreeContext::Resolution& res, const FVector& regionLoc, TBitArray<>& bits);
+        static bool deriveRegion(OctreeContext& ctx, const OctreeContext::Resolution& res, const FVector& regionLoc, TBitArray<>& bits);
+        // Makes the children of an index node, from its region's bitmap if it's a region
+        void loadIndex(OctreeContext& ctx);
+        // Center of the node size across that at is in, in the octree under the context's root
+        static FVector nodeAt(OctreeContext& ctx, float rootSize, float size, const FVector& at);
+
+        // Fills this tile from the finer cache by merging its leaves, false if it doesn't hold everything needed
+        bool deriveFromFiner(OctreeContext& ctx);
+        // Whether the finer cache's tile at loc has something in it. Unknown if its region hasn't been saved,
+        // regions are kept in seen so each is only read once
+        static bool finerTilePresent(OctreeContext& ctx, const OctreeContext::Resolution& res, const FVector& loc, TMap<FString, TBitArray<>>& seen, bool& known);
+        // Loads the finer cache's tiles at or under tree, false if any of them aren't saved
+        static bool loadFiner(OctreeContext& ctx, Octree* tree, const OctreeContext::Resolution& res);
+        // Turns the finer nodes res.min across under tree into leaves, false if nothing was under tree
+        static bool coarsen(OctreeContext& ctx, Octree* tree, const OctreeContext::Resolution& res);
 
     public:
-        static float OctreeRoot;
-        static float OctreeMax;
-        static float OctreeMin;
+        // Whether OctreeMax tiles are kept as an OctreeDag instead of Octree nodes
+        static bool useDag;
 
         Octree(){};
 		Octree(FVector loc, float size, FString file="") : size(size), loc(loc), file(file) {};
 		~Octree(){ 
+            OctreeStats::tileUnloaded(this);
+            OctreeTileCache::release(this);
+            delete dag;
             for(Octree* leaf : leaves){
                 delete leaf;
             }
             leaves.Reset();
         }
 
-        // Used to setup octree globals
-        static void initOctree(UWorld* w);
+        // Makes the root of the environment's octree for the given OctreeMin or the context's. The
+        // index under it is made as it's loaded, so only the parts sensors get near are in memory
+        static Octree* makeEnvOctreeRoot(OctreeContext& ctx, float min = 0);
+
+        // iterative constructs octree. Nodes octreeMin across get a normal and material if fill is set,
+        // roots stop at tiles and don't need them
+        static Octree* makeOctree(OctreeContext& ctx, FVector center, float octreeSize, float octreeMin, FString actorName="", bool fill=true);
+
+        // Makes an actor's octree in its own frame, the smallest cube around bounds. It's saved and shared
+        // by every actor with the same mesh, so it's only built once. The context owns it, don't delete it
+        static Octree* makeAgentOctree(OctreeContext& ctx, AActor* actor, const FString& mesh, const FBox& bounds, float octreeMin);
 
-        // Figures out where octree roots are
-        static Octree* makeEnvOctreeRoot();
+        // Derives every tile of the context's resolution the finer cache covers that isn't saved yet,
+        // returns how many were made
+        static int deriveAll(OctreeContext& ctx);
 
-        // iterative constructs octree
-        static Octree* makeOctree(FVector center, float octreeSize, float octreeMin, FString actorName="");
+        // Builds the tiles of every resolution in use that the boxes touch again, from the world as it
+        // is now. They're saved to the context's rebuildDir with generation in their names, along with
+        // the bitmaps of the regions they change. Tiles already loaded aren't touched, see replaceTile
+        static void rebuildTiles(OctreeContext& ctx, const TArray<FBox>& boxes, int32 generation, const std::atomic<bool>& cancel,
+                                 TArray<OctreeContext::TileUpdate>& made, TMap<FString, TBitArray<>>& regions);
+
+        // Points the tile an update is for at its rebuilt file and unloads it, so it's loaded from there
+        // next time. Call on the root, parts of the index that haven't been made yet are left alone
+        void replaceTile(OctreeContext& ctx, const OctreeContext::TileUpdate& update);
 
         void unload();
-        void load();
+        void load(OctreeContext& ctx);
+
+        // Finds tiles whose center is within dist of at, loading the index above them on the way
+        void tilesNear(OctreeContext& ctx, const FVector& at, float dist, TArray<Octree*>& found);
 
         // helpers for saving
         void toJson();
-		
-        // ignore actors
-        static void ignoreActor(const AActor * InIgnoreActor){
-            params.AddIgnoredActor(InIgnoreActor);
-        }
-        static void resetParams(){ params = init_params(); }
 
         int numLeaves();
 
+        // OctreeMax tiles are saved on their own, the index above them as region bitmaps
+        bool isTile(){ return tile; }
+        bool isDagTile(){ return useDag && tile; }
+        bool isIndex(){ return index; }
+
         // Used to check if it's a dynamic octree for an agent
         bool isAgent = false;
+
+        // Set while the tile holds a reference in the OctreeTileCache
+        bool cached = false;
+
+        // Set while the tile is counted as resident in OctreeStats
+        bool resident = false;
+
+        // Set on OctreeMax tiles, their makeTill is the OctreeMin they're built at
+        bool tile = false;
+
+        // Set on the nodes above regions and on regions, their makeTill is the OctreeMin of the tiles
+        // under them. indexed is set once their children have been made
+        bool index = false;
+        bool indexed = false;
         
         // Given to all
         float size;
@@ -96,11 +180,18 @@ class Octree
 
         // Given to octree roots that have been saved/loaded from file
         FString file;
-        float makeTill;
+        float makeTill = 0;
 
         // Given to each non-leaf
         TArray<Octree*> leaves;
 
+        // Given to OctreeMax tiles in place of leaves when useDag is set
+        OctreeDag* dag = nullptr;
+
+        // Given to OctreeMax tiles in place of leaves while they're read from the OctreeTileCache.
+        // It's the tile's own node, with its leaves after it
+        const OctreeTileCache::Node* shared = nullptr;
+
         // Given to each leaf 
         FVector normal;
         FString material;
@@ -0,0 +1,66 @@
+// MIT License (c) 2021 BYU FRoStLab see LICENSE file
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class Octree;
+class OctreeContext;
+
+/**
+ * OctreeCodec
+ * Binary format OctreeMax tiles are saved in. Nodes are written depth first as a mask
+ * of which corners have a child, so locations come from the tile's location and don't
+ * need saving. Leaves are a material index into the tile's list of materials and an
+ * octahedral normal, stored as the difference from the previous leaf's since
+ * neighbouring leaves mostly face the same way. Masks, normals and materials are kept
+ * in separate arrays so they compress well.
+ *
+ * Every file starts with a small header, and the rest can be compressed with zlib.
+ * Compression is turned on with -OctreeCompress.
+ */
+class OctreeCodec
+{
+    public:
+        // Which corner a child is in, and the direction to its center. Same order as Octree::corners
+        static int32 slotOf(const FVector& offset){ return (offset.X < 0) << 2 | (offset.Y < 0) << 1 | (offset.Z < 0); }
+        static FVector cornerOf(int32 slot){ return FVector(slot & 4 ? -1 : 1, slot & 2 ? -1 : 1, slot & 1 ? -1 : 1); }
+
+        // Octahedral normal, 16 bits per coordinate
+        static void encodeNormal(const FVector& normal, uint16& u, uint16& v);
+        static FVector decodeNormal(uint16 u, uint16 v);
+
+        // Writes tile's leaves
+        static void encode(Octree* tile, TArray<uint8>& bytes);
+        // Reads leaves written by encode into tile, false if it's partial or corrupt.
+        // leafSize is the OctreeMin it was saved with
+        static bool decode(const TArray<uint8>& bytes, Octree* tile, float leafSize, OctreeContext& ctx);
+
+        // Puts the header in front of raw and compresses it if it's turned on
+        static void pack(uint32 magic, uint32 version, const TArray<uint8>& raw, TArray<uint8>& bytes);
+        // Checks the header and uncompresses what's behind it
+        static bool unpack(uint32 magic, uint32 version, const TArray<uint8>& bytes, TArray<uint8>& raw);
+
+        static bool compress;
+
+    private:
+        // The arrays a tile is saved as
+        struct Streams {
+            TArray<FString> materials;
+            TArray<uint8> masks;
+            TArray<uint16> normals;
+            TArray<uint16> materialIds;
+
+            // Size of the leaves, the tile's OctreeMin
+            float leafSize = 0;
+
+            // Where decoding is up to
+            int32 nextMask = 0;
+            int32 nextLeaf = 0;
+            uint16 u = 0;
+            uint16 v = 0;
+        };
+
+        static void encode(Octree* tree, Streams& streams, TMap<FString, uint16>& materialIds);
+        static bool decode(Octree* tree, Streams& streams, const TArray<float>& impedance);
+};
@@ -0,0 +1,192 @@
+// MIT License (c) 2021 BYU FRoStLab see LICENSE file
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/World.h"
+#include "HAL/CriticalSection.h"
+#include "Containers/Map.h"
+#include "Containers/DiscardableKeyValueCache.h"
+#include "Templates/SharedPointer.h"
+#include "Async/Future.h"
+
+#include <atomic>
+
+class Octree;
+class ALandscapeProxy;
+
+/**
+ * OctreeContext
+ * Everything the octrees of one world are built and loaded with: the world and the
+ * collision settings it's probed with, the environment's bounds, the material table
+ * and the resolutions sensors have asked for. The game mode owns one and hands it to
+ * whatever builds or loads octrees, so two worlds or configurations can be built at
+ * the same time in one process.
+ *
+ * Safe to use from any thread. Actors can be ignored while tiles are being built,
+ * builds that have already started keep the collision settings they started with.
+ *
+ * It also watches the world for props that are spawned, moved or destroyed, and rebuilds
+ * the tiles around them in the background. Sonars swap the rebuilt tiles in through
+ * updatesSince, the cache on disk is left as the level was saved. Resolutions set up
+ * once props have changed don't match that cache, so they're built and kept in the
+ * session's folder instead.
+ */
+class OctreeContext
+{
+    public:
+        // Sizes octrees are built with for one OctreeMin. OctreeMax and OctreeRoot are worked out
+        // from it the same way as for the default's, and each is cached in its own folder
+        struct Resolution {
+            float min;
+            float max;
+            float root;
+            FString dir;
+
+            // The cache with the biggest OctreeMin that's smaller than this one and lines up with it, if there is one
+            FString finerDir;
+            float finerMin = 0;
+            float finerMax = 0;
+        };
+
+        // A landscape tiles are filled from the heights of instead of probing it
+        struct Heightfield {
+            ALandscapeProxy* landscape;
+            FBox bounds;
+        };
+
+        // A tile that was rebuilt because props near it changed, saved to file in place of replaces
+        struct TileUpdate {
+            float min;
+            FVector loc;
+            FString file;
+            FString replaces;
+        };
+
+        // Environment bounds and octree sizes are in cm, the same as the world
+        OctreeContext(UWorld* world, const FVector& envMin, const FVector& envMax, float octreeMin, float octreeMax);
+        ~OctreeContext();
+
+        // Reads the environment bounds and octree sizes from the command line, along with the
+        // process wide octree flags
+        static OctreeContext* fromCommandLine(UWorld* world);
+
+        // Finds or sets up the resolution for an OctreeMin. Ones set up after props have changed are
+        // kept in the session's folder, not the cache
+        const Resolution& resolution(float min);
+        // Every resolution that's been set up so far
+        TArray<const Resolution*> getResolutions();
+
+        // Where octrees of a given size are saved
+        FString cacheDir(int min, int max) const;
+        // Where agent octrees are saved, they don't depend on the map so every map shares them
+        FString agentCacheDir() const;
+
+        // Agent octrees in their own frame, shared by every agent with the same mesh. The context
+        // owns them, null if it hasn't been made yet
+        Octree* findAgentOctree(const FString& key);
+        // Takes tree, unless another was added for key meanwhile. Returns the one that's kept
+        Octree* addAgentOctree(const FString& key, Octree* tree);
+
+        // Looks for props that were spawned, moved or destroyed since the last call, and rebuilds the
+        // tiles they were and are in in the background. Call once a tick from the game thread
+        void update();
+        // Stops watching the world and cancels the rebuild in progress, call before the world goes away
+        void stop();
+
+        // Tiles rebuilt since generation, returns the generation to pass next time
+        int32 updatesSince(int32 generation, TArray<TileUpdate>& found);
+        // Where a tile is loaded from, the rebuilt one if props near it have changed
+        FString tileFile(const FString& file);
+        // A region's bitmap if rebuilding tiles has changed it, false if it hasn't
+        bool findRegion(const FString& path, TBitArray<>& bits);
+        // Where rebuilt tiles of a resolution are saved. They only hold for this session, so they're
+        // kept out of the cache and deleted with the context. Each rebuild's are named by its generation,
+        // so they don't share a file (or a shared tile cache entry) with what they replace
+        FString rebuildDir(const Resolution& res) const;
+
+        // Impedance of a material, from materials.csv
+        float getImpedance(const FString& mat);
+
+        // Ignore actors when probing the world, already ignored ones are skipped
+        void ignoreActor(const AActor* actor);
+        void resetParams();
+
+        // The collision settings as they are now. Later calls to ignoreActor don't change them
+        TSharedRef<const FCollisionQueryParams, ESPMode::ThreadSafe> getParams();
+        // The collision settings for probing an agent. Agents are ignored when building the environment's
+        // tiles, so these start fresh instead of carrying that over
+        static FCollisionQueryParams agentParams();
+
+        UWorld* const World;
+        FVector EnvMin;
+        FVector EnvMax;
+        FVector EnvCenter;
+
+        // Default sizes, used by sensors that don't ask for their own
+        float OctreeMin;
+        float OctreeMax;
+        float OctreeRoot;
+
+        // Landscapes in the world when it was set up. Rotated or mirrored ones aren't a grid lined
+        // up with the octree, so they're left out and probed like everything else
+        TArray<Heightfield> Heightfields;
+
+    private:
+        // Something in the world the octrees are built from, and where it was when its tiles were
+        // last built. seen is where it was last tick, it's only rebuilt once it stops moving
+        struct Prop {
+            TWeakObjectPtr<AActor> actor;
+            FBox bounds;
+            FBox seen;
+        };
+
+        static FCollisionQueryParams initParams();
+        void loadMaterials();
+        void findHeightfields();
+        void findFinerCache(Resolution& res);
+        // Agents and landscapes aren't props, and neither is anything without collision
+        static bool isProp(AActor* actor, FBox& bounds);
+        void watchProps();
+        void onActorSpawned(AActor* actor);
+        void startRebuild();
+        void finishRebuild();
+
+        // OctreeMax as it was given, each resolution's is the first multiple of its OctreeMin past it
+        float maxGiven;
+
+        // Resolutions that have been asked for, by OctreeMin. Only added to, so references stay good
+        TMap<float, Resolution*> resolutions;
+        FCriticalSection resolutionLock;
+
+        TDiscardableKeyValueCache<FString, float> materials;
+
+        TSharedRef<const FCollisionQueryParams, ESPMode::ThreadSafe> params;
+        FCriticalSection paramsLock;
+
+        TMap<FString, Octree*> agentOctrees;
+        FCriticalSection agentLock;
+
+        // Props and what's happened to them, only used on the game thread
+        TArray<Prop> props;
+        TArray<TWeakObjectPtr<AActor>> spawned;
+        FDelegateHandle spawnHandle;
+        // Where props have been and gone since the last rebuild started
+        TArray<FBox> dirty;
+
+        // The rebuild running in the background and what it's made so far
+        TFuture<void> rebuildTask;
+        std::atomic<bool> rebuildCancel{ false };
+        int32 rebuilds = 0;
+        // Set once any prop has changed, the level as saved doesn't hold from then on
+        std::atomic<bool> propsChanged{ false };
+        TArray<TileUpdate> rebuilt;
+        TMap<FString, TBitArray<>> rebuiltRegions;
+
+        // Every tile that's been rebuilt in order, the cache files they replace and the regions they changed
+        TArray<TileUpdate> updates;
+        TMap<FString, FString> replacedFiles;
+        TMap<FString, TBitArray<>> replacedRegions;
+        FCriticalSection updateLock;
+        FString sessionDir;
+};
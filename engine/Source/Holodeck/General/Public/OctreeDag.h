@@ -0,0 +1,61 @@
+// MIT License (c) 2021 BYU FRoStLab see LICENSE file
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "OctreeCodec.h"
+
+class Octree;
+class OctreeContext;
+
+/**
+ * OctreeDag
+ * Compact, read only form of an OctreeMax tile. Identical subtrees (same shape, same
+ * quantized normals and materials) are stored once and referenced wherever they occur,
+ * so the tile is a directed acyclic graph instead of a tree. Nodes don't know where they
+ * are, their location is worked out while walking down from the tile.
+ *
+ * Interior nodes are a word holding which of the 8 children exist, followed by one word
+ * per existing child in corner order. Children of nodes twice OctreeMin in size index
+ * leaves, all others index nodes.
+ *
+ * Turned on with -OctreeDag, tiles are then saved as .dag files instead of .oct. They're
+ * packed and compressed the same way, see OctreeCodec.
+ */
+class OctreeDag
+{
+    public:
+        struct Leaf {
+            uint16 normal[2];   // Octahedral, see OctreeCodec
+            uint16 material;    // Index into materials
+        };
+
+        // Makes a DAG from a tile built or loaded as Octree nodes
+        static OctreeDag* fromTree(Octree* tile);
+
+        // Reads one written by serialize, null if it's partial, corrupt or not tileScale OctreeMins across
+        static OctreeDag* deserialize(const TArray<uint8>& bytes, uint32 tileScale, OctreeContext& ctx);
+        void serialize(TArray<uint8>& bytes);
+
+        const FVector& normalOf(int32 leaf) const { return normals[leaf]; }
+        float impedanceOf(int32 leaf) const { return impedance[leaves[leaf].material]; }
+
+        // Size of the tile in OctreeMins
+        uint32 scale = 0;
+        // Index of the tile's own node, or INDEX_NONE if the tile is empty
+        int32 root = INDEX_NONE;
+        TArray<uint32> nodes;
+        TArray<Leaf> leaves;
+        TArray<FString> materials;
+        // Impedance of each material, looked up when it's loaded
+        TArray<float> impedance;
+        // Each leaf's normal, decoded when it's loaded
+        TArray<FVector> normals;
+
+    private:
+        struct Builder;
+        int32 add(Octree* tree, Builder& builder);
+
+        // Makes sure everything under a node is in bounds
+        bool check(int32 node, uint32 nodeScale, TSet<int32>& checked) const;
+};
@@ -0,0 +1,74 @@
+// MIT License (c) 2021 BYU FRoStLab see LICENSE file
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Containers/Map.h"
+
+class Octree;
+class OctreeContext;
+
+/**
+ * OctreeStats
+ * Process wide counters of what the octree tiles are doing: where each load came
+ * from, how many tiles are resident and roughly how much memory they take, and how
+ * long builds take. Counters are kept per OctreeMin, since each resolution has its
+ * own tiles.
+ *
+ * Each tile that's built also gets a line in builds.csv in its resolution's folder
+ * with how long it took, how many leaves it has and how many of their normals came
+ * back NaN, so it's still there for holoocean.octrees to report after the session.
+ */
+class OctreeStats
+{
+    public:
+        // Where a tile's leaves came from when it was loaded
+        enum Source {
+            Disk,
+            SharedCache,
+            Built,
+            Derived,
+            Converted,
+            NumSources
+        };
+
+        // Counts a tile that was just loaded as resident. Empty tiles aren't, they're never unloaded
+        static void tileLoaded(Octree* tile, Source source);
+        // Counts a tile that was counted as resident as gone, anything else is skipped
+        static void tileUnloaded(Octree* tile);
+
+        // Times a tile build on this thread, and counts the NaN normals found meanwhile
+        static void startBuild();
+        static void finishBuild(Octree* tile);
+        static void nanNormal();
+
+        // Writes the counters as json, along with the resolutions the context has set up
+        static bool write(OctreeContext& ctx, const FString& path);
+
+        // Nodes and leaves at or under tree, and about how many bytes they take in memory
+        static void count(Octree* tree, float leafSize, int64& nodes, int64& leaves, int64& bytes);
+
+    private:
+        struct Counts {
+            int64 loads[NumSources] = {};
+            int64 unloads = 0;
+            int64 residentTiles = 0;
+            int64 residentBytes = 0;
+            int64 peakBytes = 0;
+            int64 builds = 0;
+            double buildSeconds = 0;
+            int64 nanNormals = 0;
+        };
+
+        static int64 residentBytes(Octree* tile);
+
+        static FCriticalSection lock;
+        // By OctreeMin
+        static TMap<float, Counts> counts;
+
+        // When write was last called and the totals then, for the recent rates
+        static double lastWrite;
+        static int64 lastLoads;
+        static int64 lastUnloads;
+};
@@ -0,0 +1,89 @@
+// MIT License (c) 2021 BYU FRoStLab see LICENSE file
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+
+#include <atomic>
+#include <string>
+#include <map>
+
+class Octree;
+
+/**
+ * OctreeTileCache
+ * Node wide cache of loaded OctreeMax tiles in named shared memory. Instances
+ * running the same map on one machine load a tile from here instead of each
+ * reading and parsing it from disk. Tiles are keyed by their file, which holds
+ * the map, OctreeMin, OctreeMax and the tile's location.
+ *
+ * Each instance holds a reference to the tiles it has loaded, and a tile leaves
+ * the cache once nobody references it. Taking and dropping references is done
+ * under a lock shared by every instance, so a tile isn't taken out of the cache
+ * while another instance is picking it up. Turned on with -OctreeSharedCache.
+ *
+ * The cache holds the tile's nodes read only, and instances read them where they
+ * are instead of making Octree nodes of their own, see Octree::shared. Tiles kept
+ * as an OctreeDag are already compact and aren't cached.
+ */
+class OctreeTileCache
+{
+    public:
+        // Reads whether the cache is turned on from the command line
+        static void init();
+
+        static bool isEnabled(){ return enabled; }
+
+        // A tile's node as it's kept in the cache. The tile's own node comes first, followed by its
+        // leaves depth first, numNodes is how many there are in the subtree starting at a node
+        struct Node {
+            FVector loc;
+            float z;
+            FVector normal;
+            uint32 numLeaves;
+            uint32 numNodes;
+        };
+
+        // Points tree at its nodes in the cache and takes a reference to it, false if it isn't cached
+        static bool load(Octree* tree);
+
+        // Puts a tile that was just loaded from disk or built into the cache and takes a reference to it.
+        // Its own nodes are freed and it's pointed at the cached ones instead
+        static void store(Octree* tree);
+
+        // Drops the reference load or store took, if any
+        static void release(Octree* tree);
+
+    private:
+        // Layout of a cached tile, must stay the same across instances sharing the cache
+        struct Header {
+            std::atomic<uint32> state;  // 0 while it's being written, 1 once it's ready
+            std::atomic<int32> refs;    // Instances that have it loaded, only changed under the shared lock
+            uint32 numNodes;
+            uint32 reserved;
+            char key[512];              // The tile's file, to catch hash collisions
+        };
+        // A tile this process has mapped, shared by all of its Octrees for that tile
+        struct Mapping {
+            void* ptr = nullptr;
+            uint64 size = 0;
+            int localRefs = 0;
+            #if PLATFORM_WINDOWS
+            void* handle = nullptr;
+            #endif
+        };
+
+        static std::string makeName(const FString& file);
+        // Maps a cached tile, or makes a new one of the given size if create is set. Null if it can't
+        static Mapping mapTile(const std::string& name, uint64 size, bool create);
+        static void unmapTile(const std::string& name, Mapping& mapping, bool unlink);
+
+        static void encode(Octree* tree, Node*& out);
+        // Points tree at a mapped tile's nodes, and frees the ones it has
+        static void useMapping(Octree* tree, const Mapping& mapping);
+
+        static bool enabled;
+        static FCriticalSection lock;
+        static std::map<std::string, Mapping> mapped;
+};
@@ -108,6 +108,50 @@ bool AHolodeckAgent::SetState(const FVector& NewLocation, const FRotator& NewRot
 	return bWasSuccessful;
 }
 
+void AHolodeckAgent::SaveSnapshot() {
+	SnapshotTransform = GetActorTransform();
+	SnapshotVelocity = FVector::ZeroVector;
+	SnapshotAngularVelocity = FVector::ZeroVector;
+
+	UPrimitiveComponent* RootComp = Cast<UPrimitiveComponent>(GetRootComponent());
+	if (RootComp != nullptr) {
+		SnapshotVelocity = RootComp->GetPhysicsLinearVelocity();
+		SnapshotAngularVelocity = RootComp->GetPhysicsAngularVelocityInDegrees();
+	}
+	SnapshotKinematics = Kinematics;
+
+	for (auto& Sensor : SensorMap) {
+		Sensor.Value->SaveSnapshot();
+	}
+}
+
+void AHolodeckAgent::RestoreSnapshot() {
+	SetActorTransform(SnapshotTransform, false, nullptr, ETeleportType::ResetPhysics);
+
+	UPrimitiveComponent* RootComp = Cast<UPrimitiveComponent>(GetRootComponent());
+	if (RootComp != nullptr) {
+		RootComp->SetAllPhysicsLinearVelocity(SnapshotVelocity, false);
+		RootComp->SetAllPhysicsAngularVelocityInDegrees(SnapshotAngularVelocity, false);
+	}
+	// So the first acceleration after the restore isn't computed across the jump
+	Kinematics = SnapshotKinematics;
+
+	// Whatever the agent was last told to do shouldn't carry into the new episode
+	FMemory::Memzero(GetRawActionBuffer(), GetRawActionSizeInBytes());
+	if (HolodeckController != nullptr)
+		HolodeckController->RestoreSnapshot();
+
+	for (auto& Sensor : SensorMap) {
+		Sensor.Value->RestoreSnapshot();
+	}
+}
+
+void AHolodeckAgent::UpdateKinematics(float DeltaTime) {
+	UPrimitiveComponent* RootComp = Cast<UPrimitiveComponent>(GetRootComponent());
+	if (RootComp != nullptr)
+		Kinematics.Update(RootComp, DeltaTime);
+}
+
 bool AHolodeckAgent::InitializeController() {
 	UE_LOG(LogHolodeck, Log, TEXT("Attempting to initialize controller for HolodeckAgent"));
 
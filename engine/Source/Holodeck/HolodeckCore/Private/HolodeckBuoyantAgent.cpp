@@ -39,14 +39,17 @@ void AHolodeckBuoyantAgent::InitializeAgent(){
 
 void AHolodeckBuoyantAgent::Tick(float DeltaSeconds) {
 	Super::Tick(DeltaSeconds);
-	if(octreeGlobal != nullptr) updateOctree(octreeLocal, octreeGlobal);
+	for(auto& global : octreeGlobal){
+		updateOctree(octreeLocal[global.Key], global.Value);
+	}
 }
 
 void AHolodeckBuoyantAgent::BeginDestroy() {
 	Super::BeginDestroy();
 
-	if(octreeLocal != nullptr) delete octreeLocal;
-	if(octreeGlobal != nullptr) delete octreeGlobal;
+	for(auto& global : octreeGlobal) delete global.Value;
+	octreeLocal.Reset();
+	octreeGlobal.Reset();
 }
 
 void AHolodeckBuoyantAgent::ApplyBuoyantForce(){
@@ -184,48 +187,46 @@ void AHolodeckBuoyantAgent::ShowSurfacePoints(float DeltaTime){
 	}
 }
 
-Octree* AHolodeckBuoyantAgent::makeOctree(){
-	if(octreeGlobal == nullptr){
+Octree* AHolodeckBuoyantAgent::makeOctree(OctreeContext& ctx, float octreeMin){
+	if(!octreeGlobal.Contains(octreeMin)){
 		UE_LOG(LogHolodeck, Log, TEXT("HolodeckBuoyantAgent::Making Octree"));
-		float OctreeMin = Octree::OctreeMin;
-		float OctreeMax = Octree::OctreeMin;
-
-		// Shrink to the smallest cube the actor fits in
-		FVector center = BoundingBox.GetCenter() + GetActorLocation();
-		float extent = BoundingBox.GetExtent().GetAbsMax()*2;
-		while(OctreeMax < extent){
-			OctreeMax *= 2;
-		}
-
-		// Otherwise, make the octrees
-		octreeGlobal = Octree::makeOctree(center, OctreeMax, OctreeMin, GetName());
-		if(octreeGlobal){
-			octreeGlobal->isAgent = true;
-			octreeGlobal->file = "AGENT";
 
-			// Convert our global octree to a local one
-			octreeLocal = cleanOctree(octreeGlobal);
+		// Agents with the same mesh share one, it's only built the first time any of them needs it
+		UStaticMesh* Mesh = RootMesh->GetStaticMesh();
+		FString MeshName = Mesh ? Mesh->GetPathName() : GetClass()->GetName();
+		Octree* local = Octree::makeAgentOctree(ctx, this, MeshName, BoundingBox, octreeMin);
+		if(local){
+			Octree* global = copyOctree(local);
+			global->isAgent = true;
+			global->file = "AGENT";
+			updateOctree(local, global);
+
+			octreeGlobal.Add(octreeMin, global);
+			octreeLocal.Add(octreeMin, local);
 		}
 		else{
 			UE_LOG(LogHolodeck, Warning, TEXT("HolodeckBuoyantAgent:: Failed to make Octree"));
+			return nullptr;
 		}
 
 	}
 
-	return octreeGlobal;
+	return octreeGlobal[octreeMin];
 }
 
-Octree* AHolodeckBuoyantAgent::cleanOctree(Octree* globalFrame){
-	Octree* local = new Octree;
-	local->loc = GetActorRotation().UnrotateVector(globalFrame->loc - GetActorLocation());
-	local->normal = GetActorRotation().UnrotateVector(globalFrame->normal);
+Octree* AHolodeckBuoyantAgent::copyOctree(Octree* localFrame){
+	Octree* global = new Octree(localFrame->loc, localFrame->size);
+	global->makeTill = localFrame->makeTill;
+	global->normal = localFrame->normal;
+	global->material = localFrame->material;
+	global->z = localFrame->z;
 
-	for( Octree* tree : globalFrame->leaves){
-		Octree* l = cleanOctree(tree);
-		local->leaves.Add(l);
+	for( Octree* tree : localFrame->leaves){
+		Octree* l = copyOctree(tree);
+		global->leaves.Add(l);
 	}
 
-	return local;
+	return global;
 }
 
 void AHolodeckBuoyantAgent::updateOctree(Octree* localFrame, Octree* globalFrame){
@@ -23,8 +23,17 @@ void UHolodeckGameInstance::Tick(float DeltaTime) {
 	// HolodeckGameMode will call tick on this.
 	// The release and acquire is what allows this to work in lock step with the client.
 	static bool bFirstTime = true;
+
+	if (!bFirstTime) Server->EndTick();
+
+	// If the client asked for several ticks in one step, keep going without
+	// handing control back until they have all run.
+	if (!bFirstTime && Server->AdvanceSchedule())
+		return;
+
 	if (!bFirstTime) Server->Release();
 	Server->Acquire();
+	Server->BeginSchedule();
 	bFirstTime = false;
 }
 
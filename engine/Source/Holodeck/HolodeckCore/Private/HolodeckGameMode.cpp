@@ -2,6 +2,10 @@
 
 #include "Holodeck.h"
 #include "HolodeckGameMode.h"
+#include "HolodeckAgent.h"
+#include "HolodeckSensor.h"
+#include "EngineUtils.h"
+#include "Engine/StaticMeshActor.h"
 
 const char RESET_KEY[] = "RESET";
 const int RESET_BYTES = 1;
@@ -19,8 +23,13 @@ void AHolodeckGameMode::Tick(float DeltaSeconds) {
 	// so we don't need to check bOn here.
 	if (this->Instance)
 		this->Instance->Tick(DeltaSeconds);
-	if (this->CommandCenter)
+	if (this->CommandCenter) {
+		FScopedTelemetry Timer(Server ? Server->GetTelemetry() : nullptr, ETelemetryStage::Commands);
 		this->CommandCenter->Tick(DeltaSeconds);
+	}
+	// Rebuild the octree tiles around any props the commands or level moved
+	if (Octrees)
+		Octrees->update();
 	//Check if we should reset, and then reset the level. 
 	if (ResetSignal != nullptr && *ResetSignal) {
 		UGameplayStatics::OpenLevel(this->Instance, FName(*GetWorld()->GetName()), false);
@@ -38,7 +47,13 @@ void AHolodeckGameMode::StartPlay() {
 	//	bHolodeckIsOn = FParse::Param(FCommandLine::Get(), TEXT("HolodeckOn"));
 
 	// Make sure Octree is properly initialized
-	Octree::initOctree(GetWorld());
+	Octrees.Reset(OctreeContext::fromCommandLine(GetWorld()));
+
+	if (IsSensorsOnly()) {
+		UE_LOG(LogHolodeck, Log, TEXT("HolodeckGameMode running sensors only, rendering is turned off"));
+		if (GEngine->GameViewport != nullptr)
+			GEngine->GameViewport->bDisableWorldRendering = true;
+	}
 
 	// Cap our tickrate
 	int FramesPerSec;
@@ -64,12 +79,26 @@ void AHolodeckGameMode::StartPlay() {
 		if (this->Server) {
 			this->CommandCenter = NewObject<UCommandCenter>();
 			CommandCenter->Init(Server, this);
+			RegisterPhysicsTimers();
+			RegisterSensorBatch();
 		}
 	}
 
 	Super::StartPlay();
 }
 
+void AHolodeckGameMode::EndPlay(const EEndPlayReason::Type EndPlayReason) {
+	if (Octrees)
+		Octrees->stop();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+bool AHolodeckGameMode::IsSensorsOnly() {
+	static const bool bSensorsOnly = FParse::Param(FCommandLine::Get(), TEXT("HolodeckSensorsOnly"));
+	return bSensorsOnly;
+}
+
 void AHolodeckGameMode::RegisterSettings() {
 	UE_LOG(LogHolodeck, Log, TEXT("Registering Settings"));
 	if (Server != nullptr) {
@@ -78,6 +107,161 @@ void AHolodeckGameMode::RegisterSettings() {
 	}
 }
 
+void AHolodeckGameMode::RegisterPhysicsTimers() {
+	UWorld* World = GetWorld();
+
+	StartPhysicsTimer.bCanEverTick = true;
+	StartPhysicsTimer.TickGroup = TG_StartPhysics;
+	StartPhysicsTimer.Target = this;
+	StartPhysicsTimer.bIsStart = true;
+	StartPhysicsTimer.RegisterTickFunction(World->PersistentLevel);
+
+	// Physics is done once the world's end physics tick has run
+	EndPhysicsTimer.bCanEverTick = true;
+	EndPhysicsTimer.TickGroup = TG_EndPhysics;
+	EndPhysicsTimer.Target = this;
+	EndPhysicsTimer.bIsStart = false;
+	EndPhysicsTimer.AddPrerequisite(World, World->EndPhysicsTickFunction);
+	EndPhysicsTimer.RegisterTickFunction(World->PersistentLevel);
+}
+
+void AHolodeckGameMode::OnPhysicsTimer(bool bIsStart) {
+	if (bIsStart) {
+		PhysicsStartMs = HolodeckTelemetry::NowMs();
+	}
+	else if (Server != nullptr && Server->GetTelemetry() != nullptr) {
+		Server->GetTelemetry()->AddStageTime(ETelemetryStage::Physics, HolodeckTelemetry::NowMs() - PhysicsStartMs);
+	}
+}
+
+void AHolodeckGameMode::UpdateAgentKinematics(float DeltaTime) {
+	if (Server == nullptr)
+		return;
+
+	for (auto& Agent : Server->AgentMap) {
+		Agent.Value->UpdateKinematics(DeltaTime);
+	}
+}
+
+void FHolodeckPhysicsTimerTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) {
+	if (Target == nullptr || Target->IsPendingKill())
+		return;
+
+	Target->OnPhysicsTimer(bIsStart);
+	if (!bIsStart)
+		Target->UpdateAgentKinematics(DeltaTime);
+}
+
+FString FHolodeckPhysicsTimerTickFunction::DiagnosticMessage() {
+	return bIsStart ? TEXT("FHolodeckPhysicsTimerTickFunction[Start]") : TEXT("FHolodeckPhysicsTimerTickFunction[End]");
+}
+
+void AHolodeckGameMode::RegisterSensorBatch() {
+	bSerialSensors = FParse::Param(FCommandLine::Get(), TEXT("HolodeckSerialSensors"));
+
+	SensorBatchTick.bCanEverTick = true;
+	SensorBatchTick.TickGroup = TG_PostPhysics;
+	SensorBatchTick.Target = this;
+	SensorBatchTick.RegisterTickFunction(GetWorld()->PersistentLevel);
+}
+
+bool AHolodeckGameMode::AddParallelSensor(UHolodeckSensor* Sensor) {
+	if (!SensorBatchTick.IsTickFunctionRegistered())
+		return false;
+
+	ParallelSensors.AddUnique(Sensor);
+	return true;
+}
+
+void AHolodeckGameMode::RemoveParallelSensor(UHolodeckSensor* Sensor) {
+	ParallelSensors.Remove(Sensor);
+}
+
+void AHolodeckGameMode::TickParallelSensors(float DeltaTime, ELevelTick TickType) {
+	if (ParallelSensors.Num() > 0)
+		UHolodeckSensor::TickParallel(ParallelSensors, DeltaTime, TickType, bSerialSensors);
+}
+
+void FHolodeckSensorBatchTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) {
+	if (Target != nullptr && !Target->IsPendingKill())
+		Target->TickParallelSensors(DeltaTime, TickType);
+}
+
+FString FHolodeckSensorBatchTickFunction::DiagnosticMessage() {
+	return TEXT("FHolodeckSensorBatchTickFunction");
+}
+
+void AHolodeckGameMode::SaveSnapshot() {
+	SnapshotActors.Empty();
+	for (TActorIterator<AActor> It(GetWorld()); It; ++It) {
+		SnapshotActors.Add(*It, It->GetActorTransform());
+	}
+
+	if (Server != nullptr) {
+		for (auto& Agent : Server->AgentMap) {
+			Agent.Value->SaveSnapshot();
+		}
+
+		SensorScheduler* Scheduler = Server->GetSensorScheduler();
+		if (Scheduler != nullptr)
+			SnapshotCaptureTick = Server->GetTickCount() - Scheduler->GetTickOffset();
+	}
+
+	bHasSnapshot = true;
+	UE_LOG(LogHolodeck, Log, TEXT("Saved snapshot of %d actors"), SnapshotActors.Num());
+}
+
+void AHolodeckGameMode::RestoreSnapshot() {
+	if (!bHasSnapshot) {
+		UE_LOG(LogHolodeck, Error, TEXT("AHolodeckGameMode::RestoreSnapshot called before a snapshot was saved. Nothing restored."));
+		return;
+	}
+
+	TArray<AActor*> ToDestroy;
+	for (TActorIterator<AActor> It(GetWorld()); It; ++It) {
+		AActor* Actor = *It;
+		FTransform* Transform = SnapshotActors.Find(Actor);
+
+		if (Transform == nullptr) {
+			// Props don't persist past a reset, so get rid of any spawned since the snapshot
+			if (Actor->IsA(AStaticMeshActor::StaticClass()))
+				ToDestroy.Add(Actor);
+			continue;
+		}
+
+		// Agents restore themselves, everything else only needs moving if physics moved it
+		if (Actor->IsA(AHolodeckAgent::StaticClass()))
+			continue;
+		UPrimitiveComponent* Root = Cast<UPrimitiveComponent>(Actor->GetRootComponent());
+		if (Root != nullptr && Root->IsSimulatingPhysics()) {
+			Actor->SetActorTransform(*Transform, false, nullptr, ETeleportType::ResetPhysics);
+			Root->SetAllPhysicsLinearVelocity(FVector::ZeroVector, false);
+			Root->SetAllPhysicsAngularVelocityInDegrees(FVector::ZeroVector, false);
+		}
+	}
+
+	for (AActor* Actor : ToDestroy) {
+		Actor->Destroy();
+	}
+
+	if (Server != nullptr) {
+		for (auto& Agent : Server->AgentMap) {
+			if (SnapshotActors.Contains(Agent.Value))
+				Agent.Value->RestoreSnapshot();
+			else
+				UE_LOG(LogHolodeck, Warning, TEXT("Agent %s was spawned after the snapshot, it was left as is"), *Agent.Key);
+		}
+
+		// The server's tick isn't restored, so sensors that capture every few ticks would
+		// otherwise capture on different ticks of the episode than they did the first time
+		SensorScheduler* Scheduler = Server->GetSensorScheduler();
+		if (Scheduler != nullptr)
+			Scheduler->SetTickOffset(Server->GetTickCount() - SnapshotCaptureTick);
+	}
+
+	UE_LOG(LogHolodeck, Log, TEXT("Restored snapshot, destroyed %d props"), ToDestroy.Num());
+}
+
 void AHolodeckGameMode::LogFatalMessage(const FString& Message) {
 	UE_LOG(LogHolodeck, Fatal, TEXT("%s"), *Message);
 }
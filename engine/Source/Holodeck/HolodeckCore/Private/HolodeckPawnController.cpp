@@ -7,12 +7,17 @@
 const FString CONTROL_SCHEME_KEY = "control_scheme";
 const FString TELEPORT_FLAG_KEY = "teleport_flag";
 const FString TELEPORT_COMMAND_KEY = "teleport_command";
+const FString ACTION_SCHEDULE_KEY = "action_schedule";
+const FString ACTION_SCHEDULE_INFO_KEY = "action_schedule_info";
 
 
 AHolodeckPawnController::AHolodeckPawnController(const FObjectInitializer& ObjectInitializer)
 		: AHolodeckPawnControllerInterface(ObjectInitializer) {
 	PrimaryActorTick.bCanEverTick = true;
 	PrimaryActorTick.TickGroup = TG_PrePhysics;
+	ActionScheduleBuffer = nullptr;
+	ActionScheduleInfoBuffer = nullptr;
+	ActionSizeInBytes = 0;
 }
 
 AHolodeckPawnController::~AHolodeckPawnController() { }
@@ -55,6 +60,20 @@ void AHolodeckPawnController::Tick(float DeltaSeconds) {
 		ExecuteTeleport();
 	}
 
+	// If the client uploaded an action schedule, copy the next row into the action buffer.
+	// The info buffer holds the number of rows and the next row to use. Once the schedule
+	// runs out the last row stays in the action buffer and is held.
+	if (ActionScheduleInfoBuffer && ActionScheduleInfoBuffer[0] > 0) {
+		unsigned int Length = FMath::Min(ActionScheduleInfoBuffer[0], MAX_ACTION_SCHEDULE_TICKS);
+		unsigned int Row = FMath::Min(ActionScheduleInfoBuffer[1], Length - 1);
+		FMemory::Memcpy(ActionBuffer, static_cast<uint8*>(ActionScheduleBuffer) + Row * ActionSizeInBytes, ActionSizeInBytes);
+
+		ActionScheduleInfoBuffer[1] = Row + 1;
+		if (ActionScheduleInfoBuffer[1] >= Length)
+			ActionScheduleInfoBuffer[0] = 0;
+	}
+
+	FScopedTelemetry Timer(Server->GetTelemetry(), ETelemetryStage::Control);
 	unsigned int index = *ControlSchemeIdBuffer % ControlSchemes.Num();
 	ControlSchemes[index]->Execute(ControlledAgent->GetRawActionBuffer(), ActionBuffer, DeltaSeconds);
 }
@@ -83,9 +102,17 @@ void AHolodeckPawnController::AllocateBuffers(const FString& AgentName) {
 		}
 
 		void* TempBuffer;
+		ActionSizeInBytes = MaxControlSize;
 		ActionBuffer = Server->Malloc(TCHAR_TO_UTF8(*AgentName),
 									  MaxControlSize);
 
+		ActionScheduleBuffer = Server->Malloc(UHolodeckServer::MakeKey(AgentName, ACTION_SCHEDULE_KEY),
+											  MAX_ACTION_SCHEDULE_TICKS * MaxControlSize);
+
+		TempBuffer = Server->Malloc(UHolodeckServer::MakeKey(AgentName, ACTION_SCHEDULE_INFO_KEY),
+									2 * sizeof(uint32));
+		ActionScheduleInfoBuffer = static_cast<uint32*>(TempBuffer);
+
 		TempBuffer = Server->Malloc(UHolodeckServer::MakeKey(AgentName, CONTROL_SCHEME_KEY),
 											   sizeof(uint8));
 		ControlSchemeIdBuffer = static_cast<uint8*>(TempBuffer);
@@ -152,6 +179,13 @@ void AHolodeckPawnController::ExecuteSetState() {
 	*ShouldChangeStateBuffer = 0;
 }
 
+void AHolodeckPawnController::RestoreSnapshot() {
+	if (ShouldChangeStateBuffer)
+		*ShouldChangeStateBuffer = 0;
+	if (ActionScheduleInfoBuffer)
+		ActionScheduleInfoBuffer[0] = 0;
+}
+
 bool AHolodeckPawnController::CheckBoolBuffer(void* Buffer) {
 	bool* BoolPtr = static_cast<bool*>(Buffer);
 	if (BoolPtr && *BoolPtr) {
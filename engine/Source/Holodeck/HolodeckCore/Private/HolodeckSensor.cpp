@@ -2,6 +2,11 @@
 
 #include "Holodeck.h"
 #include "HolodeckSensor.h"
+#include "HolodeckGameMode.h"
+#include "HolodeckProfiler.h"
+#include "NoiseSeed.h"
+
+#include "Async/ParallelFor.h"
 
 UHolodeckSensor::UHolodeckSensor() {
 	PrimaryComponentTick.bCanEverTick = true;
@@ -18,21 +23,190 @@ void UHolodeckSensor::SetAgentAndController(AHolodeckPawnControllerInterface* Co
 
 void UHolodeckSensor::InitializeSensor() {
 
+	if (NeedsRendering() && AHolodeckGameMode::IsSensorsOnly()) {
+		UE_LOG(LogHolodeck, Fatal, TEXT("UHolodeckSensor::InitializeSensor:: %s on agent %s needs rendering, which is turned off when running sensors only (sensors_only in the scenario). Remove the sensor or turn sensors_only off."), *SensorName, *AgentName);
+		return;
+	}
+
 	if (bOn && Controller != nullptr) {
 		UE_LOG(LogTemp, Warning, TEXT("Getting buffer of size %d"), GetNumItems() * GetItemSize());
 		Buffer = Controller->GetServer()->Malloc(UHolodeckServer::MakeKey(AgentName, SensorName + SensorDataKey), GetNumItems() * GetItemSize());
+		WantedBuffer = static_cast<bool*>(Controller->GetServer()->Malloc(UHolodeckServer::MakeKey(AgentName, SensorName + SensorWantedKey), sizeof(bool)));
+		*WantedBuffer = true;
+
+		if (HistoryLength > 0) {
+			UHolodeckServer* Server = Controller->GetServer();
+			HistoryBuffer = Server->Malloc(UHolodeckServer::MakeKey(AgentName, SensorName + SensorHistoryKey), HistoryLength * GetNumItems() * GetItemSize());
+			HistoryTicksBuffer = static_cast<uint32*>(Server->Malloc(UHolodeckServer::MakeKey(AgentName, SensorName + SensorHistoryTicksKey), HistoryLength * sizeof(uint32)));
+			HistoryIndexBuffer = static_cast<uint32*>(Server->Malloc(UHolodeckServer::MakeKey(AgentName, SensorName + SensorHistoryIndexKey), sizeof(uint32)));
+		}
+
+		ScheduleCaptures();
+
+		AHolodeckAgent* Agent = Cast<AHolodeckAgent>(GetOwner());
+		if (Agent != nullptr && GetAttachParent() != nullptr && GetAttachParent() == Agent->GetRootComponent())
+			AgentKinematics = &Agent->GetKinematics();
+
+		if (IsThreadSafe()) {
+			AHolodeckGameMode* Game = Cast<AHolodeckGameMode>(GetWorld()->GetAuthGameMode());
+			if (Game != nullptr && Game->AddParallelSensor(this))
+				SetComponentTickEnabled(false);
+		}
 	} else {
 		UE_LOG(LogTemp, Warning, TEXT("Getting Controller Failed. Sensor not "));
 	}
 }
 
+void UHolodeckSensor::ParseSensorParms(FString ParmsJson) {
+	TSharedPtr<FJsonObject> JsonParsed;
+	TSharedRef<TJsonReader<TCHAR>> JsonReader = TJsonReaderFactory<TCHAR>::Create(ParmsJson);
+	if (FJsonSerializer::Deserialize(JsonReader, JsonParsed)) {
+		if (JsonParsed->HasTypedField<EJson::Number>("HistoryLength")) {
+			HistoryLength = JsonParsed->GetIntegerField("HistoryLength");
+		}
+
+		if (JsonParsed->HasTypedField<EJson::Number>("CaptureCost")) {
+			CaptureCost = JsonParsed->GetNumberField("CaptureCost");
+		}
+
+		if (JsonParsed->HasTypedField<EJson::Number>("CapturePhase")) {
+			CapturePhase = JsonParsed->GetIntegerField("CapturePhase");
+		}
+	}
+}
+
 void UHolodeckSensor::BeginPlay() {
 	Super::BeginPlay();
 }
 
+void UHolodeckSensor::EndPlay(const EEndPlayReason::Type EndPlayReason) {
+	UHolodeckGameInstance* Instance = static_cast<UHolodeckGameInstance*>(GetWorld()->GetGameInstance());
+	UHolodeckServer* Server = Instance != nullptr ? Instance->GetServer() : nullptr;
+	if (Server != nullptr && Server->GetSensorScheduler() != nullptr)
+		Server->GetSensorScheduler()->Unregister(this);
+
+	AHolodeckGameMode* Game = Cast<AHolodeckGameMode>(GetWorld()->GetAuthGameMode());
+	if (Game != nullptr)
+		Game->RemoveParallelSensor(this);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UHolodeckSensor::ScheduleCaptures() {
+	if (Controller == nullptr || Buffer == nullptr)
+		return;
+
+	SensorScheduler* Scheduler = Controller->GetServer()->GetSensorScheduler();
+	if (Scheduler == nullptr)
+		return;
+
+	if (GetCapturePeriod() > 1)
+		Scheduler->Register(this, GetCapturePeriod(), CaptureCost, CapturePhase);
+	else
+		Scheduler->Unregister(this);
+}
+
+bool UHolodeckSensor::IsCaptureTick() {
+	int Period = GetCapturePeriod();
+	if (Period <= 1)
+		return true;
+
+	UHolodeckServer* Server = Controller->GetServer();
+	SensorScheduler* Scheduler = Server->GetSensorScheduler();
+	if (Scheduler == nullptr)
+		return Server->GetTickCount() % Period == 0;
+	return Scheduler->IsDue(this, Server->GetTickCount());
+}
+
+int UHolodeckSensor::TicksUntilCapture() {
+	int Period = GetCapturePeriod();
+	if (Period <= 1)
+		return 0;
+
+	UHolodeckServer* Server = Controller->GetServer();
+	SensorScheduler* Scheduler = Server->GetSensorScheduler();
+	if (Scheduler == nullptr)
+		return (Period - Server->GetTickCount() % Period) % Period;
+	return Scheduler->TicksUntilDue(this, Server->GetTickCount());
+}
+
 void UHolodeckSensor::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 
-	if (bOn && Buffer != nullptr)
-		TickSensorComponent(DeltaTime, TickType, ThisTickFunction);
+	if (bOn && Buffer != nullptr) {
+		UpdateKinematics(DeltaTime);
+		double Ms = RunTick(DeltaTime, TickType, ThisTickFunction);
+
+		HolodeckTelemetry* Telemetry = Controller->GetServer()->GetTelemetry();
+		if (Telemetry != nullptr)
+			Telemetry->AddSensorTime(AgentName, SensorName, Ms);
+	}
+}
+
+double UHolodeckSensor::RunTick(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) {
+	double StartMs = HolodeckTelemetry::NowMs();
+	TickSensorComponent(DeltaTime, TickType, ThisTickFunction);
+	double Ms = HolodeckTelemetry::NowMs() - StartMs;
+
+	if (HistoryBuffer != nullptr && HasNewData())
+		RecordHistory();
+
+	return Ms;
+}
+
+void UHolodeckSensor::TickParallel(const TArray<UHolodeckSensor*>& Sensors, float DeltaTime, ELevelTick TickType, bool bForceSingleThread) {
+	HOLODECK_PROFILE_ZONE("Sensors::TickParallel");
+
+	// Physics can only be read from the game thread
+	TArray<UHolodeckSensor*> Active;
+	for (UHolodeckSensor* Sensor : Sensors) {
+		if (!Sensor->bOn || Sensor->Buffer == nullptr)
+			continue;
+
+		Sensor->UpdateKinematics(DeltaTime);
+		Active.Add(Sensor);
+	}
+
+	TArray<double> Ms;
+	Ms.SetNumZeroed(Active.Num());
+
+	uint64 Zone = HolodeckProfiler::CurrentZone();
+	ParallelFor(Active.Num(), [&](int32 i) {
+		HOLODECK_PROFILE_ZONE_PARENT("Sensors::TickParallel::sensor", Zone);
+		UHolodeckSensor* Sensor = Active[i];
+		Ms[i] = Sensor->RunTick(DeltaTime, TickType, &Sensor->PrimaryComponentTick);
+	}, bForceSingleThread || NoiseSeed::IsSeeded());
+
+	// Telemetry isn't thread safe, so the timings are added once everything is done
+	for (int32 i = 0; i < Active.Num(); i++) {
+		HolodeckTelemetry* Telemetry = Active[i]->Controller->GetServer()->GetTelemetry();
+		if (Telemetry != nullptr)
+			Telemetry->AddSensorTime(Active[i]->AgentName, Active[i]->SensorName, Ms[i]);
+	}
+}
+
+void UHolodeckSensor::UpdateKinematics(float DeltaTime) {
+	if (AgentKinematics != nullptr)
+		return;
+
+	if (UPrimitiveComponent* Body = Cast<UPrimitiveComponent>(GetAttachParent()))
+		LocalKinematics.Update(Body, DeltaTime);
+}
+
+void UHolodeckSensor::SaveSnapshot() {
+	SnapshotLocalKinematics = LocalKinematics;
+}
+
+void UHolodeckSensor::RestoreSnapshot() {
+	// Like the agent's, so the first acceleration after the restore isn't computed across the jump
+	LocalKinematics = SnapshotLocalKinematics;
+}
+
+void UHolodeckSensor::RecordHistory() {
+	int SampleSize = GetNumItems() * GetItemSize();
+	uint32 Slot = *HistoryIndexBuffer % HistoryLength;
+
+	FMemory::Memcpy(static_cast<uint8*>(HistoryBuffer) + Slot * SampleSize, Buffer, SampleSize);
+	HistoryTicksBuffer[Slot] = Controller->GetServer()->GetTickCount();
+	(*HistoryIndexBuffer)++;
 }
@@ -2,11 +2,19 @@
 
 #include "Holodeck.h"
 #include "HolodeckServer.h"
+#include "HolodeckProfiler.h"
+
+const char TICK_SCHEDULE_KEY[] = "tick_schedule";
 
 UHolodeckServer::UHolodeckServer() {
     // Warning -- This class gets initialized a few times by Unreal because it is a UObject.
     // DO NOT rely on singleton-qualities in the constructor, only in the Start() function
     bIsRunning = false;
+    ScheduleBuffer = nullptr;
+    ScheduleLength = 1;
+    ScheduleTick = 0;
+    TickCount = 0;
+    AcquireMs = 0;
 }
 
 UHolodeckServer::~UHolodeckServer() {
@@ -53,6 +61,15 @@ void UHolodeckServer::Start() {
     // Client unlinks LoadingSemaphore
 #endif
 
+    Recorder = TickRecorder::FromCommandLine();
+    HolodeckProfiler::CaptureFromCommandLine();
+
+    ScheduleBuffer = static_cast<uint32*>(Malloc(TICK_SCHEDULE_KEY, sizeof(uint32)));
+    Telemetry.reset(new HolodeckTelemetry(Malloc(TELEMETRY_KEY, HolodeckTelemetry::BufferSize())));
+    Scheduler.reset(new SensorScheduler(Malloc(SENSOR_SCHEDULE_KEY, SensorScheduler::BufferSize())));
+    ScheduleLength = 1;
+    ScheduleTick = 0;
+
     bIsRunning = true;
     UE_LOG(LogHolodeck, Log, TEXT("HolodeckServer started successfully"));
 }
@@ -61,7 +78,15 @@ void UHolodeckServer::Kill() {
     UE_LOG(LogHolodeck, Log, TEXT("Killing HolodeckServer"));
     if (!bIsRunning) return;
 
+    if (Recorder != nullptr) {
+        Recorder->Finish(Memory);
+        Recorder.reset();
+    }
+
+    Telemetry.reset();
+    Scheduler.reset();
     Memory.clear();
+    ScheduleBuffer = nullptr;
 
 #if PLATFORM_WINDOWS
     CloseHandle(this->LockingSemaphore1);
@@ -93,6 +118,11 @@ void* UHolodeckServer::Malloc(const std::string& Key, unsigned int BufferSize) {
 
 void UHolodeckServer::Acquire() {
     UE_LOG(LogHolodeck, VeryVerbose, TEXT("HolodeckServer Acquiring"));
+    // There's no client to wait on during a replay
+    if (IsReplaying()) return;
+
+    HOLODECK_PROFILE_ZONE("Server::Acquire");
+    double StartMs = HolodeckTelemetry::NowMs();
 #if PLATFORM_WINDOWS
     WaitForSingleObject(this->LockingSemaphore1, INFINITE);
 #elif PLATFORM_LINUX
@@ -102,10 +132,15 @@ void UHolodeckServer::Acquire() {
         LogSystemError("Unable to wait for server semaphore");
     }
 #endif
+    AcquireMs = HolodeckTelemetry::NowMs() - StartMs;
 }
 
 void UHolodeckServer::Release() {
     UE_LOG(LogHolodeck, VeryVerbose, TEXT("HolodeckServer Releasing"));
+    if (IsReplaying()) return;
+
+    HOLODECK_PROFILE_ZONE("Server::Release");
+
 #if PLATFORM_WINDOWS
     ReleaseSemaphore(this->LockingSemaphore2, 1, NULL);
 #elif PLATFORM_LINUX
@@ -117,6 +152,48 @@ void UHolodeckServer::Release() {
 #endif
 }
 
+void UHolodeckServer::BeginSchedule() {
+    TickCount++;
+    ScheduleTick = 0;
+    ScheduleLength = 1;
+    if (ScheduleBuffer != nullptr) {
+        if (*ScheduleBuffer > 1)
+            ScheduleLength = *ScheduleBuffer;
+        *ScheduleBuffer = 0;
+    }
+    StartTick();
+}
+
+bool UHolodeckServer::AdvanceSchedule() {
+    if (ScheduleTick + 1 >= ScheduleLength)
+        return false;
+    TickCount++;
+    ScheduleTick++;
+    AcquireMs = 0;
+    StartTick();
+    return true;
+}
+
+void UHolodeckServer::StartTick() {
+    HolodeckProfiler::OnTick();
+
+    if (Telemetry != nullptr)
+        Telemetry->StartTick(AcquireMs);
+
+    if (Recorder != nullptr) {
+        Recorder->Tick(TickCount, Memory);
+        if (Recorder->IsFinished())
+            FGenericPlatformMisc::RequestExit(false);
+    }
+}
+
+void UHolodeckServer::EndTick() {
+    if (Recorder != nullptr)
+        Recorder->EndTick(Memory);
+    if (Telemetry != nullptr)
+        Telemetry->EndTick(TickCount);
+}
+
 bool UHolodeckServer::IsRunning() const {
     return bIsRunning;
 }
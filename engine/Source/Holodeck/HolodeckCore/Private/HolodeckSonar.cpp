@@ -2,8 +2,20 @@
 
 #include "Holodeck.h"
 #include "Benchmarker.h"
+#include "HolodeckProfiler.h"
 #include "HolodeckBuoyantAgent.h"
+#include "HolodeckGameMode.h"
 #include "HolodeckSonar.h"
+#include "NoiseSeed.h"
+
+// Enough foundLeaves to cover all possible threads, 1000 should be plenty
+static const int32 NumLeafSlots = 1000;
+
+FSonarCapture::~FSonarCapture(){
+	for(TArray<Octree*>& pool : leafPool){
+		for(Octree* l : pool) delete l;
+	}
+}
 
 float UHolodeckSonar::ATan2Approx(float y, float x){
     //http://pubs.opengroup.org/onlinepubs/009695399/functions/atan2.html
@@ -73,6 +85,9 @@ void UHolodeckSonar::ParseSensorParms(FString ParmsJson) {
 		}
 
 		// Performance Parameters
+		if (JsonParsed->HasTypedField<EJson::Number>("OctreeMin")) {
+			OctreeMin = JsonParsed->GetNumberField("OctreeMin")*100;
+		}
 		if (JsonParsed->HasTypedField<EJson::Number>("ShadowEpsilon")) {
 			ShadowEpsilon = JsonParsed->GetNumberField("ShadowEpsilon")*100;
 		}
@@ -93,8 +108,20 @@ void UHolodeckSonar::ParseSensorParms(FString ParmsJson) {
 		InitOctreeRange = RangeMax;
 	}
 
+	AHolodeckGameMode* Game = Cast<AHolodeckGameMode>(GetWorld()->GetAuthGameMode());
+	octreeContext = Game ? Game->GetOctreeContext() : nullptr;
+	if(octreeContext == nullptr){
+		UE_LOG(LogHolodeck, Fatal, TEXT("UHolodeckSonar::ParseSensorParms:: Octrees haven't been set up, is the game mode a HolodeckGameMode?"));
+		return;
+	}
+
+	if(OctreeMin <= 0){
+		OctreeMin = octreeContext->OctreeMin;
+	}
+	OctreeMax = octreeContext->resolution(OctreeMin).max;
+
 	if(ShadowEpsilon == 0){
-		ShadowEpsilon = 4*Octree::OctreeMin;
+		ShadowEpsilon = 4*OctreeMin;
 	}
 
 	minAzimuth = -Azimuth/2;
@@ -106,26 +133,94 @@ void UHolodeckSonar::ParseSensorParms(FString ParmsJson) {
 
 	sqrt3_2 = UKismetMathLibrary::Sqrt(3) / 2;
 	sinOffset = UKismetMathLibrary::DegSin(FGenericPlatformMath::Min(Azimuth, Elevation)/2);
+
+	// Made again with the new settings next time they're needed
+	capture.Reset();
+	poseCaptures.Reset();
+}
+
+void UHolodeckSonar::InitializeSensor() {
+	Super::InitializeSensor();
+
+	if (bOn && Controller != nullptr) {
+		StatusBuffer = static_cast<uint32*>(Controller->GetServer()->Malloc(UHolodeckServer::MakeKey(AgentName, SensorName + OctreeStatusKey), 3 * sizeof(uint32)));
+		updateStatus();
+	}
+}
+
+void UHolodeckSonar::EndPlay(const EEndPlayReason::Type EndPlayReason) {
+	stopPremake();
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void UHolodeckSonar::BeginDestroy() {
 	Super::BeginDestroy();
 
+	stopPremake();
+	capture.Reset();
+	poseCaptures.Reset();
 	delete octree;
 }
 
-void UHolodeckSonar::initOctree(){
-	// We delay making trees till the message has been printed to the screen
-	if(toMake.Num() != 0 && TickCounter >= 8){
-		UE_LOG(LogHolodeck, Log, TEXT("Sonar::Initial building num: %d"), toMake.Num());
+void UHolodeckSonar::premakeOctrees(){
+	UE_LOG(LogHolodeck, Log, TEXT("Sonar::Initial building num: %d"), toMake.Num());
+	premakeDone = 0;
+	premakeCancel = false;
+	premakeTotal = toMake.Num();
+
+	// Nothing on the game thread touches toMake or the tiles in it until the task is done,
+	// the sonar doesn't search the octree before then
+	premakeTask = Async(EAsyncExecution::ThreadPool, [this](){
+		HOLODECK_PROFILE_ZONE("Sonar::premakeOctrees");
+		uint64 Zone = HolodeckProfiler::CurrentZone();
 		ParallelFor(toMake.Num(), [&](int32 i){
-			toMake.GetData()[i]->load();
+			if(premakeCancel) return;
+			HOLODECK_PROFILE_ZONE_PARENT("Sonar::premakeOctrees::tile", Zone);
+			toMake.GetData()[i]->load(*octreeContext);
 			toMake.GetData()[i]->unload();
+			++premakeDone;
 		});
+	});
+}
+
+void UHolodeckSonar::stopPremake(){
+	if(premakeTask.IsValid()){
+		premakeCancel = true;
+		premakeTask.Wait();
+		premakeTask = TFuture<void>();
+	}
+}
+
+void UHolodeckSonar::updateStatus(){
+	if(StatusBuffer == nullptr) return;
+
+	if(octree == nullptr) StatusBuffer[0] = OctreeWaiting;
+	else if(toMake.Num() != 0) StatusBuffer[0] = OctreeBuilding;
+	else StatusBuffer[0] = OctreeReady;
+	StatusBuffer[1] = toMake.Num() != 0 ? premakeDone.load() : premakeTotal;
+	StatusBuffer[2] = premakeTotal;
+}
+
+void UHolodeckSonar::initOctree(){
+	// Once the background build is done, the sonar can start making images
+	if(toMake.Num() != 0 && premakeTask.IsValid() && premakeTask.IsReady()){
+		UE_LOG(LogHolodeck, Log, TEXT("Sonar::Finished initial building"));
+		premakeTask = TFuture<void>();
 		toMake.Empty();
 		GEngine->AddOnScreenDebugMessage(-1, 2.0f, FColor::Red, TEXT("Finished."));
 	}
 
+	// Swap in tiles that were rebuilt around props that changed. It's done between captures, so
+	// none of them sees half of it, and the background build is left to finish first
+	if(octree != nullptr && toMake.Num() == 0){
+		TArray<OctreeContext::TileUpdate> updates;
+		octreeGeneration = octreeContext->updatesSince(octreeGeneration, updates);
+		for(const OctreeContext::TileUpdate& update : updates){
+			if(update.min == OctreeMin) octree->replaceTile(*octreeContext, update);
+		}
+	}
+
 	// If we haven't made it yet
 	if(octree == nullptr && TickCounter >= 5){
 		// initialize small octree for each agent
@@ -133,50 +228,37 @@ void UHolodeckSonar::initOctree(){
 			// skip ourselves
 			if(agent.Value == this->GetAttachmentRootActor()) continue;
 			AHolodeckBuoyantAgent* bouyantActor = static_cast<AHolodeckBuoyantAgent*>(agent.Value);
-			Octree* l = bouyantActor->makeOctree();
+			Octree* l = bouyantActor->makeOctree(*octreeContext, OctreeMin);
 			if(l) agents.Add(l);
 		}
 		
 		// Ignore necessary agents to make world one
 		for(auto& agent : Controller->GetServer()->AgentMap){
 			AActor* actor = static_cast<AActor*>(agent.Value);
-			Octree::ignoreActor(actor);
+			octreeContext->ignoreActor(actor);
 		}
-		// make/load octree
-		octree = Octree::makeEnvOctreeRoot();
+		// make/load octree. Tiles rebuilt before now are already loaded from their rebuilt files
+		TArray<OctreeContext::TileUpdate> earlier;
+		octreeGeneration = octreeContext->updatesSince(octreeGeneration, earlier);
+		octree = Octree::makeEnvOctreeRoot(*octreeContext, OctreeMin);
 
 		// Premake octrees within range
 		FVector loc = this->GetComponentLocation();
 		// Offset by size of OctreeMax radius to get everything in range
-		float offset = InitOctreeRange + Octree::OctreeMax*FMath::Sqrt(3)/2;
-		// recursively search for close leaves
-		std::function<void(Octree*, TArray<Octree*>&)> findCloseLeaves;
-		findCloseLeaves = [&offset, &loc, &findCloseLeaves](Octree* tree, TArray<Octree*>& list){
-			if(tree->size == Octree::OctreeMax){
-				if((loc - tree->loc).Size() <= offset && !FPaths::FileExists(tree->file)){
-					list.Add(tree);
-				}
-			}
-			else{
-				for(Octree* l : tree->leaves){
-					findCloseLeaves(l, list);
-				}
-			}
-		};
-		findCloseLeaves(octree, toMake);
-		if(toMake.Num() != 0)
-			GEngine->AddOnScreenDebugMessage(-1, 2.0f, FColor::Red, FString::Printf(TEXT("Premaking %d Octrees, will take some time..."), toMake.Num()));
-
-		// get all our Leaves ready
-		bigLeaves.Reserve(1000);
-		// We need enough foundLeaves to cover all possible threads
-		// 1000 should be plenty
-		foundLeaves.Reserve(1000);
-		for(int i=0;i<1000;i++){
-			foundLeaves.Add(TArray<Octree*>());
-			foundLeaves[i].Reserve(10000);
+		float offset = InitOctreeRange + OctreeMax*FMath::Sqrt(3)/2;
+		// search for close leaves that haven't been saved yet
+		TArray<Octree*> closeLeaves;
+		octree->tilesNear(*octreeContext, loc, offset, closeLeaves);
+		for(Octree* tree : closeLeaves){
+			if(!FPaths::FileExists(tree->file)) toMake.Add(tree);
+		}
+		if(toMake.Num() != 0){
+			GEngine->AddOnScreenDebugMessage(-1, 2.0f, FColor::Red, FString::Printf(TEXT("Premaking %d Octrees in the background, sonar will start once they're done..."), toMake.Num()));
+			premakeOctrees();
 		}
 	}
+
+	updateStatus();
 }
 
 void UHolodeckSonar::viewLeaves(Octree* tree){
@@ -190,92 +272,198 @@ void UHolodeckSonar::viewLeaves(Octree* tree){
 	}
 }
 
-bool UHolodeckSonar::inRange(Octree* tree){
-	FTransform SensortoWorld = this->GetComponentTransform();
+bool UHolodeckSonar::inRange(const FSonarCapture& capture, const FVector& loc, float size, FVector& locSpherical){
+	FTransform SensortoWorld = capture.SensorToWorld;
 	// if it's not a leaf, we use a bigger search area
 	float offset = 0;
 	float radius = 0;
-	if(tree->size != Octree::OctreeMin){
-		radius = tree->size*sqrt3_2;
+	if(size != OctreeMin){
+		radius = size*sqrt3_2;
 		offset = radius/sinOffset;
-		SensortoWorld.AddToTranslation( -this->GetForwardVector()*offset );
+		SensortoWorld.AddToTranslation( -SensortoWorld.GetUnitAxis(EAxis::X)*offset );
 	}
 
 	// transform location to sensor frame
-	// FVector locLocal = SensortoWorld.InverseTransformPositionNoScale(tree->loc);
-	FVector locLocal = SensortoWorld.GetRotation().UnrotateVector(tree->loc-SensortoWorld.GetTranslation());
+	// FVector locLocal = SensortoWorld.InverseTransformPositionNoScale(loc);
+	FVector locLocal = SensortoWorld.GetRotation().UnrotateVector(loc-SensortoWorld.GetTranslation());
 
 	// check if it's in range
-	tree->locSpherical.X = locLocal.Size();
-	if(RangeMin+offset-radius >= tree->locSpherical.X || tree->locSpherical.X >= RangeMax+offset+radius) return false; 
+	locSpherical.X = locLocal.Size();
+	if(RangeMin+offset-radius >= locSpherical.X || locSpherical.X >= RangeMax+offset+radius) return false; 
 
 	// check if azimuth is in
-	tree->locSpherical.Y = ATan2Approx(-locLocal.Y, locLocal.X);
-	if(minAzimuth >= tree->locSpherical.Y || tree->locSpherical.Y >= maxAzimuth) return false;
+	locSpherical.Y = ATan2Approx(-locLocal.Y, locLocal.X);
+	if(minAzimuth >= locSpherical.Y || locSpherical.Y >= maxAzimuth) return false;
 
 	// check if elevation is in
-	tree->locSpherical.Z = ATan2Approx(locLocal.Size2D(), locLocal.Z);
-	if(minElev >= tree->locSpherical.Z || tree->locSpherical.Z >= maxElev) return false;
+	locSpherical.Z = ATan2Approx(locLocal.Size2D(), locLocal.Z);
+	if(minElev >= locSpherical.Z || locSpherical.Z >= maxElev) return false;
 	
 	// otherwise it's in!
 	return true;
 }	
 
-void UHolodeckSonar::leavesInRange(Octree* tree, TArray<Octree*>& rLeaves, float stopAt){
-	bool in = inRange(tree);
-	if(in){
-		if(tree->size == stopAt){
-			if(stopAt == Octree::OctreeMin){
-				// Compute contribution while we're parallelized
-				// If no contribution, we don't have to add it in
-				tree->normalImpact = GetComponentLocation() - tree->loc; 
-				tree->normalImpact.Normalize();
-
-				// compute contribution
-				float cos = FVector::DotProduct(tree->normal, tree->normalImpact);
-				if(cos > 0){
-					tree->cos = cos;
-					rLeaves.Add(tree);
-				} 
-			}
-			else{
-				rLeaves.Add(tree);
-			}
+void UHolodeckSonar::tilesInRange(FSonarCapture& capture, Octree* tree, bool unloadFar){
+	FVector locSpherical;
+	if(inRange(capture, tree->loc, tree->size, locSpherical)){
+		if(tree->size == OctreeMax){
+			capture.bigLeaves.Add(tree);
 			return;
 		}
 
+		// the index above the tiles is made as we get near it
+		if(tree->isIndex()) tree->load(*octreeContext);
 		for(Octree* l : tree->leaves){
-			leavesInRange(l, rLeaves, stopAt);
+			tilesInRange(capture, l, unloadFar);
 		}
 	}
-	else if(tree->size >= Octree::OctreeMax){
+	else if(unloadFar && tree->size >= OctreeMax){
 		tree->unload();
 	}
 }
 
-void UHolodeckSonar::findLeaves(){
-	// Empty everything out
-	bigLeaves.Reset();
-	for(auto& fl: foundLeaves){
-		fl.Reset();
+void UHolodeckSonar::leavesInRange(FSonarCapture& capture, Octree* tree, int32 slot){
+	if(tree->size == OctreeMin){
+		addLeaf(capture, tree->loc, tree->size, tree->normal, tree->z, slot);
+		return;
+	}
+
+	FVector locSpherical;
+	if(!inRange(capture, tree->loc, tree->size, locSpherical)) return;
+	for(Octree* l : tree->leaves){
+		leavesInRange(capture, l, slot);
+	}
+}
+
+void UHolodeckSonar::leavesInRange(FSonarCapture& capture, const OctreeDag* dag, int32 node, const FVector& loc, float size, int32 slot){
+	// DAG nodes don't know where they are, so work it out on the way down
+	const uint32* child = dag->nodes.GetData() + node;
+	uint32 mask = *child++;
+	float childSize = size/2;
+	FVector locSpherical;
+	for(int32 i=0;i<8;i++){
+		if(!(mask & 1 << i)) continue;
+		int32 index = *child++;
+		FVector childLoc = loc + OctreeCodec::cornerOf(i)*size/4;
+
+		if(childSize != OctreeMin){
+			if(inRange(capture, childLoc, childSize, locSpherical)) leavesInRange(capture, dag, index, childLoc, childSize, slot);
+			continue;
+		}
+		addLeaf(capture, childLoc, childSize, dag->normalOf(index), dag->impedanceOf(index), slot);
+	}
+}
+
+void UHolodeckSonar::leavesInRange(FSonarCapture& capture, const OctreeTileCache::Node* node, float size, int32 slot){
+	// Other instances read the same nodes, so nothing is written to them. Each child is
+	// followed by everything under it, so the next one is numNodes further on
+	const OctreeTileCache::Node* child = node + 1;
+	float childSize = size/2;
+	FVector locSpherical;
+	for(uint32 i=0;i<node->numLeaves;i++, child += child->numNodes){
+		if(childSize != OctreeMin){
+			if(inRange(capture, child->loc, childSize, locSpherical)) leavesInRange(capture, child, childSize, slot);
+			continue;
+		}
+		addLeaf(capture, child->loc, childSize, child->normal, child->z, slot);
+	}
+}
+
+void UHolodeckSonar::addLeaf(FSonarCapture& capture, const FVector& loc, float size, const FVector& normal, float z, int32 slot){
+	// Borrow an Octree to hold the leaf's values for the rest of the capture
+	TArray<Octree*>& pool = capture.leafPool.GetData()[slot];
+	int32& used = capture.leafPoolUsed.GetData()[slot];
+	if(used == pool.Num()) pool.Add(new Octree);
+	Octree* l = pool.GetData()[used];
+	l->loc = loc;
+	l->size = size;
+	if(!inRange(capture, l->loc, l->size, l->locSpherical)) return;
+
+	// Compute contribution while we're parallelized
+	// If no contribution, we don't have to add it in
+	l->normal = normal;
+	l->normalImpact = capture.SensorToWorld.GetLocation() - l->loc;
+	l->normalImpact.Normalize();
+	float cos = FVector::DotProduct(l->normal, l->normalImpact);
+	if(cos > 0){
+		l->cos = cos;
+		l->z = z;
+		capture.foundLeaves.GetData()[slot].Add(l);
+		++used;
+	}
+}
+
+TUniquePtr<FSonarCapture> UHolodeckSonar::makeCapture(){
+	return MakeUnique<FSonarCapture>();
+}
+
+void UHolodeckSonar::captureImage(){
+	if(!capture.IsValid()){
+		capture = makeCapture();
+		// get all our Leaves ready
+		capture->bigLeaves.Reserve(1000);
+		capture->foundLeaves.SetNum(NumLeafSlots);
+		for(auto& fl : capture->foundLeaves){
+			fl.Reserve(10000);
+		}
+		for(auto& sl : capture->sortedLeaves){
+			sl.Reserve(10000);
+		}
 	}
 
+	capture->SensorToWorld = GetComponentTransform();
+	findTiles(*capture, true);
+	loadTiles(capture->bigLeaves);
+	computeImage(*capture, static_cast<float*>(Buffer));
+}
+
+void UHolodeckSonar::findTiles(FSonarCapture& capture, bool unloadFar){
+	HOLODECK_PROFILE_ZONE("Sonar::findTiles");
+
 	// FILTER TO GET THE bigLeaves WE WANT
-	leavesInRange(octree, bigLeaves, Octree::OctreeMax);
-	bigLeaves += agents;
+	capture.bigLeaves.Reset();
+	tilesInRange(capture, octree, unloadFar);
+	capture.bigLeaves += agents;
+}
 
-	ParallelFor(bigLeaves.Num(), [&](int32 i){
-		Octree* leaf = bigLeaves.GetData()[i];
-		leaf->load();
-		for(Octree* l : leaf->leaves)
-			leavesInRange(l, foundLeaves.GetData()[i%1000], Octree::OctreeMin);
+void UHolodeckSonar::loadTiles(const TArray<Octree*>& tiles){
+	HOLODECK_PROFILE_ZONE("Sonar::loadTiles");
+	uint64 Zone = HolodeckProfiler::CurrentZone();
+	ParallelFor(tiles.Num(), [&](int32 i){
+		HOLODECK_PROFILE_ZONE_PARENT("Sonar::loadTiles::tile", Zone);
+		tiles.GetData()[i]->load(*octreeContext);
 	});
 }
 
-void UHolodeckSonar::shadowLeaves(){
-	ParallelFor(sortedLeaves.Num(), [&](int32 i){
-		TArray<Octree*>& binLeafs = sortedLeaves.GetData()[i]; 
+void UHolodeckSonar::findLeaves(FSonarCapture& capture){
+	HOLODECK_PROFILE_ZONE("Sonar::findLeaves");
 
+	// Empty everything out
+	capture.foundLeaves.SetNum(NumLeafSlots);
+	capture.leafPool.SetNum(NumLeafSlots);
+	capture.leafPoolUsed.Init(0, NumLeafSlots);
+	for(auto& fl: capture.foundLeaves){
+		fl.Reset();
+	}
+
+	uint64 Zone = HolodeckProfiler::CurrentZone();
+	ParallelFor(capture.bigLeaves.Num(), [&](int32 i){
+		HOLODECK_PROFILE_ZONE_PARENT("Sonar::findLeaves::leaf", Zone);
+		Octree* leaf = capture.bigLeaves.GetData()[i];
+		int32 slot = i%NumLeafSlots;
+		for(Octree* l : leaf->leaves)
+			leavesInRange(capture, l, slot);
+		if(leaf->dag != nullptr && leaf->dag->root != INDEX_NONE)
+			leavesInRange(capture, leaf->dag, leaf->dag->root, leaf->loc, leaf->size, slot);
+		if(leaf->shared != nullptr)
+			leavesInRange(capture, leaf->shared, leaf->size, slot);
+	});
+}
+
+void UHolodeckSonar::shadowLeaves(FSonarCapture& capture){
+	HOLODECK_PROFILE_ZONE("Sonar::shadowLeaves");
+	ParallelFor(capture.sortedLeaves.Num(), [&](int32 i){
+		TArray<Octree*>& binLeafs = capture.sortedLeaves.GetData()[i]; 
 		// sort from closest to farthest
 		binLeafs.Sort([](const Octree& a, const Octree& b){
 			return a.locSpherical.X < b.locSpherical.X;
@@ -305,8 +493,8 @@ void UHolodeckSonar::shadowLeaves(){
 
 void UHolodeckSonar::showBeam(float DeltaTime){
 	// draw points inside our region
-	if(ViewOctree >= -1){
-		for( TArray<Octree*> bins : sortedLeaves){
+	if(ViewOctree >= -1 && capture.IsValid()){
+		for( TArray<Octree*>& bins : capture->sortedLeaves){
 			for( Octree* l : bins){
 				if(ViewOctree == -1 || ViewOctree == l->idx.Y){
 					DrawDebugPoint(GetWorld(), l->loc, 5, FColor::Red, false, DeltaTime*TicksPerCapture);
@@ -342,6 +530,58 @@ void UHolodeckSonar::showRegion(float DeltaTime){
 	}		
 }
 
+void UHolodeckSonar::SaveSnapshot() {
+	Super::SaveSnapshot();
+	SnapshotTickCounter = TickCounter;
+}
+
+void UHolodeckSonar::RestoreSnapshot() {
+	Super::RestoreSnapshot();
+	TickCounter = SnapshotTickCounter;
+}
+
+int UHolodeckSonar::RenderPoses(const TArray<FTransform>& Poses, float* Output) {
+	if(octree == nullptr || toMake.Num() != 0){
+		UE_LOG(LogHolodeck, Warning, TEXT("UHolodeckSonar::RenderPoses:: The octree for %s isn't ready yet, tick the world a few more times first."), *SensorName);
+		return 0;
+	}
+
+	HOLODECK_PROFILE_ZONE("Sonar::RenderPoses");
+
+	// One capture for each worker, the images are made on the task graph
+	if(PoseCaptures == 0) PoseCaptures = FMath::Max(1, FTaskGraphInterface::Get().GetNumWorkerThreads());
+	if(poseCaptures.Num() < FMath::Min(PoseCaptures, Poses.Num())){
+		poseCaptures.SetNum(FMath::Min(PoseCaptures, Poses.Num()));
+	}
+	for(TUniquePtr<FSonarCapture>& c : poseCaptures){
+		if(!c.IsValid()) c = makeCapture();
+	}
+
+	// Poses are done a capture's worth at a time. The tiles are found and loaded for all of
+	// them first, since that can change the octree, then their images are made at once
+	int ImageSize = GetNumItems();
+	TArray<Octree*> tiles;
+	for(int start=0;start<Poses.Num();start+=poseCaptures.Num()){
+		int num = FMath::Min(poseCaptures.Num(), Poses.Num()-start);
+		tiles.Reset();
+		for(int i=0;i<num;i++){
+			FSonarCapture& c = *poseCaptures[i];
+			c.SensorToWorld = Poses[start+i];
+			// So a pose's noise doesn't depend on what it's batched with
+			c.reseed(NoiseSeed::Next());
+			findTiles(c, false);
+			for(Octree* t : c.bigLeaves) tiles.AddUnique(t);
+		}
+		loadTiles(tiles);
+
+		ParallelFor(num, [&](int32 i){
+			computeImage(*poseCaptures[i], Output + (start+i)*ImageSize);
+		});
+	}
+
+	return Poses.Num();
+}
+
 FVector UHolodeckSonar::spherToEuc(float r, float theta, float phi, FTransform SensortoWorld){
 	float x = r*UKismetMathLibrary::DegSin(phi)*UKismetMathLibrary::DegCos(theta);
 	float y = r*UKismetMathLibrary::DegSin(phi)*UKismetMathLibrary::DegSin(theta);
@@ -362,11 +602,14 @@ void UHolodeckSonar::TickSensorComponent(float DeltaTime, ELevelTick TickType, F
 
 	// Count till next sonar timestep
 	TickCounter++;
-	// Show warning when we're about to compute sonar
-	if(ShowWarning && TicksPerCapture - TickCounter <= 3){
+	// Show warning when we're about to compute sonar. TickCounter keeps going while captures are
+	// skipped, so it's the schedule that says when the next one is
+	if(ShowWarning && IsWanted() && TicksUntilCapture() <= 3){
 		GEngine->AddOnScreenDebugMessage(-1, DeltaTime, FColor::Red, FString::Printf(TEXT("Sonar octree generation may slow down simulation, screen may appear frozen temporarily")));
 	}
-	if(TickCounter % TicksPerCapture == 0 && octree != nullptr && toMake.Num() == 0){
+	// The scheduler staggers the ticks sonars capture on, so they don't all land on the same one.
+	// Captures the client won't read are skipped, the counter just keeps going
+	if(IsCaptureTick() && IsWanted() && octree != nullptr && toMake.Num() == 0){
 		TickCounter = 0;
 	}
 }
\ No newline at end of file
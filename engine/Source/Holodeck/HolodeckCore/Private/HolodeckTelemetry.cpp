@@ -0,0 +1,51 @@
+// MIT License (c) 2021 BYU FRoStLab see LICENSE file
+
+#include "Holodeck.h"
+#include "HolodeckTelemetry.h"
+
+static void CopyName(char* Dest, const FString& Name) {
+	FTCHARToUTF8 Converted(*Name);
+	int Length = FMath::Min(Converted.Length(), TELEMETRY_NAME_LENGTH);
+	FMemory::Memzero(Dest, TELEMETRY_NAME_LENGTH);
+	FMemory::Memcpy(Dest, Converted.Get(), Length);
+}
+
+HolodeckTelemetry::HolodeckTelemetry(void* Buffer) :
+		Header(static_cast<FTelemetryHeader*>(Buffer)),
+		Sensors(reinterpret_cast<FSensorTelemetry*>(static_cast<uint8*>(Buffer) + sizeof(FTelemetryHeader))),
+		TickStartMs(NowMs()), NumSensors(0) {
+	FMemory::Memzero(Buffer, BufferSize());
+	FMemory::Memzero(StageMs, sizeof(StageMs));
+}
+
+void HolodeckTelemetry::StartTick(double AcquireMs) {
+	TickStartMs = NowMs();
+	FMemory::Memzero(StageMs, sizeof(StageMs));
+	StageMs[(int)ETelemetryStage::Acquire] = AcquireMs;
+	NumSensors = 0;
+}
+
+void HolodeckTelemetry::EndTick(uint32 Tick) {
+	Header->Tick = Tick;
+	Header->NumSensors = NumSensors;
+	Header->TickMs = NowMs() - TickStartMs;
+	for (int i = 0; i < (int)ETelemetryStage::Count; i++)
+		Header->StageMs[i] = StageMs[i];
+}
+
+void HolodeckTelemetry::AddStageTime(ETelemetryStage Stage, double Ms) {
+	StageMs[(int)Stage] += Ms;
+}
+
+void HolodeckTelemetry::AddSensorTime(const FString& Agent, const FString& Sensor, double Ms) {
+	if (NumSensors >= MAX_TELEMETRY_SENSORS)
+		return;
+
+	// Entries are written straight to shared memory, the client only reads
+	// them once EndTick has published the count
+	FSensorTelemetry& Entry = Sensors[NumSensors++];
+	CopyName(Entry.Agent, Agent);
+	CopyName(Entry.Sensor, Sensor);
+	Entry.Ms = Ms;
+	Entry.Reserved = 0;
+}
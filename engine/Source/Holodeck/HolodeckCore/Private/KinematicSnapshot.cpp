@@ -0,0 +1,31 @@
+// MIT License (c) 2021 BYU FRoStLab see LICENSE file
+
+#include "Holodeck.h"
+#include "KinematicSnapshot.h"
+
+#include "Conversion.h"
+
+void FKinematicSnapshot::Update(UPrimitiveComponent* Body, float DeltaTime) {
+	FVector LinearVelocityThen = LinearVelocity;
+	FVector AngularVelocityThen = AngularVelocity;
+
+	Pose = Body->GetComponentTransform();
+	CenterOfMass = Body->GetCenterOfMass();
+	LinearVelocity = Body->GetPhysicsLinearVelocity();
+	AngularVelocity = Body->GetPhysicsAngularVelocityInRadians();
+
+	if (bHasPrevious && DeltaTime > 0) {
+		LinearAcceleration = (LinearVelocity - LinearVelocityThen) / DeltaTime;
+		AngularAcceleration = (AngularVelocity - AngularVelocityThen) / DeltaTime;
+	} else {
+		LinearAcceleration = FVector::ZeroVector;
+		AngularAcceleration = FVector::ZeroVector;
+	}
+	bHasPrevious = true;
+
+	ClientPosition = ConvertLinearVector(Pose.GetLocation(), UEToClient);
+	ClientLinearVelocity = ConvertLinearVector(LinearVelocity, UEToClient);
+	ClientLinearAcceleration = ConvertLinearVector(LinearAcceleration, UEToClient);
+	ClientAngularVelocity = ConvertAngularVector(AngularVelocity, NoScale);
+	ClientAngularAcceleration = ConvertAngularVector(AngularAcceleration, NoScale);
+}
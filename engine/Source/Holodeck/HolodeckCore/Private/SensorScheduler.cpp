@@ -0,0 +1,161 @@
+// MIT License (c) 2021 BYU FRoStLab see LICENSE file
+
+#include "Holodeck.h"
+#include "SensorScheduler.h"
+
+#include "HolodeckSensor.h"
+
+#include <algorithm>
+
+static void CopyName(char* Dest, const FString& Name) {
+	FTCHARToUTF8 Converted(*Name);
+	int Length = FMath::Min(Converted.Length(), SCHEDULE_NAME_LENGTH);
+	FMemory::Memzero(Dest, SCHEDULE_NAME_LENGTH);
+	FMemory::Memcpy(Dest, Converted.Get(), Length);
+}
+
+static uint32 GreatestCommonDivisor(uint32 A, uint32 B) {
+	while (B != 0) {
+		uint32 Temp = A % B;
+		A = B;
+		B = Temp;
+	}
+	return A;
+}
+
+SensorScheduler::SensorScheduler(void* Buffer) :
+		Header(static_cast<FSensorScheduleHeader*>(Buffer)),
+		Entries(reinterpret_cast<FSensorScheduleEntry*>(static_cast<uint8*>(Buffer) + sizeof(FSensorScheduleHeader))),
+		NextOrder(0) {
+	FMemory::Memzero(Buffer, BufferSize());
+}
+
+void SensorScheduler::Register(const UHolodeckSensor* Sensor, int Period, float Cost, int Phase) {
+	Period = FMath::Max(Period, 1);
+
+	auto Found = std::find_if(Sensors.begin(), Sensors.end(), [Sensor](const FEntry& Entry) { return Entry.Sensor == Sensor; });
+	if (Found == Sensors.end()) {
+		Sensors.push_back({ Sensor, Sensor->AgentName, Sensor->SensorName, Period, Cost, Phase, 0, NextOrder++ });
+	} else {
+		Found->Period = Period;
+		Found->Cost = Cost;
+		Found->PinnedPhase = Phase;
+	}
+
+	Reschedule();
+}
+
+void SensorScheduler::Unregister(const UHolodeckSensor* Sensor) {
+	auto Found = std::find_if(Sensors.begin(), Sensors.end(), [Sensor](const FEntry& Entry) { return Entry.Sensor == Sensor; });
+	if (Found == Sensors.end())
+		return;
+
+	Sensors.erase(Found);
+	Reschedule();
+}
+
+bool SensorScheduler::IsDue(const UHolodeckSensor* Sensor, uint32 Tick) const {
+	for (const FEntry& Entry : Sensors) {
+		if (Entry.Sensor == Sensor)
+			return (Tick - Header->TickOffset) % Entry.Period == (uint32)Entry.Phase;
+	}
+	return true;
+}
+
+int SensorScheduler::TicksUntilDue(const UHolodeckSensor* Sensor, uint32 Tick) const {
+	for (const FEntry& Entry : Sensors) {
+		if (Entry.Sensor == Sensor) {
+			int Into = (Tick - Header->TickOffset) % Entry.Period;
+			return (Entry.Phase - Into + Entry.Period) % Entry.Period;
+		}
+	}
+	return 0;
+}
+
+void SensorScheduler::Reschedule() {
+	uint32 Hyperperiod = 1;
+	for (const FEntry& Entry : Sensors) {
+		uint32 Next = Hyperperiod / GreatestCommonDivisor(Hyperperiod, Entry.Period) * Entry.Period;
+		if (Next > MAX_SCHEDULE_HYPERPERIOD) {
+			// Periods that don't divide the horizon are only planned approximately
+			Hyperperiod = FMath::Max<uint32>(Hyperperiod, FMath::Min<uint32>(Entry.Period, MAX_SCHEDULE_HYPERPERIOD));
+			continue;
+		}
+		Hyperperiod = Next;
+	}
+
+	std::vector<FEntry*> Order;
+	for (FEntry& Entry : Sensors)
+		Order.push_back(&Entry);
+	std::stable_sort(Order.begin(), Order.end(), [](const FEntry* A, const FEntry* B) {
+		bool PinnedA = A->PinnedPhase >= 0;
+		bool PinnedB = B->PinnedPhase >= 0;
+		if (PinnedA != PinnedB)
+			return PinnedA;
+		if (A->Cost != B->Cost)
+			return A->Cost > B->Cost;
+		if (A->Period != B->Period)
+			return A->Period < B->Period;
+		return A->Order < B->Order;
+	});
+
+	std::vector<float> Load(Hyperperiod, 0);
+	float UnstaggeredPeakCost = 0;
+	for (FEntry* Entry : Order) {
+		int Period = Entry->Period;
+		UnstaggeredPeakCost += Entry->Cost;
+
+		if (Entry->PinnedPhase >= 0) {
+			Entry->Phase = Entry->PinnedPhase % Period;
+		} else {
+			// Pick the phase whose busiest tick is cheapest, breaking ties on the total
+			float BestPeak = 0, BestTotal = 0;
+			Entry->Phase = -1;
+			for (int Phase = 0; Phase < Period && Phase < (int)Hyperperiod; Phase++) {
+				float Peak = 0, Total = 0;
+				for (uint32 Tick = Phase; Tick < Hyperperiod; Tick += Period) {
+					Peak = FMath::Max(Peak, Load[Tick]);
+					Total += Load[Tick];
+				}
+				if (Entry->Phase == -1 || Peak < BestPeak || (Peak == BestPeak && Total < BestTotal)) {
+					Entry->Phase = Phase;
+					BestPeak = Peak;
+					BestTotal = Total;
+				}
+			}
+		}
+
+		for (uint32 Tick = Entry->Phase; Tick < Hyperperiod; Tick += Period)
+			Load[Tick] += Entry->Cost;
+	}
+
+	float PeakCost = Load.empty() ? 0 : *std::max_element(Load.begin(), Load.end());
+	Publish(Hyperperiod, PeakCost, UnstaggeredPeakCost);
+}
+
+void SensorScheduler::Publish(uint32 Hyperperiod, float PeakCost, float UnstaggeredPeakCost) {
+	UE_LOG(LogHolodeck, Log, TEXT("SensorScheduler:: Scheduled %d sensors over %u ticks, estimated peak cost %.2f ms (%.2f ms unstaggered)"),
+		(int)Sensors.size(), Hyperperiod, PeakCost, UnstaggeredPeakCost);
+
+	uint32 NumSensors = 0;
+	for (const FEntry& Entry : Sensors) {
+		UE_LOG(LogHolodeck, Log, TEXT("SensorScheduler::   %s %s: every %d ticks at phase %d, %.2f ms%s"),
+			*Entry.Agent, *Entry.Name, Entry.Period, Entry.Phase, Entry.Cost, Entry.PinnedPhase >= 0 ? TEXT(" (pinned)") : TEXT(""));
+
+		if (NumSensors >= MAX_SCHEDULED_SENSORS)
+			continue;
+
+		FSensorScheduleEntry& Published = Entries[NumSensors++];
+		CopyName(Published.Agent, Entry.Agent);
+		CopyName(Published.Sensor, Entry.Name);
+		Published.Period = Entry.Period;
+		Published.Phase = Entry.Phase;
+		Published.Cost = Entry.Cost;
+		Published.bPinned = Entry.PinnedPhase >= 0;
+	}
+
+	Header->NumSensors = NumSensors;
+	Header->Hyperperiod = Hyperperiod;
+	Header->PeakCost = PeakCost;
+	Header->UnstaggeredPeakCost = UnstaggeredPeakCost;
+}
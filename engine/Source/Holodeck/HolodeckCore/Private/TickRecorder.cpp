@@ -0,0 +1,550 @@
+// MIT License (c) 2021 BYU FRoStLab see LICENSE file
+
+#include "Holodeck.h"
+#include "TickRecorder.h"
+
+#include "NoiseSeed.h"
+#include "HolodeckTelemetry.h"
+#include "SensorScheduler.h"
+
+#include <algorithm>
+#include <random>
+
+#if PLATFORM_LINUX
+#include <sys/stat.h>
+#endif
+
+const uint32_t CHUNK_MAGIC = 0x43524448; // "HDRC"
+const uint32_t INDEX_MAGIC = 0x58494448; // "HDIX"
+const uint32_t LOG_VERSION = 1;
+const uint64_t CHUNK_CAPACITY = 64 * 1024 * 1024;
+const char SENSOR_DATA_SUFFIX[] = "_sensor_data";
+const char SENSOR_HISTORY_TAG[] = "_sensor_history";
+// Other blocks the engine writes and the client only reads. They're checked like the sensor
+// data, instead of being written back as if the client had sent them
+const char* const OTHER_OUTPUT_SUFFIXES[] = { "_pose_batch_images", "_pose_batch_count", "_octree_status", "derived_octrees" };
+
+struct FChunkHeader {
+	uint32_t Magic;
+	uint32_t Version;
+	uint64_t Used;
+};
+
+struct FIndexHeader {
+	uint32_t Magic;
+	uint32_t Version;
+	uint32_t Seed;
+	uint32_t Reserved;
+};
+
+struct FRecordHeader {
+	uint32_t Tick;
+	uint32_t NumBlocks;
+	uint64_t Size;
+};
+
+struct FBlockHeader {
+	uint8_t Kind;
+	uint8_t Reserved;
+	uint16_t KeyLength;
+	uint32_t Size;
+	// Trailing zeros aren't stored, which keeps mostly empty buffers like the
+	// command buffer small
+	uint32_t StoredSize;
+};
+
+static bool EndsWith(const std::string& Str, const std::string& Suffix) {
+	return Str.size() >= Suffix.size() && Str.compare(Str.size() - Suffix.size(), Suffix.size(), Suffix) == 0;
+}
+
+TickLogChunk::TickLogChunk(const std::string& Path, uint64_t Capacity) :
+		Path(Path), MapSize(0), bWritable(Capacity > 0), MemPointer(nullptr) {
+
+	#if PLATFORM_WINDOWS
+
+	Mapping = NULL;
+	File = CreateFileA(Path.c_str(), bWritable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ, FILE_SHARE_READ, NULL,
+		bWritable ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (File == INVALID_HANDLE_VALUE) {
+		UE_LOG(LogHolodeck, Error, TEXT("TickLogChunk:: Unable to open %s (%d)"), UTF8_TO_TCHAR(Path.c_str()), GetLastError());
+		return;
+	}
+
+	if (bWritable) {
+		MapSize = sizeof(FChunkHeader) + Capacity;
+	}
+	else {
+		LARGE_INTEGER FileSize;
+		GetFileSizeEx(File, &FileSize);
+		MapSize = FileSize.QuadPart;
+	}
+
+	Mapping = CreateFileMapping(File, NULL, bWritable ? PAGE_READWRITE : PAGE_READONLY, MapSize >> 32, MapSize & 0xFFFFFFFF, NULL);
+	if (Mapping != NULL) {
+		MemPointer = static_cast<uint8_t*>(MapViewOfFile(Mapping, bWritable ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, 0, 0, 0));
+	}
+
+	#elif PLATFORM_LINUX
+
+	File = open(Path.c_str(), bWritable ? O_CREAT | O_RDWR | O_TRUNC : O_RDONLY, 0666);
+	if (File == -1) {
+		UE_LOG(LogHolodeck, Error, TEXT("TickLogChunk:: Unable to open %s - %s"), UTF8_TO_TCHAR(Path.c_str()), ANSI_TO_TCHAR(strerror(errno)));
+		return;
+	}
+
+	if (bWritable) {
+		MapSize = sizeof(FChunkHeader) + Capacity;
+		if (ftruncate(File, MapSize) == -1) {
+			UE_LOG(LogHolodeck, Error, TEXT("TickLogChunk:: Unable to size %s - %s"), UTF8_TO_TCHAR(Path.c_str()), ANSI_TO_TCHAR(strerror(errno)));
+			return;
+		}
+	}
+	else {
+		struct stat Stat;
+		fstat(File, &Stat);
+		MapSize = Stat.st_size;
+	}
+
+	void* Ptr = mmap(nullptr, MapSize, bWritable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, File, 0);
+	if (Ptr != MAP_FAILED) {
+		MemPointer = static_cast<uint8_t*>(Ptr);
+	}
+
+	#endif
+
+	if (MemPointer == nullptr) {
+		UE_LOG(LogHolodeck, Error, TEXT("TickLogChunk:: Unable to map %s"), UTF8_TO_TCHAR(Path.c_str()));
+		return;
+	}
+
+	FChunkHeader* Header = reinterpret_cast<FChunkHeader*>(MemPointer);
+	if (bWritable) {
+		Header->Magic = CHUNK_MAGIC;
+		Header->Version = LOG_VERSION;
+		Header->Used = 0;
+	}
+	else if (MapSize < sizeof(FChunkHeader) || Header->Magic != CHUNK_MAGIC || Header->Version != LOG_VERSION) {
+		UE_LOG(LogHolodeck, Error, TEXT("TickLogChunk:: %s isn't a tick log chunk"), UTF8_TO_TCHAR(Path.c_str()));
+		#if PLATFORM_WINDOWS
+		UnmapViewOfFile(MemPointer);
+		#elif PLATFORM_LINUX
+		munmap(MemPointer, MapSize);
+		#endif
+		MemPointer = nullptr;
+	}
+}
+
+TickLogChunk::~TickLogChunk() {
+	uint64_t FileSize = sizeof(FChunkHeader) + Used();
+
+	#if PLATFORM_WINDOWS
+	if (MemPointer != nullptr) UnmapViewOfFile(MemPointer);
+	if (Mapping != NULL) CloseHandle(Mapping);
+	if (File != INVALID_HANDLE_VALUE) {
+		if (bWritable) {
+			LARGE_INTEGER Distance;
+			Distance.QuadPart = FileSize;
+			SetFilePointerEx(File, Distance, NULL, FILE_BEGIN);
+			SetEndOfFile(File);
+		}
+		CloseHandle(File);
+	}
+	#elif PLATFORM_LINUX
+	if (MemPointer != nullptr) munmap(MemPointer, MapSize);
+	if (File != -1) {
+		if (bWritable && ftruncate(File, FileSize) == -1) {
+			UE_LOG(LogHolodeck, Warning, TEXT("TickLogChunk:: Unable to trim %s"), UTF8_TO_TCHAR(Path.c_str()));
+		}
+		close(File);
+	}
+	#endif
+}
+
+uint64_t TickLogChunk::Used() const {
+	if (MemPointer == nullptr) return 0;
+	return reinterpret_cast<const FChunkHeader*>(MemPointer)->Used;
+}
+
+int64_t TickLogChunk::Append(const void* Data, uint64_t Size) {
+	if (MemPointer == nullptr || !bWritable) return -1;
+
+	FChunkHeader* Header = reinterpret_cast<FChunkHeader*>(MemPointer);
+	uint64_t Offset = Header->Used;
+	if (sizeof(FChunkHeader) + Offset + Size > MapSize) return -1;
+
+	std::memcpy(MemPointer + sizeof(FChunkHeader) + Offset, Data, Size);
+	// Only count the record once all of it is in place
+	Header->Used = Offset + Size;
+	return Offset;
+}
+
+const uint8_t* TickLogChunk::Read(uint64_t Offset, uint64_t Size) const {
+	if (MemPointer == nullptr || Offset + Size > Used()) return nullptr;
+	return MemPointer + sizeof(FChunkHeader) + Offset;
+}
+
+TickRecorder::TickRecorder(EMode Mode, const std::string& Directory, const std::set<std::string>& Sensors) :
+		Mode(Mode), Directory(Directory), Sensors(Sensors), Seed(0), IndexFile(nullptr), NextRecord(0), CurrentChunk(0),
+		bTickOpen(false), bFinished(false), CurrentTick(0), RecordBlocks(0), Mismatches(0) {
+	FPlatformFileManager::Get().GetPlatformFile().CreateDirectoryTree(UTF8_TO_TCHAR(Directory.c_str()));
+
+	if (Mode == EMode::Record)
+		OpenForRecording();
+	else
+		OpenForReplay();
+}
+
+TickRecorder::~TickRecorder() {
+	Chunks.clear();
+	if (IndexFile != nullptr) {
+		std::fclose(IndexFile);
+		IndexFile = nullptr;
+	}
+}
+
+std::unique_ptr<TickRecorder> TickRecorder::FromCommandLine() {
+	const TCHAR* CommandLine = FCommandLine::Get();
+
+	uint32 SeedArg;
+	if (FParse::Value(CommandLine, TEXT("HolodeckSeed="), SeedArg))
+		NoiseSeed::SetSeed(SeedArg);
+
+	FString Directory;
+	EMode Mode;
+	if (FParse::Value(CommandLine, TEXT("HolodeckReplay="), Directory))
+		Mode = EMode::Replay;
+	else if (FParse::Value(CommandLine, TEXT("HolodeckRecord="), Directory))
+		Mode = EMode::Record;
+	else
+		return nullptr;
+
+	std::set<std::string> Sensors;
+	FString SensorList;
+	if (FParse::Value(CommandLine, TEXT("HolodeckRecordSensors="), SensorList, false)) {
+		TArray<FString> Names;
+		SensorList.ParseIntoArray(Names, TEXT(","), true);
+		for (const FString& Name : Names)
+			Sensors.insert(TCHAR_TO_UTF8(*Name.TrimStartAndEnd()));
+	}
+
+	UE_LOG(LogHolodeck, Log, TEXT("TickRecorder:: %s %s"), Mode == EMode::Replay ? TEXT("Replaying") : TEXT("Recording to"), *Directory);
+	return std::unique_ptr<TickRecorder>(new TickRecorder(Mode, TCHAR_TO_UTF8(*Directory), Sensors));
+}
+
+std::string TickRecorder::ChunkPath(size_t Chunk) const {
+	return Directory + "/chunk_" + std::to_string(Chunk) + ".bin";
+}
+
+void TickRecorder::OpenForRecording() {
+	// A recording has to be seeded, otherwise there's no way to draw the same noise again
+	if (NoiseSeed::IsSeeded()) {
+		Seed = NoiseSeed::GetSeed();
+	}
+	else {
+		std::random_device rd{};
+		Seed = rd();
+		NoiseSeed::SetSeed(Seed);
+	}
+
+	std::string IndexPath = Directory + "/index.bin";
+	IndexFile = std::fopen(IndexPath.c_str(), "wb");
+	if (IndexFile == nullptr) {
+		UE_LOG(LogHolodeck, Error, TEXT("TickRecorder:: Unable to create %s, nothing will be recorded"), UTF8_TO_TCHAR(IndexPath.c_str()));
+		return;
+	}
+
+	FIndexHeader Header = { INDEX_MAGIC, LOG_VERSION, Seed, 0 };
+	std::fwrite(&Header, sizeof(Header), 1, IndexFile);
+	std::fflush(IndexFile);
+}
+
+void TickRecorder::OpenForReplay() {
+	std::string IndexPath = Directory + "/index.bin";
+	std::FILE* File = std::fopen(IndexPath.c_str(), "rb");
+	if (File == nullptr) {
+		UE_LOG(LogHolodeck, Error, TEXT("TickRecorder:: Unable to open %s, there's nothing to replay"), UTF8_TO_TCHAR(IndexPath.c_str()));
+		return;
+	}
+
+	FIndexHeader Header;
+	if (std::fread(&Header, sizeof(Header), 1, File) != 1 || Header.Magic != INDEX_MAGIC || Header.Version != LOG_VERSION) {
+		UE_LOG(LogHolodeck, Error, TEXT("TickRecorder:: %s isn't a tick log index"), UTF8_TO_TCHAR(IndexPath.c_str()));
+		std::fclose(File);
+		return;
+	}
+
+	Seed = Header.Seed;
+	NoiseSeed::SetSeed(Seed);
+
+	FIndexEntry Entry;
+	while (std::fread(&Entry, sizeof(Entry), 1, File) == 1)
+		Index.push_back(Entry);
+	std::fclose(File);
+
+	// Every recorded output gets checked
+	Sensors = { "all" };
+
+	UE_LOG(LogHolodeck, Log, TEXT("TickRecorder:: Loaded %d recorded ticks"), (int)Index.size());
+}
+
+bool TickRecorder::IsOutput(const std::string& Key) const {
+	if (EndsWith(Key, SENSOR_DATA_SUFFIX))
+		return true;
+
+	for (const char* Suffix : OTHER_OUTPUT_SUFFIXES) {
+		if (EndsWith(Key, Suffix))
+			return true;
+	}
+	return false;
+}
+
+bool TickRecorder::IsIgnored(const std::string& Key) const {
+	// History rings are rebuilt from the sensor data, timings never match and
+	// the schedule is worked out again by the engine
+	if (Key.find(SENSOR_HISTORY_TAG) != std::string::npos || Key == TELEMETRY_KEY || Key == SENSOR_SCHEDULE_KEY)
+		return true;
+
+	// Only sensor data is picked by record_sensors, the other outputs are always checked
+	if (!EndsWith(Key, SENSOR_DATA_SUFFIX) || Sensors.count("all"))
+		return false;
+
+	for (const std::string& Sensor : Sensors) {
+		if (EndsWith(Key, "_" + Sensor + SENSOR_DATA_SUFFIX))
+			return false;
+	}
+	return true;
+}
+
+void TickRecorder::Tick(uint32_t TickNumber, const MemoryMap& Memory) {
+	if (bFinished) return;
+
+	if (Mode == EMode::Record) {
+		if (IndexFile == nullptr) return;
+
+		if (bTickOpen) {
+			CaptureBlocks(Output, Memory);
+			WriteRecord();
+		}
+
+		CurrentTick = TickNumber;
+		Record.assign(sizeof(FRecordHeader), 0);
+		RecordBlocks = 0;
+		CaptureBlocks(Input, Memory);
+		bTickOpen = true;
+	}
+	else {
+		if (bTickOpen)
+			CheckOutputs(Memory);
+
+		bTickOpen = ApplyRecord(TickNumber, Memory);
+		if (!bTickOpen) {
+			bFinished = true;
+			UE_LOG(LogHolodeck, Log, TEXT("TickRecorder:: Replayed %d ticks, %llu outputs didn't match the recording"),
+				(int)NextRecord, (unsigned long long)Mismatches);
+			WriteReplaySummary();
+		}
+	}
+}
+
+void TickRecorder::EndTick(const MemoryMap& Memory) {
+	if (bFinished || !bTickOpen) return;
+
+	if (Mode == EMode::Record) {
+		if (IndexFile == nullptr) return;
+		CaptureBlocks(Output, Memory);
+		WriteRecord();
+		RememberInputs(Memory);
+	}
+	else {
+		CheckOutputs(Memory);
+	}
+	bTickOpen = false;
+}
+
+void TickRecorder::Finish(const MemoryMap& Memory) {
+	if (Mode == EMode::Record && bTickOpen && IndexFile != nullptr) {
+		CaptureBlocks(Output, Memory);
+		WriteRecord();
+		bTickOpen = false;
+	}
+	else if (Mode == EMode::Replay && !bFinished) {
+		if (bTickOpen)
+			CheckOutputs(Memory);
+		bTickOpen = false;
+		bFinished = true;
+		WriteReplaySummary();
+	}
+}
+
+void TickRecorder::CaptureBlocks(EBlockKind Kind, const MemoryMap& Memory) {
+	for (const auto& Block : Memory) {
+		const std::string& Key = Block.first;
+		if (IsIgnored(Key) || IsOutput(Key) != (Kind == Output))
+			continue;
+
+		const uint8_t* Data = static_cast<const uint8_t*>(Block.second->GetPtr());
+		uint32_t Size = Block.second->Size();
+
+		std::vector<uint8_t>& Last = Latest[Key];
+		if (Last.size() == Size && std::memcmp(Last.data(), Data, Size) == 0)
+			continue;
+
+		Last.assign(Data, Data + Size);
+		AddBlock(Kind, Key, Data, Size);
+	}
+}
+
+void TickRecorder::RememberInputs(const MemoryMap& Memory) {
+	// The engine clears flags like the command, reset and teleport ones once it has read them.
+	// Comparing against what it left behind means a client setting one again next tick is a
+	// change and gets recorded, instead of matching what was recorded last
+	for (const auto& Block : Memory) {
+		const std::string& Key = Block.first;
+		if (IsIgnored(Key) || IsOutput(Key))
+			continue;
+
+		const uint8_t* Data = static_cast<const uint8_t*>(Block.second->GetPtr());
+		Latest[Key].assign(Data, Data + Block.second->Size());
+	}
+}
+
+void TickRecorder::AddBlock(EBlockKind Kind, const std::string& Key, const uint8_t* Data, uint32_t Size) {
+	uint32_t StoredSize = Size;
+	while (StoredSize > 0 && Data[StoredSize - 1] == 0)
+		StoredSize--;
+
+	FBlockHeader Header = { Kind, 0, (uint16_t)Key.size(), Size, StoredSize };
+	const uint8_t* HeaderBytes = reinterpret_cast<const uint8_t*>(&Header);
+	Record.insert(Record.end(), HeaderBytes, HeaderBytes + sizeof(Header));
+	Record.insert(Record.end(), Key.begin(), Key.end());
+	Record.insert(Record.end(), Data, Data + StoredSize);
+	RecordBlocks++;
+}
+
+void TickRecorder::WriteRecord() {
+	FRecordHeader* Header = reinterpret_cast<FRecordHeader*>(Record.data());
+	Header->Tick = CurrentTick;
+	Header->NumBlocks = RecordBlocks;
+	Header->Size = Record.size();
+
+	int64_t Offset = Chunks.empty() ? -1 : Chunks.back()->Append(Record.data(), Record.size());
+	if (Offset < 0) {
+		// Start a new chunk, making it bigger if this one record won't fit in a normal one
+		uint32_t Chunk = Chunks.empty() ? 0 : CurrentChunk + 1;
+		Chunks.clear();
+		Chunks.emplace_back(new TickLogChunk(ChunkPath(Chunk), std::max<uint64_t>(CHUNK_CAPACITY, Record.size())));
+		CurrentChunk = Chunk;
+
+		Offset = Chunks.back()->Append(Record.data(), Record.size());
+		if (Offset < 0) {
+			UE_LOG(LogHolodeck, Error, TEXT("TickRecorder:: Unable to write tick %u, stopping the recording"), CurrentTick);
+			std::fclose(IndexFile);
+			IndexFile = nullptr;
+			return;
+		}
+	}
+
+	FIndexEntry Entry = { CurrentTick, CurrentChunk, (uint64_t)Offset };
+	Index.push_back(Entry);
+
+	std::fwrite(&Entry, sizeof(Entry), 1, IndexFile);
+	std::fflush(IndexFile);
+}
+
+bool TickRecorder::ApplyRecord(uint32_t TickNumber, const MemoryMap& Memory) {
+	if (NextRecord >= Index.size())
+		return false;
+
+	const FIndexEntry& Entry = Index[NextRecord++];
+	if (Entry.Tick != TickNumber) {
+		UE_LOG(LogHolodeck, Verbose, TEXT("TickRecorder:: Tick %u was recorded as tick %u"), TickNumber, Entry.Tick);
+	}
+
+	if (Chunks.size() <= Entry.Chunk)
+		Chunks.resize(Entry.Chunk + 1);
+	if (Chunks[Entry.Chunk] == nullptr) {
+		// Only the chunk being read needs to stay mapped
+		for (auto& Chunk : Chunks)
+			Chunk.reset();
+		Chunks[Entry.Chunk].reset(new TickLogChunk(ChunkPath(Entry.Chunk), 0));
+	}
+
+	const TickLogChunk& Chunk = *Chunks[Entry.Chunk];
+	const uint8_t* Header = Chunk.Read(Entry.Offset, sizeof(FRecordHeader));
+	if (Header == nullptr) {
+		UE_LOG(LogHolodeck, Error, TEXT("TickRecorder:: The record for tick %u is missing"), Entry.Tick);
+		return false;
+	}
+
+	FRecordHeader RecordHeader;
+	std::memcpy(&RecordHeader, Header, sizeof(RecordHeader));
+	const uint8_t* Cursor = Chunk.Read(Entry.Offset, RecordHeader.Size);
+	if (Cursor == nullptr) {
+		UE_LOG(LogHolodeck, Error, TEXT("TickRecorder:: The record for tick %u is truncated"), Entry.Tick);
+		return false;
+	}
+	const uint8_t* End = Cursor + RecordHeader.Size;
+	Cursor += sizeof(FRecordHeader);
+
+	for (uint32_t i = 0; i < RecordHeader.NumBlocks; i++) {
+		FBlockHeader Block;
+		if (Cursor + sizeof(Block) > End) break;
+		std::memcpy(&Block, Cursor, sizeof(Block));
+		Cursor += sizeof(Block);
+
+		if (Cursor + Block.KeyLength + Block.StoredSize > End || Block.StoredSize > Block.Size) {
+			UE_LOG(LogHolodeck, Error, TEXT("TickRecorder:: The record for tick %u is corrupt"), Entry.Tick);
+			return false;
+		}
+
+		std::string Key(reinterpret_cast<const char*>(Cursor), Block.KeyLength);
+		Cursor += Block.KeyLength;
+
+		std::vector<uint8_t>& Last = Latest[Key];
+		Last.assign(Block.Size, 0);
+		std::memcpy(Last.data(), Cursor, Block.StoredSize);
+		Cursor += Block.StoredSize;
+
+		if (Block.Kind != Input)
+			continue;
+
+		// Buffers show up as agents are spawned by the replayed commands
+		auto Found = Memory.find(Key);
+		if (Found == Memory.end() || (uint32_t)Found->second->Size() != Block.Size) {
+			UE_LOG(LogHolodeck, Verbose, TEXT("TickRecorder:: Skipping %s on tick %u"), UTF8_TO_TCHAR(Key.c_str()), TickNumber);
+			continue;
+		}
+		std::memcpy(Found->second->GetPtr(), Last.data(), Block.Size);
+	}
+
+	CurrentTick = TickNumber;
+	return true;
+}
+
+void TickRecorder::WriteReplaySummary() {
+	std::string Path = Directory + "/replay.json";
+	std::FILE* File = std::fopen(Path.c_str(), "w");
+	if (File == nullptr) {
+		UE_LOG(LogHolodeck, Warning, TEXT("TickRecorder:: Unable to write %s"), UTF8_TO_TCHAR(Path.c_str()));
+		return;
+	}
+	std::fprintf(File, "{\"ticks\": %d, \"mismatches\": %llu}\n", (int)NextRecord, (unsigned long long)Mismatches);
+	std::fclose(File);
+}
+
+void TickRecorder::CheckOutputs(const MemoryMap& Memory) {
+	for (const auto& Expected : Latest) {
+		if (!IsOutput(Expected.first))
+			continue;
+
+		auto Found = Memory.find(Expected.first);
+		bool bMatches = Found != Memory.end()
+			&& (size_t)Found->second->Size() == Expected.second.size()
+			&& std::memcmp(Found->second->GetPtr(), Expected.second.data(), Expected.second.size()) == 0;
+
+		if (!bMatches) {
+			Mismatches++;
+			UE_LOG(LogHolodeck, Warning, TEXT("TickRecorder:: %s doesn't match the recording on tick %u"), UTF8_TO_TCHAR(Expected.first.c_str()), CurrentTick);
+		}
+	}
+}
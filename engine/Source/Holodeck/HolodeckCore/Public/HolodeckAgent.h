@@ -10,6 +10,7 @@
 #include "HolodeckPawnController.h"
 #include "HolodeckPawnControllerInterface.h"
 #include "HolodeckGameInstance.h"
+#include "KinematicSnapshot.h"
 #include "HolodeckAgent.generated.h"
 
 
@@ -94,6 +95,34 @@ public:
 	*/
 	bool InitializeController() override;
 
+	/**
+	* SaveSnapshot
+	* Remembers the pose and velocities of the agent, and has its sensors and
+	* controller save whatever internal state they carry between ticks.
+	*/
+	virtual void SaveSnapshot();
+
+	/**
+	* RestoreSnapshot
+	* Puts the agent back into the state saved by SaveSnapshot, without respawning it.
+	* Joint poses of articulated agents are not restored.
+	*/
+	virtual void RestoreSnapshot();
+
+	/**
+	* UpdateKinematics
+	* Refreshes the kinematic snapshot of the agent's root body. Called by the
+	* game mode once physics is done, before any sensor ticks.
+	* @param DeltaTime the time since the last update.
+	*/
+	void UpdateKinematics(float DeltaTime);
+
+	/**
+	* GetKinematics
+	* @return the state of the agent's root body as of the end of physics this tick.
+	*/
+	const FKinematicSnapshot& GetKinematics() const { return Kinematics; }
+
 	/**
 	  * GetRawActionSizeInBytes
 	  * @return the number of bytes used by the action space.
@@ -131,4 +160,11 @@ private:
 
 	UHolodeckGameInstance* Instance;
 	UHolodeckServer* Server;
+
+	FTransform SnapshotTransform;
+	FVector SnapshotVelocity;
+	FVector SnapshotAngularVelocity;
+
+	FKinematicSnapshot Kinematics;
+	FKinematicSnapshot SnapshotKinematics;
 };
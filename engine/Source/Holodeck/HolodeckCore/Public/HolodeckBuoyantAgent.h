@@ -62,15 +62,16 @@ public:
 	void ShowBoundingBox(float DeltaTime);
 	void ShowSurfacePoints(float DeltaTime);
 
-	Octree* makeOctree();
-	// octree in global coordinates in octree
-	Octree* octreeGlobal = nullptr;
-	// we store the octree in the actor coordinates in octreeClean,
-	Octree* octreeLocal = nullptr;
+	// Makes the octree sonars with the given OctreeMin see, or returns it if it's been made
+	Octree* makeOctree(OctreeContext& ctx, float octreeMin);
+	// octree in global coordinates in octree, one per OctreeMin sonars have asked for
+	TMap<float, Octree*> octreeGlobal;
+	// octree in the actor coordinates, shared with every agent with our mesh and owned by the OctreeContext
+	TMap<float, Octree*> octreeLocal;
 
 private:
 	// Used to fix octreeGlobal
 	void updateOctree(Octree* localFrame, Octree* globalFrame);
-	// Used to extract local frame from global frame
-	Octree* cleanOctree(Octree* globalFrame);
+	// Used to make our own global frame copy of the shared local one
+	Octree* copyOctree(Octree* localFrame);
 };
@@ -11,6 +11,55 @@
 #include "CommandCenter.h"
 #include "HolodeckGameMode.generated.h"
 
+class AHolodeckGameMode;
+class UHolodeckSensor;
+
+/**
+ * FHolodeckPhysicsTimerTickFunction
+ * Marks the start or end of physics for the tick telemetry. One runs in
+ * TG_StartPhysics and the other after the world's end physics tick, where it
+ * also updates the agents' kinematic snapshots.
+ */
+USTRUCT()
+struct FHolodeckPhysicsTimerTickFunction : public FTickFunction
+{
+	GENERATED_USTRUCT_BODY()
+
+	AHolodeckGameMode* Target = nullptr;
+	bool bIsStart = true;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FHolodeckPhysicsTimerTickFunction> : public TStructOpsTypeTraitsBase2<FHolodeckPhysicsTimerTickFunction>
+{
+	enum { WithCopy = false };
+};
+
+/**
+ * FHolodeckSensorBatchTickFunction
+ * Ticks every thread safe sensor at once in TG_PostPhysics, see
+ * UHolodeckSensor::TickParallel.
+ */
+USTRUCT()
+struct FHolodeckSensorBatchTickFunction : public FTickFunction
+{
+	GENERATED_USTRUCT_BODY()
+
+	AHolodeckGameMode* Target = nullptr;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FHolodeckSensorBatchTickFunction> : public TStructOpsTypeTraitsBase2<FHolodeckSensorBatchTickFunction>
+{
+	enum { WithCopy = false };
+};
+
 /**
  * AHolodeckGameMode
  * The base game mode for Holodeck.
@@ -43,6 +92,13 @@ public:
 	  */
 	void StartPlay() override;
 
+	/**
+	  * EndPlay
+	  * Called when the game ends.
+	  * Stops rebuilding octree tiles, since it needs the world.
+	  */
+	void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	// Can be set off to turn off holodeck functionality.
 	UPROPERTY(EditAnywhere)
 	bool bHolodeckIsOn;
@@ -53,6 +109,12 @@ public:
 	  */
 	UHolodeckServer* GetAssociatedServer() { return this->Server; };
 
+	/**
+	  * GetOctreeContext
+	  * Returns what this world's octrees are built and loaded with. Set up in StartPlay.
+	  */
+	OctreeContext* GetOctreeContext() { return this->Octrees.Get(); };
+
 	// These functions allow the Holodeck to do things which cannot normally be done from pure c++ code
 	UFUNCTION(BlueprintImplementableEvent)
 	AHolodeckAgent* SpawnAgent(const FString& Type, const FVector& Location, const FRotator& Rotation, const FString& Name, bool IsMainAgent);
@@ -78,6 +140,60 @@ public:
 	UFUNCTION(BlueprintCallable)
 	void LogFatalMessage(const FString& Message);
 
+	/**
+	  * SaveSnapshot
+	  * Captures the state of every agent and every physics prop in the level,
+	  * so the episode can be restarted in place with RestoreSnapshot.
+	  */
+	void SaveSnapshot();
+
+	/**
+	  * RestoreSnapshot
+	  * Puts every agent and prop back the way it was when SaveSnapshot was called,
+	  * and destroys props spawned since then. Much faster than reloading the level.
+	  */
+	void RestoreSnapshot();
+
+	/**
+	  * IsSensorsOnly
+	  * @return true if the engine was launched with -HolodeckSensorsOnly. Nothing
+	  * is rendered in that mode, and sensors that need rendering refuse to start.
+	  */
+	static bool IsSensorsOnly();
+
+	/**
+	  * OnPhysicsTimer
+	  * Called by the physics timer tick functions to time physics for the telemetry.
+	  */
+	void OnPhysicsTimer(bool bIsStart);
+
+	/**
+	  * UpdateAgentKinematics
+	  * Takes the kinematic snapshot of every agent, once physics is done.
+	  */
+	void UpdateAgentKinematics(float DeltaTime);
+
+	/**
+	  * AddParallelSensor
+	  * Has the sensor ticked with the other thread safe sensors after physics,
+	  * instead of by its own tick function.
+	  * @return false if the batch isn't running, in which case the sensor
+	  * should keep ticking itself.
+	  */
+	bool AddParallelSensor(UHolodeckSensor* Sensor);
+
+	/**
+	  * RemoveParallelSensor
+	  * Takes a sensor out of the batch. Does nothing if it wasn't in it.
+	  */
+	void RemoveParallelSensor(UHolodeckSensor* Sensor);
+
+	/**
+	  * TickParallelSensors
+	  * Called by the sensor batch tick function.
+	  */
+	void TickParallelSensors(float DeltaTime, ELevelTick TickType);
+
 private:
 	/**
 	  * RegisterSettings
@@ -85,9 +201,38 @@ private:
 	  */
 	void RegisterSettings();
 
+	/**
+	  * RegisterPhysicsTimers
+	  * Registers the tick functions that time physics each tick.
+	  */
+	void RegisterPhysicsTimers();
+
+	FHolodeckPhysicsTimerTickFunction StartPhysicsTimer;
+	FHolodeckPhysicsTimerTickFunction EndPhysicsTimer;
+	double PhysicsStartMs = 0;
+
+	/**
+	  * RegisterSensorBatch
+	  * Registers the tick function that ticks thread safe sensors.
+	  */
+	void RegisterSensorBatch();
+
+	FHolodeckSensorBatchTickFunction SensorBatchTick;
+	TArray<UHolodeckSensor*> ParallelSensors;
+	// Set with -HolodeckSerialSensors, ticks the batch on the game thread for debugging
+	bool bSerialSensors = false;
+
 	// Setting buffers
 	bool* ResetSignal;
 
+	TUniquePtr<OctreeContext> Octrees;
+
+	// Every actor in the level when the snapshot was taken, with its transform
+	TMap<TWeakObjectPtr<AActor>, FTransform> SnapshotActors;
+	bool bHasSnapshot = false;
+	// The scheduler's tick when the snapshot was taken, so captures can be lined up with it again
+	uint32 SnapshotCaptureTick = 0;
+
 	UPROPERTY()
 	UHolodeckServer* Server;
 	UPROPERTY()
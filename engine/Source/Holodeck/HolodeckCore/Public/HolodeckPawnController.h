@@ -84,6 +84,12 @@ public:
 	*/
 	virtual void ExecuteSetState() override;
 
+	/**
+	* RestoreSnapshot
+	* Drops any teleports or action schedules still waiting to be executed.
+	*/
+	virtual void RestoreSnapshot() override;
+
 	/**
 	* SetServer
 	* Sets the server object within this object.
@@ -98,6 +104,9 @@ public:
 
 protected:
 	void* ActionBuffer;
+	void* ActionScheduleBuffer;
+	uint32* ActionScheduleInfoBuffer;
+	unsigned int ActionSizeInBytes;
 	uint8* ControlSchemeIdBuffer;
 	float* TeleportBuffer;
 	uint8* ShouldChangeStateBuffer;
@@ -122,5 +131,6 @@ private:
 
 	const int SINGLE_BOOL = 1;
 	const int TELEPORT_COMMAND_SIZE = 12;
+	const unsigned int MAX_ACTION_SCHEDULE_TICKS = 256;
 	UHolodeckServer* Server;
 };
@@ -102,6 +102,12 @@ public:
 		check(0 && "You must override ExecuteSetState");
 	};
 
+	/**
+	* RestoreSnapshot
+	* Drops any teleports or action schedules still waiting to be executed.
+	*/
+	virtual void RestoreSnapshot() {};
+
 	/**
 	* SetServer
 	* Sets the server object within this object.
@@ -52,6 +52,12 @@ public:
 	*	code should be called from within that function
 	*/
 	virtual void BeginPlay() final;
+
+	/**
+	* EndPlay
+	* Takes the sensor off the capture schedule and out of the parallel batch.
+	*/
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	
 	/**
 	  * Publishes sensor data each tick
@@ -60,14 +66,52 @@ public:
 	  * TickSensorComponent is called from this
 	  */
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/**
+	  * TickParallel
+	  * Ticks sensors that are thread safe together with a ParallelFor, in place
+	  * of their own TickComponent. Sensors that aren't on an agent's root body
+	  * have their kinematics read beforehand. Called by the game mode after physics.
+	  *
+	  * Noise generators are seeded in the order they first draw, so when the
+	  * noise is seeded the sensors are run one after another to keep runs
+	  * reproducible.
+	  * @param bForceSingleThread runs them one after another on the game thread instead.
+	  */
+	static void TickParallel(const TArray<UHolodeckSensor*>& Sensors, float DeltaTime, ELevelTick TickType, bool bForceSingleThread);
 	
 	/**
 	* Override this function if sensor has parameters to initialize.
+	* Subclasses should make sure to call Super::ParseSensorParms()
 	*/
-	virtual void ParseSensorParms(FString ParmsJson) {}
+	virtual void ParseSensorParms(FString ParmsJson);
 
 	virtual FString GetAgentName() { return this->AgentName; }
 
+	/**
+	* ScheduleCaptures
+	* Registers the sensor with the server's SensorScheduler if it doesn't
+	* capture every tick. Called from InitializeSensor, call it again after
+	* changing how often the sensor captures.
+	*/
+	void ScheduleCaptures();
+
+	/**
+	* SaveSnapshot
+	* Override this function if the sensor carries state from one tick to the next
+	* (noise biases, tick counters, queued messages), and save it here. Overrides
+	* must call the base, which saves the body's kinematics for sensors that aren't
+	* on the agent's root body.
+	*/
+	virtual void SaveSnapshot();
+
+	/**
+	* RestoreSnapshot
+	* Puts back whatever SaveSnapshot saved, so a restored episode behaves like
+	* it did when the snapshot was taken.
+	*/
+	virtual void RestoreSnapshot();
+
 	FString AgentName;
 
 	// Allows you to modify the sensor name in the editor to allow for duplicate sensors on an agent
@@ -106,8 +150,114 @@ protected:
 	virtual void TickSensorComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) { 
 		check(0 && "You must override TickSensorComponent"); };
 
+	/**
+	  * HasNewData
+	  * Whether the last call to TickSensorComponent wrote a new sample into Buffer.
+	  * Sensors that don't capture every tick should override this, so only real
+	  * captures make it into the history.
+	  */
+	virtual bool HasNewData() { return true; }
+
+	/**
+	  * IsThreadSafe
+	  * Sensors that only read their own state, component transforms and GetKinematics
+	  * in TickSensorComponent, and only write to their own buffer, can return
+	  * true here. They're then ticked in parallel with other thread safe sensors
+	  * instead of one at a time on the game thread.
+	  */
+	virtual bool IsThreadSafe() { return false; }
+
+	/**
+	  * NeedsRendering
+	  * Sensors that read rendered images must return true here, so they're
+	  * refused when the engine is running sensors only.
+	  */
+	virtual bool NeedsRendering() { return false; }
+
+	/**
+	  * GetCapturePeriod
+	  * How many ticks apart the sensor's captures are. Sensors that do their
+	  * expensive work every few ticks should override this and use
+	  * IsCaptureTick to decide when to run.
+	  */
+	virtual int GetCapturePeriod() { return 1; }
+
+	/**
+	  * IsCaptureTick
+	  * @return true if the sensor should capture this tick, according to the
+	  * phase the scheduler picked for it.
+	  */
+	bool IsCaptureTick();
+
+	/**
+	  * TicksUntilCapture
+	  * @return how many ticks from this one the sensor's next scheduled capture
+	  * is, 0 if IsCaptureTick is true.
+	  */
+	int TicksUntilCapture();
+
+	/**
+	  * IsWanted
+	  * @return false if the client said it won't read this sensor's data after
+	  * this tick. Expensive sensors should skip their capture when it's false,
+	  * but keep any state that carries between ticks up to date.
+	  */
+	bool IsWanted() const { return WantedBuffer == nullptr || *WantedBuffer; }
+
+	/**
+	  * GetKinematics
+	  * @return the state of the body the sensor is attached to, as of the end of
+	  * physics this tick. Shared with the agent when the sensor is on its root body.
+	  */
+	const FKinematicSnapshot& GetKinematics() const { return AgentKinematics != nullptr ? *AgentKinematics : LocalKinematics; }
+
 	AHolodeckPawnControllerInterface* Controller;
 	void* Buffer;
 
+	// Number of past samples to keep in shared memory, 0 turns the history off
+	int HistoryLength = 0;
+
+	// Estimated milliseconds a capture takes, used to stagger expensive sensors
+	float CaptureCost = 1;
+	// Tick within the capture period to capture on, -1 lets the scheduler pick
+	int CapturePhase = -1;
+
 	const FString SensorDataKey = "_sensor_data";
+	const FString SensorHistoryKey = "_sensor_history";
+	const FString SensorHistoryTicksKey = "_sensor_history_ticks";
+	const FString SensorHistoryIndexKey = "_sensor_history_index";
+	const FString SensorWantedKey = "_sensor_wanted";
+
+private:
+	/**
+	  * RunTick
+	  * Calls TickSensorComponent and records the history.
+	  * @return how long TickSensorComponent took, in milliseconds.
+	  */
+	double RunTick(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction);
+
+	/**
+	  * RecordHistory
+	  * Copies the current contents of Buffer into the next slot of the history ring.
+	  */
+	void RecordHistory();
+
+	/**
+	  * UpdateKinematics
+	  * Reads the state of the body the sensor is attached to, unless it's the
+	  * agent's root body, which the agent has already done. Game thread only.
+	  */
+	void UpdateKinematics(float DeltaTime);
+
+	// Points at the agent's snapshot when the sensor is on the agent's root body
+	const FKinematicSnapshot* AgentKinematics = nullptr;
+	FKinematicSnapshot LocalKinematics;
+	FKinematicSnapshot SnapshotLocalKinematics;
+
+	void* HistoryBuffer = nullptr;
+	uint32* HistoryTicksBuffer = nullptr;
+	// Total number of samples written, the next slot is this modulo HistoryLength
+	uint32* HistoryIndexBuffer = nullptr;
+	// Set by the client before each tick
+	bool* WantedBuffer = nullptr;
 };
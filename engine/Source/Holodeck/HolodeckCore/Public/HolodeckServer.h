@@ -10,6 +10,9 @@
 #include <cstring>
 
 #include "HolodeckSharedMemory.h"
+#include "TickRecorder.h"
+#include "HolodeckTelemetry.h"
+#include "SensorScheduler.h"
 #if PLATFORM_WINDOWS
 #define LOADING_SEMAPHORE_PATH "Global\\HOLODECK_LOADING_SEM"
 #define SEMAPHORE_PATH1 "Global\\HOLODECK_SEMAPHORE_SERVER"
@@ -101,6 +104,54 @@ public:
 	  */
 	bool IsRunning() const;
 
+	/**
+	  * BeginSchedule
+	  * Reads how many ticks the client asked for in this step. Should be called
+	  * right after Acquire returns. The request is consumed, so a client that
+	  * doesn't write it again gets a single tick.
+	  */
+	void BeginSchedule();
+
+	/**
+	  * AdvanceSchedule
+	  * Moves on to the next tick of the current step.
+	  * @return false once every tick of the step has run, meaning the server
+	  * should hand control back to the client.
+	  */
+	bool AdvanceSchedule();
+
+	/**
+	  * IsReplaying
+	  * @return true if the engine is being driven by a recorded log instead of a client.
+	  */
+	bool IsReplaying() const { return Recorder != nullptr && Recorder->IsReplaying(); }
+
+	/**
+	  * EndTick
+	  * Publishes the telemetry for the tick that just ran. Should be called at
+	  * the start of every tick, before control might go back to the client.
+	  */
+	void EndTick();
+
+	/**
+	  * GetTelemetry
+	  * @return the per tick timings, or nullptr if the server isn't running.
+	  */
+	HolodeckTelemetry* GetTelemetry() const { return Telemetry.get(); }
+
+	/**
+	  * GetSensorScheduler
+	  * @return the scheduler that staggers sensor captures, or nullptr if the
+	  * server isn't running.
+	  */
+	SensorScheduler* GetSensorScheduler() const { return Scheduler.get(); }
+
+	/**
+	  * GetTickCount
+	  * @return the number of ticks the engine has run since the server started.
+	  */
+	uint32 GetTickCount() const { return TickCount; }
+
 	/**
 	* MakeKey
 	* Makes a key for mallocing a specific item for a specific agent.
@@ -127,6 +178,27 @@ private:
 	std::map<std::string, std::unique_ptr<HolodeckSharedMemory>> Memory;
 	bool bIsRunning;
 
+	// Number of ticks the client wants run before it gets control back
+	uint32* ScheduleBuffer;
+	unsigned int ScheduleLength;
+	unsigned int ScheduleTick;
+	uint32 TickCount;
+
+	// Set when the engine was started with -HolodeckRecord or -HolodeckReplay
+	std::unique_ptr<TickRecorder> Recorder;
+
+	std::unique_ptr<HolodeckTelemetry> Telemetry;
+	double AcquireMs;
+
+	std::unique_ptr<SensorScheduler> Scheduler;
+
+	/**
+	  * StartTick
+	  * Resets the telemetry and hands the tick that's about to run to the
+	  * recorder, if there is one.
+	  */
+	void StartTick();
+
 	#if PLATFORM_WINDOWS
 	HANDLE LockingSemaphore1;
 	HANDLE LockingSemaphore2;
@@ -9,10 +9,54 @@
 #include "Octree.h"
 #include "Kismet/KismetMathLibrary.h"
 #include "Async/ParallelFor.h"
+#include "Async/Async.h"
+
+#include <atomic>
 
 #include "HolodeckSonar.generated.h"
 
 #define Pi 3.1415926535897932384626433832795
+
+// Values of the first word of the octree status buffer
+enum ESonarOctreeStatus : uint32 {
+	OctreeWaiting = 0,	// The octree hasn't been set up yet
+	OctreeBuilding = 1,	// The tiles near the sonar are being built in the background
+	OctreeReady = 2		// The sonar is making images
+};
+
+/**
+ * FSonarCapture
+ * Everything one image is made with: where the sensor is, the tiles and leaves found and
+ * how they're binned. The octree itself is only read while an image is made, the leaves
+ * that are found are copied into Octrees from the capture's pool. So several images can
+ * be made at once as long as each has its own capture, see RenderPoses.
+ *
+ * Sonars that need more than this keep it in a struct derived from it, see makeCapture.
+ */
+struct FSonarCapture
+{
+	virtual ~FSonarCapture();
+
+	// Gives the capture's noise generators streams of their own, derived from seed
+	virtual void reseed(uint32 seed) {}
+
+	// Where the sensor is for this image
+	FTransform SensorToWorld;
+
+	// The tiles in range
+	TArray<Octree*> bigLeaves;
+
+	// Used to hold leafs when parallelized filtering happens
+	TArray<TArray<Octree*>> foundLeaves;
+
+	// Used to hold leafs when parallelized sorting/binning happens
+	TArray<TArray<Octree*>> sortedLeaves;
+
+	// Found leaves are copied into Octrees from here. Reused every capture, one pool per foundLeaves
+	TArray<TArray<Octree*>> leafPool;
+	TArray<int32> leafPoolUsed;
+};
+
 /**
  * UHolodeckSonar
  */
@@ -25,13 +69,50 @@ public:
 	/*
 	* Default Constructor
 	*/
-	UHolodeckSonar(){}
+	UHolodeckSonar(){ CaptureCost = 20; }
+
+	/**
+	* InitializeSensor
+	* Sets up the octree status buffer.
+	*/
+	virtual void InitializeSensor() override;
 
 	/**
 	* Allows parameters to be set dynamically
 	*/
 	virtual void ParseSensorParms(FString ParmsJson) override;
 
+	/**
+	* SaveSnapshot / RestoreSnapshot
+	* See HolodeckSensor for the documentation of these overridden functions.
+	*/
+	virtual void SaveSnapshot() override;
+	virtual void RestoreSnapshot() override;
+
+	/**
+	* RenderPoses
+	* Computes an image with the sensor placed at each of the given poses,
+	* without moving it. Up to PoseCaptures poses are computed at once, each
+	* with a capture of its own and noise seeded for it. The sensor's own
+	* buffer is left alone.
+	* @param Poses world transforms of the sensor.
+	* @param Output where to write the images, GetNumItems floats each.
+	* @return how many images were made, 0 if the octree isn't ready yet.
+	*/
+	int RenderPoses(const TArray<FTransform>& Poses, float* Output);
+
+	/**
+	* GetImageSize
+	* @return the number of floats in one image.
+	*/
+	int GetImageSize() { return GetNumItems(); }
+
+	/**
+	* EndPlay
+	* Stops the background build of the initial tiles, since it needs the world.
+	*/
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	/*
 	* Cleans up octree
 	*/
@@ -40,6 +121,11 @@ public:
 protected:
 	void TickSensorComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 
+	// The sonar only computes an image on ticks where the counter rolls over
+	virtual bool HasNewData() override { return TickCounter == 0; }
+
+	virtual int GetCapturePeriod() override { return TicksPerCapture; }
+
 	UPROPERTY(EditAnywhere)
 	float RangeMax = 1000;
 
@@ -76,30 +162,64 @@ protected:
 	UPROPERTY(EditAnywhere)
 	bool ShowWarning = true;
 
+	// Size of the octree leaves this sonar sees, defaults to the scenario's octree_min
+	UPROPERTY(EditAnywhere)
+	float OctreeMin = 0;
+
+	// Size of the tiles at that resolution
+	float OctreeMax = 0;
+
 	// Call at the beginning of every tick, loads octree
 	void initOctree();
 
-	// Finds all the leaves in range
-	void findLeaves();
+	// Builds the tiles in toMake on the thread pool, so the simulation keeps ticking meanwhile
+	void premakeOctrees();
+
+	// Waits for the background build to stop, cancelling whatever tiles it hasn't started
+	void stopPremake();
+
+	// Writes the octree status and build progress for the client
+	void updateStatus();
+
+	// Makes an image from where the sensor is now and writes it to Buffer
+	void captureImage();
+
+	// Finds the tiles in range and puts them in bigLeaves, loading the index above them on the way.
+	// Tiles that are out of range are unloaded if unloadFar is set
+	void findTiles(FSonarCapture& capture, bool unloadFar);
+
+	// Loads the tiles found, each of them once
+	void loadTiles(const TArray<Octree*>& tiles);
+
+	// Finds all the leaves in range in the tiles found
+	void findLeaves(FSonarCapture& capture);
 
 	// Shadow leaves that have been sorted
-	void shadowLeaves();
+	void shadowLeaves(FSonarCapture& capture);
+
+	// Makes a capture's image and writes it to result, overridden by each sonar. The capture's tiles
+	// have been found and loaded already
+	virtual void computeImage(FSonarCapture& capture, float* result) {}
+
+	// Makes the scratch state for one image, sonars that need more than FSonarCapture override it
+	virtual TUniquePtr<FSonarCapture> makeCapture();
 
 	// Visualizer helpers
 	void showBeam(float DeltaTime);
 	virtual void showRegion(float DeltaTime);
 
-	// Used to hold leafs when parallelized filtering happens
-	TArray<TArray<Octree*>> foundLeaves;
+	// What the sensor's own images are made with, made when it's first needed
+	TUniquePtr<FSonarCapture> capture;
 
-	// Used to hold leafs when parallelized sorting/binning happens
-	TArray<TArray<Octree*>> sortedLeaves;
+	// What RenderPoses makes images with, reused for every batch
+	TArray<TUniquePtr<FSonarCapture>> poseCaptures;
 
 	// Water information
 	float WaterImpedance;
 
 	// use for skipping frames
 	int TickCounter = 0;
+	int SnapshotTickCounter = 0;
 
 	// various computations we want to cache
 	float ATan2Approx(float y, float x);
@@ -108,8 +228,19 @@ protected:
 	float minElev;
 	float maxElev;
 
-	virtual bool inRange(Octree* tree);
-	void leavesInRange(Octree* tree, TArray<Octree*>& leafs, float stopAt);
+	// Whether a node size across at loc is in the capture's view, and where it is from the sensor.
+	// Nothing is written to the node itself, so the octree can be searched by several captures at once
+	virtual bool inRange(const FSonarCapture& capture, const FVector& loc, float size, FVector& locSpherical);
+	// Finds the tiles in range under tree, see findTiles
+	void tilesInRange(FSonarCapture& capture, Octree* tree, bool unloadFar);
+	// Finds the leaves in range under a node of a tile, the leaves found go in foundLeaves[slot]
+	void leavesInRange(FSonarCapture& capture, Octree* tree, int32 slot);
+	// Same for the children of a DAG node at loc
+	void leavesInRange(FSonarCapture& capture, const OctreeDag* dag, int32 node, const FVector& loc, float size, int32 slot);
+	// Same for the children of a node of a tile read from the OctreeTileCache
+	void leavesInRange(FSonarCapture& capture, const OctreeTileCache::Node* node, float size, int32 slot);
+	// Copies a leaf into the capture's pool and adds it to foundLeaves[slot] if it's in range and faces the sonar
+	void addLeaf(FSonarCapture& capture, const FVector& loc, float size, const FVector& normal, float z, int32 slot);
 	FVector spherToEuc(float r, float theta, float phi, FTransform SensortoWorld);
 	
 private:
@@ -121,13 +252,29 @@ private:
 
 	// holds our implementation of Octrees
 	Octree* octree = nullptr;
+	// What they're built with, from the game mode
+	OctreeContext* octreeContext = nullptr;
 	TArray<Octree*> agents;
 	void viewLeaves(Octree* tree);
 
-	// What octrees we initally make
+	// How many of the context's rebuilt tiles have been swapped in
+	int32 octreeGeneration = 0;
+
+	// What octrees we initally make, emptied once they're all built
 	TArray<Octree*> toMake;
-	// initialize + reserve vectors once
-	TArray<Octree*> bigLeaves;
+
+	// Background build of toMake, and how many tiles of it are done
+	TFuture<void> premakeTask;
+	std::atomic<int32> premakeDone{ 0 };
+	std::atomic<bool> premakeCancel{ false };
+	int32 premakeTotal = 0;
+
+	// [status, tiles done, tiles total], see ESonarOctreeStatus
+	uint32* StatusBuffer = nullptr;
+	const FString OctreeStatusKey = "_octree_status";
+
+	// Most poses RenderPoses computes at once
+	int32 PoseCaptures = 0;
 
 	// various computations we want to cache
 	float sqrt3_2;
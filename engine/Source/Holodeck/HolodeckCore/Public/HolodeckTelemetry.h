@@ -0,0 +1,120 @@
+// MIT License (c) 2021 BYU FRoStLab see LICENSE file
+
+#pragma once
+
+#include "Holodeck.h"
+
+const char TELEMETRY_KEY[] = "telemetry";
+const int MAX_TELEMETRY_SENSORS = 128;
+const int TELEMETRY_NAME_LENGTH = 32;
+
+/**
+  * The parts of a tick that are timed as a whole.
+  */
+enum class ETelemetryStage : uint8 {
+	Acquire,
+	Commands,
+	Control,
+	Physics,
+	Count
+};
+
+/**
+  * Layout of the telemetry block in shared memory. Must match
+  * TELEMETRY_DTYPE in the client.
+  */
+struct FTelemetryHeader {
+	uint32 Tick;
+	uint32 NumSensors;
+	float TickMs;
+	float StageMs[(int)ETelemetryStage::Count];
+	float Reserved;
+};
+
+struct FSensorTelemetry {
+	char Agent[TELEMETRY_NAME_LENGTH];
+	char Sensor[TELEMETRY_NAME_LENGTH];
+	float Ms;
+	uint32 Reserved;
+};
+
+/**
+  * HolodeckTelemetry
+  * Times each part of a tick and publishes the result to shared memory, so the
+  * client can see where the frame budget goes. Owned by the server, which
+  * refreshes it every tick.
+  *
+  * Tick time is measured from when the server gets control to the start of
+  * the next tick, and doesn't include the time spent waiting on the client.
+  */
+class HOLODECK_API HolodeckTelemetry {
+public:
+	/**
+	  * Constructor
+	  * @param Buffer shared memory of at least BufferSize() bytes.
+	  */
+	explicit HolodeckTelemetry(void* Buffer);
+
+	static unsigned int BufferSize() {
+		return sizeof(FTelemetryHeader) + MAX_TELEMETRY_SENSORS * sizeof(FSensorTelemetry);
+	}
+
+	/**
+	  * StartTick
+	  * Clears the timings from the previous tick.
+	  * @param AcquireMs how long the server waited on the client before this tick.
+	  */
+	void StartTick(double AcquireMs);
+
+	/**
+	  * EndTick
+	  * Publishes the timings of the tick that just ran.
+	  * @param Tick the number of the tick that just ran.
+	  */
+	void EndTick(uint32 Tick);
+
+	/**
+	  * AddStageTime
+	  * Adds to the time spent in a stage this tick. Stages that run once per
+	  * agent (like control schemes) add up.
+	  */
+	void AddStageTime(ETelemetryStage Stage, double Ms);
+
+	/**
+	  * AddSensorTime
+	  * Records how long a sensor's TickSensorComponent took this tick. Sensors
+	  * past MAX_TELEMETRY_SENSORS are dropped.
+	  */
+	void AddSensorTime(const FString& Agent, const FString& Sensor, double Ms);
+
+	static double NowMs() { return FPlatformTime::Seconds() * 1000.0; }
+
+private:
+	FTelemetryHeader* Header;
+	FSensorTelemetry* Sensors;
+
+	double TickStartMs;
+	double StageMs[(int)ETelemetryStage::Count];
+	uint32 NumSensors;
+};
+
+/**
+  * FScopedTelemetry
+  * Adds the time until it goes out of scope to a stage. Does nothing if
+  * Telemetry is null.
+  */
+class FScopedTelemetry {
+public:
+	FScopedTelemetry(HolodeckTelemetry* Telemetry, ETelemetryStage Stage) :
+			Telemetry(Telemetry), Stage(Stage), StartMs(Telemetry ? HolodeckTelemetry::NowMs() : 0) {}
+
+	~FScopedTelemetry() {
+		if (Telemetry != nullptr)
+			Telemetry->AddStageTime(Stage, HolodeckTelemetry::NowMs() - StartMs);
+	}
+
+private:
+	HolodeckTelemetry* Telemetry;
+	ETelemetryStage Stage;
+	double StartMs;
+};
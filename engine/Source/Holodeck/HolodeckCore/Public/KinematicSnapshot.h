@@ -0,0 +1,64 @@
+// MIT License (c) 2021 BYU FRoStLab see LICENSE file
+
+#pragma once
+
+#include "Holodeck.h"
+
+/**
+  * FKinematicSnapshot
+  * Pose, velocities and accelerations of a body, taken once per tick after
+  * physics so every sensor on the body reads the same values without going
+  * back to physics. Accelerations are the change in velocity since the last
+  * update.
+  *
+  * The plain fields are in world frame and Unreal units, the Client ones are
+  * the same values already converted for the client. Sensors that aren't at
+  * the body's origin use GetVelocityAtPoint and GetAccelerationAtPoint.
+  */
+struct FKinematicSnapshot {
+	FTransform Pose = FTransform::Identity;
+	FVector CenterOfMass = FVector::ZeroVector;
+
+	// Of the center of mass
+	FVector LinearVelocity = FVector::ZeroVector;
+	FVector LinearAcceleration = FVector::ZeroVector;
+	// In radians per second, and radians per second squared
+	FVector AngularVelocity = FVector::ZeroVector;
+	FVector AngularAcceleration = FVector::ZeroVector;
+
+	FVector ClientPosition = FVector::ZeroVector;
+	FVector ClientLinearVelocity = FVector::ZeroVector;
+	FVector ClientLinearAcceleration = FVector::ZeroVector;
+	FVector ClientAngularVelocity = FVector::ZeroVector;
+	FVector ClientAngularAcceleration = FVector::ZeroVector;
+
+	/**
+	  * Update
+	  * Reads the current state of Body from physics. Must be called on the game thread.
+	  * The first update after construction has zero acceleration.
+	  * @param Body the body to read.
+	  * @param DeltaTime the time since the last update.
+	  */
+	void Update(UPrimitiveComponent* Body, float DeltaTime);
+
+	/**
+	  * GetVelocityAtPoint
+	  * Same as UPrimitiveComponent::GetPhysicsLinearVelocityAtPoint.
+	  */
+	FVector GetVelocityAtPoint(const FVector& Point) const {
+		return LinearVelocity + FVector::CrossProduct(AngularVelocity, Point - CenterOfMass);
+	}
+
+	/**
+	  * GetAccelerationAtPoint
+	  * Acceleration of a point fixed to the body, including the centripetal term.
+	  */
+	FVector GetAccelerationAtPoint(const FVector& Point) const {
+		FVector Arm = Point - CenterOfMass;
+		return LinearAcceleration + FVector::CrossProduct(AngularAcceleration, Arm)
+			+ FVector::CrossProduct(AngularVelocity, FVector::CrossProduct(AngularVelocity, Arm));
+	}
+
+private:
+	bool bHasPrevious = false;
+};
@@ -0,0 +1,133 @@
+// MIT License (c) 2021 BYU FRoStLab see LICENSE file
+
+#pragma once
+
+#include "Holodeck.h"
+
+#include <vector>
+
+const char SENSOR_SCHEDULE_KEY[] = "sensor_schedule";
+const int MAX_SCHEDULED_SENSORS = 64;
+const int SCHEDULE_NAME_LENGTH = 32;
+
+// Schedules are planned over the least common multiple of the periods, up to this many ticks
+const int MAX_SCHEDULE_HYPERPERIOD = 5040;
+
+class UHolodeckSensor;
+
+/**
+  * Layout of the schedule block in shared memory. Must match
+  * SENSOR_SCHEDULE_DTYPE in the client.
+  */
+struct FSensorScheduleHeader {
+	uint32 NumSensors;
+	uint32 Hyperperiod;
+	// Highest estimated cost of any one tick, with and without the phase offsets
+	float PeakCost;
+	float UnstaggeredPeakCost;
+	// Subtracted from the server's tick before it's checked against the phases, see SetTickOffset
+	uint32 TickOffset;
+};
+
+struct FSensorScheduleEntry {
+	char Agent[SCHEDULE_NAME_LENGTH];
+	char Sensor[SCHEDULE_NAME_LENGTH];
+	uint32 Period;
+	uint32 Phase;
+	float Cost;
+	uint32 bPinned;
+};
+
+/**
+  * SensorScheduler
+  * Decides which tick each sensor that doesn't capture every tick runs on.
+  * Left to themselves, sensors with the same period all capture on the same
+  * tick, so the expensive ones pile up. Sensors register with a period and an
+  * estimated cost, and the scheduler gives each a phase so the estimated cost
+  * of every tick is as even as it can make it.
+  *
+  * The plan is redone whenever a sensor registers or goes away, and is
+  * published to shared memory so the client can see what was chosen. It only
+  * depends on the periods, costs and the order sensors registered in, so a
+  * recorded run gets the same schedule when it's replayed.
+  */
+class HOLODECK_API SensorScheduler {
+public:
+	/**
+	  * Constructor
+	  * @param Buffer shared memory of at least BufferSize() bytes.
+	  */
+	explicit SensorScheduler(void* Buffer);
+
+	static unsigned int BufferSize() {
+		return sizeof(FSensorScheduleHeader) + MAX_SCHEDULED_SENSORS * sizeof(FSensorScheduleEntry);
+	}
+
+	/**
+	  * Register
+	  * Adds a sensor to the schedule, or updates it if it's already there.
+	  * @param Sensor the sensor, used as its key.
+	  * @param Period how many ticks apart its captures are.
+	  * @param Cost estimated cost of a capture, in milliseconds.
+	  * @param Phase tick within the period to capture on, or -1 to let the
+	  * scheduler pick.
+	  */
+	void Register(const UHolodeckSensor* Sensor, int Period, float Cost, int Phase = -1);
+
+	/**
+	  * Unregister
+	  * Removes a sensor from the schedule. Does nothing if it wasn't registered.
+	  */
+	void Unregister(const UHolodeckSensor* Sensor);
+
+	/**
+	  * IsDue
+	  * @return true if the sensor should capture on Tick. Sensors that aren't
+	  * registered capture every tick.
+	  */
+	bool IsDue(const UHolodeckSensor* Sensor, uint32 Tick) const;
+
+	/**
+	  * TicksUntilDue
+	  * @return how many ticks after Tick the sensor's next capture is, 0 if it's
+	  * due on Tick. Sensors that aren't registered are always due.
+	  */
+	int TicksUntilDue(const UHolodeckSensor* Sensor, uint32 Tick) const;
+
+	/**
+	  * SetTickOffset
+	  * Shifts every sensor's captures, so they fall on Tick - Offset's phase.
+	  * Restoring a snapshot sets it so captures land where they did when the
+	  * snapshot was saved, since the server's tick keeps counting.
+	  */
+	void SetTickOffset(uint32 Offset) { Header->TickOffset = Offset; }
+	uint32 GetTickOffset() const { return Header->TickOffset; }
+
+private:
+	struct FEntry {
+		const UHolodeckSensor* Sensor;
+		FString Agent;
+		FString Name;
+		int Period;
+		float Cost;
+		int PinnedPhase;
+		int Phase;
+		uint32 Order;
+	};
+
+	FSensorScheduleHeader* Header;
+	FSensorScheduleEntry* Entries;
+
+	std::vector<FEntry> Sensors;
+	uint32 NextOrder;
+
+	/**
+	  * Reschedule
+	  * Picks the phases again. Pinned sensors are placed first, then the rest
+	  * from most to least expensive, each on whichever phase keeps the busiest
+	  * tick it lands on the cheapest.
+	  */
+	void Reschedule();
+
+	void Publish(uint32 Hyperperiod, float PeakCost, float UnstaggeredPeakCost);
+};
@@ -0,0 +1,198 @@
+// MIT License (c) 2021 BYU FRoStLab see LICENSE file
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "HolodeckSharedMemory.h"
+
+#if PLATFORM_WINDOWS
+#include "AllowWindowsPlatformTypes.h"
+#include <windows.h>
+#include "HideWindowsPlatformTypes.h"
+#elif PLATFORM_LINUX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+/**
+  * TickLogChunk
+  * A fixed size memory mapped file that records are appended to. The number
+  * of bytes used is kept in the chunk's header, so a chunk stays readable even
+  * if the engine is killed while it's being written.
+  */
+class HOLODECK_API TickLogChunk {
+public:
+	/**
+	  * Constructor
+	  * Maps the chunk at Path. When Capacity is 0 the chunk is opened read only
+	  * and its size comes from the file, otherwise it's created with room for
+	  * Capacity bytes of records.
+	  */
+	TickLogChunk(const std::string& Path, uint64_t Capacity);
+
+	/**
+	  * Destructor
+	  * Unmaps the chunk, trimming it down to the bytes actually used.
+	  */
+	~TickLogChunk();
+
+	bool IsValid() const { return MemPointer != nullptr; }
+
+	/**
+	  * Append
+	  * Appends Size bytes to the chunk.
+	  * @return the offset they were written at, or -1 if they don't fit.
+	  */
+	int64_t Append(const void* Data, uint64_t Size);
+
+	/**
+	  * Read
+	  * @return a pointer to the record at Offset, or nullptr if it's out of bounds.
+	  */
+	const uint8_t* Read(uint64_t Offset, uint64_t Size) const;
+
+	uint64_t Used() const;
+
+private:
+	std::string Path;
+	uint64_t MapSize;
+	bool bWritable;
+	uint8_t* MemPointer;
+
+	#if PLATFORM_WINDOWS
+	HANDLE File;
+	HANDLE Mapping;
+	#elif PLATFORM_LINUX
+	int File;
+	#endif
+};
+
+/**
+  * TickRecorder
+  * Records everything the client feeds the engine each tick, along with the
+  * sensor outputs it asked for, so a run can be played back later without a
+  * client.
+  *
+  * The log lives in a directory. Records are appended to memory mapped chunk
+  * files (chunk_N.bin) and index.bin maps each tick to its chunk and offset.
+  * Only blocks that changed since the previous record are written.
+  *
+  * In replay mode the recorder reads the log instead, writes the recorded
+  * inputs into shared memory each tick and checks the sensor outputs against
+  * the recorded ones. How many ticks were replayed and how many outputs
+  * didn't match is written to replay.json in the log's directory.
+  */
+class HOLODECK_API TickRecorder {
+public:
+	typedef std::map<std::string, std::unique_ptr<HolodeckSharedMemory>> MemoryMap;
+
+	enum class EMode { Record, Replay };
+
+	/**
+	  * Constructor
+	  * @param Mode whether to record or replay.
+	  * @param Directory where the log lives.
+	  * @param Sensors names of the sensors whose outputs are recorded or checked.
+	  * "all" records every sensor.
+	  */
+	TickRecorder(EMode Mode, const std::string& Directory, const std::set<std::string>& Sensors);
+
+	~TickRecorder();
+
+	/**
+	  * FromCommandLine
+	  * Makes a recorder if -HolodeckRecord=<dir> or -HolodeckReplay=<dir> was
+	  * passed, and seeds the noise generators so the run can be reproduced.
+	  * @return the recorder, or nullptr if neither was passed.
+	  */
+	static std::unique_ptr<TickRecorder> FromCommandLine();
+
+	bool IsReplaying() const { return Mode == EMode::Replay; }
+
+	/**
+	  * IsFinished
+	  * @return true once a replay has run past the end of the log.
+	  */
+	bool IsFinished() const { return bFinished; }
+
+	/**
+	  * Tick
+	  * Should be called at the start of every tick. Finishes the record for the
+	  * previous tick with the outputs it produced and starts the one for Tick
+	  * with the inputs the engine is about to use.
+	  * @param TickNumber the tick that's about to run.
+	  * @param Memory every shared memory block the server has handed out.
+	  */
+	void Tick(uint32_t TickNumber, const MemoryMap& Memory);
+
+	/**
+	  * EndTick
+	  * Should be called once a tick has run, before the client gets to write
+	  * the next one's inputs. Finishes the tick's record with the outputs it
+	  * produced, and remembers the inputs as the engine left them.
+	  * @param Memory every shared memory block the server has handed out.
+	  */
+	void EndTick(const MemoryMap& Memory);
+
+	/**
+	  * Finish
+	  * Writes out the last record. Called when the server shuts down.
+	  */
+	void Finish(const MemoryMap& Memory);
+
+private:
+	enum EBlockKind : uint8_t { Input = 0, Output = 1 };
+
+	struct FIndexEntry {
+		uint32_t Tick;
+		uint32_t Chunk;
+		uint64_t Offset;
+	};
+
+	EMode Mode;
+	std::string Directory;
+	std::set<std::string> Sensors;
+	uint32_t Seed;
+
+	std::vector<std::unique_ptr<TickLogChunk>> Chunks;
+	std::FILE* IndexFile;
+	std::vector<FIndexEntry> Index;
+	size_t NextRecord;
+	uint32_t CurrentChunk;
+
+	bool bTickOpen;
+	bool bFinished;
+	uint32_t CurrentTick;
+	std::vector<uint8_t> Record;
+	uint32_t RecordBlocks;
+
+	// The latest contents of every block, as recorded
+	std::map<std::string, std::vector<uint8_t>> Latest;
+	uint64_t Mismatches;
+
+	bool IsOutput(const std::string& Key) const;
+	bool IsIgnored(const std::string& Key) const;
+
+	void OpenForRecording();
+	void OpenForReplay();
+
+	void CaptureBlocks(EBlockKind Kind, const MemoryMap& Memory);
+	void RememberInputs(const MemoryMap& Memory);
+	void AddBlock(EBlockKind Kind, const std::string& Key, const uint8_t* Data, uint32_t Size);
+	void WriteRecord();
+
+	bool ApplyRecord(uint32_t TickNumber, const MemoryMap& Memory);
+	void CheckOutputs(const MemoryMap& Memory);
+	void WriteReplaySummary();
+
+	std::string ChunkPath(size_t Chunk) const;
+};
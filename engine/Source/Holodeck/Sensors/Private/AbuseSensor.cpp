@@ -57,4 +57,14 @@ void UAbuseSensor::TickSensorComponent(float DeltaTime, ELevelTick TickType, FAc
 		// IsAbused must be reset in case the agent leaves its abusive state
 		Agent->IsAbused = false;
 	}
-}
\ No newline at end of file
+}
+
+void UAbuseSensor::SaveSnapshot() {
+	Super::SaveSnapshot();
+	SnapshotSpeed = PrevSpeed;
+}
+
+void UAbuseSensor::RestoreSnapshot() {
+	Super::RestoreSnapshot();
+	PrevSpeed = SnapshotSpeed;
+}
@@ -120,3 +120,19 @@ void UAcousticBeaconSensor::TickSensorComponent(float DeltaTime, ELevelTick Tick
 		}
 	}
 }
+
+void UAcousticBeaconSensor::SaveSnapshot() {
+	Super::SaveSnapshot();
+	SnapshotFromSensor = fromSensor;
+	SnapshotWaitTicks = WaitTicks;
+	for(int i=0;i<4;i++)
+		SnapshotWaitBuffer[i] = WaitBuffer[i];
+}
+
+void UAcousticBeaconSensor::RestoreSnapshot() {
+	Super::RestoreSnapshot();
+	fromSensor = SnapshotFromSensor;
+	WaitTicks = SnapshotWaitTicks;
+	for(int i=0;i<4;i++)
+		WaitBuffer[i] = SnapshotWaitBuffer[i];
+}
@@ -93,7 +93,7 @@ void UDVLSensor::TickSensorComponent(float DeltaTime, ELevelTick TickType, FActo
 		FVector Location = this->GetComponentLocation();
 
 		//UE4 gives us world velocity, rotate it to get local velocity
-		FVector Velocity = Parent->GetPhysicsLinearVelocityAtPoint(this->GetComponentLocation());
+		FVector Velocity = GetKinematics().GetVelocityAtPoint(Location);
 		Velocity = SensortoWorld.GetRotation().UnrotateVector(Velocity);
 		Velocity = ConvertLinearVector(Velocity, UEToClient);
 
@@ -35,9 +35,6 @@ void UDynamicsSensor::InitializeSensor() {
 	Parent = Cast<UPrimitiveComponent>(this->GetAttachParent());
 
 	// Initialize all vectors
-	LinearVelocityThen = FVector();
-	AngularVelocityThen = FVector();
-
 	LinearAcceleration = FVector();
 	LinearVelocity = FVector();
 	Position = FVector();
@@ -49,36 +46,28 @@ void UDynamicsSensor::InitializeSensor() {
 void UDynamicsSensor::TickSensorComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) {
 	//check if your parent pointer is valid, and if the sensor is on. Then get the location and buffer, then send the location to the buffer. 
 	if (Parent != nullptr && bOn) {
-		// Linear Acceleration & Velocity
-		LinearVelocityThen = LinearVelocity;
-		if(UseCOM){
-			LinearVelocity = Parent->GetPhysicsLinearVelocity();
-		}
-		else{
-			LinearVelocity  = Parent->GetPhysicsLinearVelocityAtPoint(this->GetComponentLocation());
-		}
-		LinearVelocity = ConvertLinearVector(LinearVelocity, UEToClient);
-		LinearAcceleration = (LinearVelocity - LinearVelocityThen) / DeltaTime;
+		const FKinematicSnapshot& Kinematics = GetKinematics();
 
-		// Position
+		// Linear Acceleration, Velocity & Position
 		if(UseCOM){
-			Position = this->GetAttachParent()->GetComponentLocation();
+			LinearAcceleration = Kinematics.ClientLinearAcceleration;
+			LinearVelocity = Kinematics.ClientLinearVelocity;
+			Position = Kinematics.ClientPosition;
 		}
 		else{
-			Position = this->GetComponentLocation();
+			FVector Location = this->GetComponentLocation();
+			LinearAcceleration = ConvertLinearVector(Kinematics.GetAccelerationAtPoint(Location), UEToClient);
+			LinearVelocity = ConvertLinearVector(Kinematics.GetVelocityAtPoint(Location), UEToClient);
+			Position = ConvertLinearVector(Location, UEToClient);
 		}
-		Position = ConvertLinearVector(Position, UEToClient);
-		
-		// Ang Acceleration & Velocity
-		AngularVelocityThen = AngularVelocity;
-		// Angular velocity doesn't depend on the location on the object
-		AngularVelocity = Parent->GetPhysicsAngularVelocityInRadians();
-		AngularVelocity = ConvertAngularVector(AngularVelocity, NoScale);
-		AngularAcceleration = (AngularVelocity - AngularVelocityThen) / DeltaTime;
+
+		// Ang Acceleration & Velocity don't depend on the location on the object
+		AngularAcceleration = Kinematics.ClientAngularAcceleration;
+		AngularVelocity = Kinematics.ClientAngularVelocity;
 
 		// Rotation
 		if(UseCOM){
-			Rotation = this->GetAttachParent()->GetComponentRotation();
+			Rotation = Kinematics.Pose.Rotator();
 		}
 		else{
 			Rotation = this->GetComponentRotation();
@@ -91,8 +91,6 @@ void UIMUSensor::InitializeSensor() {
 	WorldSettings = World->GetWorldSettings(false, false);
 	WorldGravity = WorldSettings->GetGravityZ();
 
-	VelocityThen = FVector();
-	VelocityNow = FVector();
 	LinearAccelerationVector = FVector();
 	AngularVelocityVector = FVector();
 }
@@ -134,13 +132,9 @@ void UIMUSensor::TickSensorComponent(float DeltaTime, ELevelTick TickType, FActo
 }
 
 void UIMUSensor::CalculateAccelerationVector(float DeltaTime) {
-	VelocityThen = VelocityNow;
-	VelocityNow  = Parent->GetPhysicsLinearVelocityAtPoint(this->GetComponentLocation());
-
 	RotationNow = this->GetComponentRotation();
 
-	LinearAccelerationVector = VelocityNow - VelocityThen;
-	LinearAccelerationVector /= DeltaTime;
+	LinearAccelerationVector = GetKinematics().GetAccelerationAtPoint(this->GetComponentLocation());
 
 	LinearAccelerationVector += FVector(0.0, 0.0, -WorldGravity);
 
@@ -148,16 +142,24 @@ void UIMUSensor::CalculateAccelerationVector(float DeltaTime) {
 }
 
 void UIMUSensor::CalculateAngularVelocityVector() {
-	AngularVelocityVector = Parent->GetPhysicsAngularVelocityInRadians();
-
-	AngularVelocityVector.X = AngularVelocityVector.X;
-	AngularVelocityVector.Y = AngularVelocityVector.Y;
-	AngularVelocityVector.Z = AngularVelocityVector.Z;
+	AngularVelocityVector = GetKinematics().AngularVelocity;
 
 	AngularVelocityVector = RotationNow.UnrotateVector(AngularVelocityVector); //Rotate from world angles to local angles.
 
 }
 
+void UIMUSensor::SaveSnapshot() {
+	Super::SaveSnapshot();
+	SnapshotBiasAccel = BiasAccel;
+	SnapshotBiasOmega = BiasOmega;
+}
+
+void UIMUSensor::RestoreSnapshot() {
+	Super::RestoreSnapshot();
+	BiasAccel = SnapshotBiasAccel;
+	BiasOmega = SnapshotBiasOmega;
+}
+
 FVector UIMUSensor::GetAccelerationVector() {
 	return LinearAccelerationVector;
 }
@@ -4,6 +4,7 @@
 
 URGBCamera::URGBCamera() {
 	SensorName = "RGBCamera";
+	CaptureCost = 5;
 }
 
 // Allows sensor parameters to be set programmatically from client.
@@ -31,9 +32,26 @@ void URGBCamera::InitializeSensor() {
 
 void URGBCamera::TickSensorComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) {
 
-	TickCounter++;
-	if (TickCounter == TicksPerCapture) {
+	// The read back is the slow part, so it's skipped when the client won't look at the pixels
+	if (IsCaptureTick() && IsWanted()) {
 		RenderRequest.RetrievePixels(Buffer, TargetTexture);
 		TickCounter = 0;
+	} else {
+		TickCounter++;
 	}
 }
+
+void URGBCamera::SetTicksPerCapture(int Ticks) {
+	TicksPerCapture = Ticks;
+	ScheduleCaptures();
+}
+
+void URGBCamera::SaveSnapshot() {
+	Super::SaveSnapshot();
+	SnapshotTickCounter = TickCounter;
+}
+
+void URGBCamera::RestoreSnapshot() {
+	Super::RestoreSnapshot();
+	TickCounter = SnapshotTickCounter;
+}
@@ -10,12 +10,6 @@ USidescanSonar::USidescanSonar() {
 	SensorName = "SidescanSonar";
 }
 
-void USidescanSonar::BeginDestroy() {
-	Super::BeginDestroy();
-
-	delete[] count;
-}
-
 // Allows sensor parameters to be set programmatically from client.
 void USidescanSonar::ParseSensorParms(FString ParmsJson) {
 
@@ -95,7 +89,7 @@ void USidescanSonar::ParseSensorParms(FString ParmsJson) {
 	}
 	else{
 		// Calculate how large the azimuth bins should be
-		AzimuthRes = (180 * Octree::OctreeMin) / (Pi * (RangeMin + 0.1 * (RangeMax - RangeMin)));
+		AzimuthRes = (180 * OctreeMin) / (Pi * (RangeMin + 0.1 * (RangeMax - RangeMin)));
 		AzimuthBins = Azimuth / AzimuthRes;
 	}
 
@@ -108,22 +102,22 @@ void USidescanSonar::ParseSensorParms(FString ParmsJson) {
 	}
 	else{
 		// Calculate how large our shadowing bins should be
-		ElevationBins = (RangeMin*Elevation*Pi/180) / Octree::OctreeMin;
+		ElevationBins = (RangeMin*Elevation*Pi/180) / OctreeMin;
 		if(ElevationBins < 1) ElevationBins = 1;
 		ElevationRes = Elevation / ElevationBins;
 	}
 }
 
-void USidescanSonar::InitializeSensor() {
-	Super::InitializeSensor();
-	
+TUniquePtr<FSonarCapture> USidescanSonar::makeCapture() {
+	TUniquePtr<FSidescanSonarCapture> c = MakeUnique<FSidescanSonarCapture>();
+
 	// setup count of each bin
-	count = new int32[RangeBins](); // Sidescan Sonar (1d array)
+	c->count.SetNumZeroed(RangeBins); // Sidescan Sonar (1d array)
+	c->sortedLeaves.SetNum(AzimuthBins*ElevationBins);
 
-	for(int i=0;i<AzimuthBins*ElevationBins;i++){
-		sortedLeaves.Add(TArray<Octree*>());
-		sortedLeaves[i].Reserve(10000);
-	}
+	c->addNoise = addNoise;
+	c->multNoise = multNoise;
+	return c;
 }
 
 // Conversion from Spherical coordinates to Euclidian
@@ -135,81 +129,89 @@ FVector spherToEucSS(float r, float theta, float phi, FTransform SensortoWorld){
 }
 
 
-void USidescanSonar::TickSensorComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) {
-	Super::TickSensorComponent(DeltaTime, TickType, ThisTickFunction);
+void USidescanSonar::computeImage(FSonarCapture& capture, float* result) {
+	FSidescanSonarCapture& c = static_cast<FSidescanSonarCapture&>(capture);
+	TArray<TArray<Octree*>>& sortedLeaves = c.sortedLeaves;
+	int32* count = c.count.GetData();
 
-	if(TickCounter == 0){
-		// reset things and get ready
-		float* result = static_cast<float*>(Buffer);
-		std::fill(result, result+RangeBins, 0);
-		std::fill(count, count+RangeBins, 0);
-		
-		for(auto& sl: sortedLeaves){
-			sl.Reset();
-		}
+	// reset things and get ready
+	std::fill(result, result+RangeBins, 0);
+	std::fill(count, count+RangeBins, 0);
+	
+	for(auto& sl: sortedLeaves){
+		sl.Reset();
+	}
 
-		// Finds leaves in range and puts them in foundLeaves
-		findLeaves();		
+	// Finds leaves in range and puts them in foundLeaves
+	findLeaves(c);		
 
 
-		// SORT THEM INTO AZIMUTH/ELEVATION BINS
-		int32 idx;
-		for(TArray<Octree*>& bin : foundLeaves){
-			for(Octree* l : bin){
-				// Compute bins while we're parallelized
-				l->idx.Y = (int32)((l->locSpherical.Y - minAzimuth)/ AzimuthRes);
-				l->idx.Z = (int32)((l->locSpherical.Z - minElev)/ ElevationRes);
-				// Sometimes we get float->int rounding errors
-				if(l->idx.Y == AzimuthBins) --l->idx.Y;
+	// SORT THEM INTO AZIMUTH/ELEVATION BINS
+	int32 idx;
+	for(TArray<Octree*>& bin : c.foundLeaves){
+		for(Octree* l : bin){
+			// Compute bins while we're parallelized
+			l->idx.Y = (int32)((l->locSpherical.Y - minAzimuth)/ AzimuthRes);
+			l->idx.Z = (int32)((l->locSpherical.Z - minElev)/ ElevationRes);
+			// Sometimes we get float->int rounding errors
+			if(l->idx.Y == AzimuthBins) --l->idx.Y;
 
-				// UE_LOG(LogTemp, Warning, TEXT("Index Y: %d"), l->idx.Y);
+			// UE_LOG(LogTemp, Warning, TEXT("Index Y: %d"), l->idx.Y);
 
-				idx = l->idx.Z*AzimuthBins + l->idx.Y;
-				sortedLeaves[idx].Emplace(l);
-			}
+			idx = l->idx.Z*AzimuthBins + l->idx.Y;
+			sortedLeaves[idx].Emplace(l);
 		}
+	}
 
 
-		// HANDLE SHADOWING
-		shadowLeaves();
-
+	// HANDLE SHADOWING
+	shadowLeaves(c);
 
-		// ADD IN ALL CONTRIBUTIONS
-		// Reuse idx variable from above
-		for(TArray<Octree*>& bin : sortedLeaves){
-			for(Octree* l : bin){
-				// Calculate range bin
-				l->idx.X = (int32)((l->locSpherical.X - RangeMin) / RangeRes);
 
-				// Add to their appropriate bin
-				if (l->idx.Y > (AzimuthBins / 2)){
-					idx = RangeBins / 2 - l->idx.X / 2 - 1;
-				}
-				else{
-					idx = RangeBins / 2 + l->idx.X / 2;
-				}
+	// ADD IN ALL CONTRIBUTIONS
+	// Reuse idx variable from above
+	for(TArray<Octree*>& bin : sortedLeaves){
+		for(Octree* l : bin){
+			// Calculate range bin
+			l->idx.X = (int32)((l->locSpherical.X - RangeMin) / RangeRes);
 
-				result[idx] += l->val;
-				++count[idx];
+			// Add to their appropriate bin
+			if (l->idx.Y > (AzimuthBins / 2)){
+				idx = RangeBins / 2 - l->idx.X / 2 - 1;
 			}
+			else{
+				idx = RangeBins / 2 + l->idx.X / 2;
+			}
+
+			result[idx] += l->val;
+			++count[idx];
 		}
+	}
 
 
-		// NORMALIZE THE BUFFER
-		for (int i = 0; i < RangeBins; i++) {
-			if(count[i] != 0){
-				result[i] *= (1 + multNoise.sampleFloat()) / count[i];
-				result[i] += addNoise.sampleRayleigh();
-			}
-			else{
-				result[i] = addNoise.sampleRayleigh();
-			}
+	// NORMALIZE THE BUFFER
+	for (int i = 0; i < RangeBins; i++) {
+		if(count[i] != 0){
+			result[i] *= (1 + c.multNoise.sampleFloat()) / count[i];
+			result[i] += c.addNoise.sampleRayleigh();
 		}
+		else{
+			result[i] = c.addNoise.sampleRayleigh();
+		}
+	}
+}
+
+
+void USidescanSonar::TickSensorComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) {
+	Super::TickSensorComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if(TickCounter == 0){
+		captureImage();
 	}
 
-	if (runtickCounter == 20 && (RangeMin*Elevation*Pi/180) / Octree::OctreeMin < 1)
+	if (runtickCounter == 20 && (RangeMin*Elevation*Pi/180) / OctreeMin < 1)
 	{
-		float recommendedElevation = Octree::OctreeMin * 180 / (RangeMin * Pi);
+		float recommendedElevation = OctreeMin * 180 / (RangeMin * Pi);
 		float recommendedOctreeMin = RangeMin * Elevation * Pi / 180 / 100;
 		GEngine->AddOnScreenDebugMessage(-1, 5.0f, FColor::Red, FString::Printf(TEXT("WARNING: Elevation angle potentially too small with current OctreeMin configuration\n Recommended changes (pick one):\n Elevation = %f\n OctreeMin = %f\n"), recommendedElevation, recommendedOctreeMin));
 	}
@@ -10,12 +10,6 @@ USinglebeamSonar::USinglebeamSonar() {
 	SensorName = "SinglebeamSonar";
 } 
 
-void USinglebeamSonar::BeginDestroy() {
-	Super::BeginDestroy();
-
-	delete[] count;
-}
-
 // Allows sensor parameters to be set programmatically from client.
 void USinglebeamSonar::ParseSensorParms(FString ParmsJson) {
 
@@ -57,7 +51,7 @@ void USinglebeamSonar::ParseSensorParms(FString ParmsJson) {
 		// If the user hasn't set this, this is a better default value
 		// If they have set it, the super class will take care of it
 		if (!JsonParsed->HasTypedField<EJson::Number>("ShadowEpsilon")) {
-			ShadowEpsilon = Octree::OctreeMin;
+			ShadowEpsilon = OctreeMin;
 		}
 
 		// Noise Parameters
@@ -103,7 +97,7 @@ void USinglebeamSonar::ParseSensorParms(FString ParmsJson) {
 	else{
 		// Calculate how large our shadowing bins should be
 		float dist = RangeMin;
-		OpeningAngleBins = (dist*OpeningAngle*Pi/180) / Octree::OctreeMin;
+		OpeningAngleBins = (dist*OpeningAngle*Pi/180) / OctreeMin;
 		if(OpeningAngleBins < 1) OpeningAngleBins = 1;
 		OpeningAngleRes = OpeningAngle / OpeningAngleBins;
 	}
@@ -118,7 +112,7 @@ void USinglebeamSonar::ParseSensorParms(FString ParmsJson) {
 	else{
 		// Calculate how large our shadowing bins should be
 		float dist = RangeMin;
-		CentralAngleBins = (dist*CentralAngle*Pi/180) / Octree::OctreeMin;
+		CentralAngleBins = (dist*CentralAngle*Pi/180) / OctreeMin;
 		if(CentralAngleBins < 6) CentralAngleBins = 6;
 		CentralAngleRes = CentralAngle / CentralAngleBins;
 	}
@@ -134,14 +128,6 @@ void USinglebeamSonar::InitializeSensor() {
 	maxCentralAngle = 180;
 	minOpeningAngle = 0;
 	maxOpeningAngle = OpeningAngle/2;
-	
-	// setup count of each bin
-	count = new int32[RangeBins]();
-
-	for(int i=0;i<CentralAngleBins*OpeningAngleBins;i++){
-		sortedLeaves.Add(TArray<Octree*>());
-		sortedLeaves[i].Reserve(10000);
-	}
 
 	// Cache some calculations for later
 	sqrt3_2 = UKismetMathLibrary::Sqrt(3)/2;
@@ -149,32 +135,46 @@ void USinglebeamSonar::InitializeSensor() {
 }
 
 
+TUniquePtr<FSonarCapture> USinglebeamSonar::makeCapture() {
+	TUniquePtr<FSinglebeamSonarCapture> c = MakeUnique<FSinglebeamSonarCapture>();
+
+	// setup count of each bin
+	c->count.SetNumZeroed(RangeBins);
+	c->sortedLeaves.SetNum(CentralAngleBins*OpeningAngleBins);
+
+	c->addNoise = addNoise;
+	c->multNoise = multNoise;
+	c->rNoise = rNoise;
+	return c;
+}
+
+
 // determine if a single leaf is in your tree
-bool USinglebeamSonar::inRange(Octree* tree){
-	FTransform SensortoWorld = this->GetComponentTransform();
+bool USinglebeamSonar::inRange(const FSonarCapture& capture, const FVector& loc, float size, FVector& locSpherical){
+	FTransform SensortoWorld = capture.SensorToWorld;
 	// if it's not a leaf, we use a bigger search area
 	float offset = 0;
 	float radius = 0;
 
-	if(tree->size != Octree::OctreeMin){
-		radius = tree->size*sqrt3_2;
+	if(size != OctreeMin){
+		radius = size*sqrt3_2;
 		offset = radius/sinOffset;
-		SensortoWorld.AddToTranslation( -this->GetForwardVector()*offset );
+		SensortoWorld.AddToTranslation( -SensortoWorld.GetUnitAxis(EAxis::X)*offset );
 	}
 	
 	// transform location to sensor frame instead of global (x y z)
-	FVector locLocal = SensortoWorld.GetRotation().UnrotateVector(tree->loc-SensortoWorld.GetTranslation());
+	FVector locLocal = SensortoWorld.GetRotation().UnrotateVector(loc-SensortoWorld.GetTranslation());
 
 	// check if it's in range
-	tree->locSpherical.X = locLocal.Size();
-	if(RangeMin+offset-radius >= tree->locSpherical.X || tree->locSpherical.X >= RangeMax+offset+radius) return false; 
+	locSpherical.X = locLocal.Size();
+	if(RangeMin+offset-radius >= locSpherical.X || locSpherical.X >= RangeMax+offset+radius) return false; 
 
 	// check if OpeningAngle is in range. OpeningAngle is angle off of x-axis
-	tree->locSpherical.Z = ATan2Approx(UKismetMathLibrary::Sqrt(UKismetMathLibrary::Square(locLocal.Y)+UKismetMathLibrary::Square(locLocal.Z)), locLocal.X); //OpeningAngle of leaf we are inspecting
-	if(minOpeningAngle >= tree->locSpherical.Z || tree->locSpherical.Z >= maxOpeningAngle) return false;
+	locSpherical.Z = ATan2Approx(UKismetMathLibrary::Sqrt(UKismetMathLibrary::Square(locLocal.Y)+UKismetMathLibrary::Square(locLocal.Z)), locLocal.X); //OpeningAngle of leaf we are inspecting
+	if(minOpeningAngle >= locSpherical.Z || locSpherical.Z >= maxOpeningAngle) return false;
 
 	// save CentralAngle for shadowing later. CentralAngle goes around the x-axis
-	tree->locSpherical.Y = ATan2Approx(locLocal.Z, locLocal.Y);
+	locSpherical.Y = ATan2Approx(locLocal.Z, locLocal.Y);
 
 	// otherwise it's in!
 	return true;
@@ -191,74 +191,82 @@ void USinglebeamSonar::showRegion(float DeltaTime){
 	}		
 }
 
-void USinglebeamSonar::TickSensorComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) {
-	Super::TickSensorComponent(DeltaTime, TickType, ThisTickFunction);
+void USinglebeamSonar::computeImage(FSonarCapture& capture, float* result) {
+	FSinglebeamSonarCapture& c = static_cast<FSinglebeamSonarCapture&>(capture);
+	TArray<TArray<Octree*>>& sortedLeaves = c.sortedLeaves;
+	int32* count = c.count.GetData();
 
-	if(TickCounter == 0){
-		// reset things and get ready
-		float* result = static_cast<float*>(Buffer);
-		std::fill(result, result+RangeBins, 0);
-		std::fill(count, count+RangeBins, 0);
-		
-		for(auto& sl: sortedLeaves){
-			sl.Reset();
-		}
+	// reset things and get ready
+	std::fill(result, result+RangeBins, 0);
+	std::fill(count, count+RangeBins, 0);
+	
+	for(auto& sl: sortedLeaves){
+		sl.Reset();
+	}
 
-		// Finds leaves in range and puts them in foundLeaves
-		findLeaves();		// does not return anything, saves to foundLeaves
+	// Finds leaves in range and puts them in foundLeaves
+	findLeaves(c);		// does not return anything, saves to foundLeaves
 
 
-		// SORT THEM INTO CENTRALANGLE/OPENINGANGLE BINS
-		int32 idx;
-		for(TArray<Octree*>& bin : foundLeaves){
-			for(Octree* l : bin){
-				// Compute bins while we're parallelized
-				l->idx.Y = (int32)((l->locSpherical.Y - minCentralAngle)/ CentralAngleRes);
-				l->idx.Z = (int32)((l->locSpherical.Z - minOpeningAngle)/ OpeningAngleRes);
-				// Sometimes we get float->int rounding errors
-				if(l->idx.Y == CentralAngleBins) --l->idx.Y;
+	// SORT THEM INTO CENTRALANGLE/OPENINGANGLE BINS
+	int32 idx;
+	for(TArray<Octree*>& bin : c.foundLeaves){
+		for(Octree* l : bin){
+			// Compute bins while we're parallelized
+			l->idx.Y = (int32)((l->locSpherical.Y - minCentralAngle)/ CentralAngleRes);
+			l->idx.Z = (int32)((l->locSpherical.Z - minOpeningAngle)/ OpeningAngleRes);
+			// Sometimes we get float->int rounding errors
+			if(l->idx.Y == CentralAngleBins) --l->idx.Y;
 
-				idx = l->idx.Z*CentralAngleBins + l->idx.Y;
-				// array of arrays (the rectangle we split off)
-				sortedLeaves[idx].Emplace(l);
-			}
+			idx = l->idx.Z*CentralAngleBins + l->idx.Y;
+			// array of arrays (the rectangle we split off)
+			sortedLeaves[idx].Emplace(l);
 		}
+	}
 
-		// HANDLE SHADOWING
-		shadowLeaves();
+	// HANDLE SHADOWING
+	shadowLeaves(c);
 
 
-		// ADD IN ALL CONTRIBUTIONS
-		float range_noise;
-		for(TArray<Octree*>& bin : sortedLeaves){
-			for(Octree* l : bin){
-				// Add noise to each of them
-				range_noise = rNoise.sampleExponential();
-				l->idx.X = (int32)((l->locSpherical.X - RangeMin + range_noise) / RangeRes); 
+	// ADD IN ALL CONTRIBUTIONS
+	float range_noise;
+	for(TArray<Octree*>& bin : sortedLeaves){
+		for(Octree* l : bin){
+			// Add noise to each of them
+			range_noise = c.rNoise.sampleExponential();
+			l->idx.X = (int32)((l->locSpherical.X - RangeMin + range_noise) / RangeRes); 
 
-				// In case our noise has pushed us out of range
-				if(l->idx.X >= RangeBins) l->idx.X = RangeBins-1;
+			// In case our noise has pushed us out of range
+			if(l->idx.X >= RangeBins) l->idx.X = RangeBins-1;
 
-				// Add to their appropriate bin
-				idx = l->idx.X;
+			// Add to their appropriate bin
+			idx = l->idx.X;
 
-				result[idx] += l->val;
-				++count[idx];
-			}
+			result[idx] += l->val;
+			++count[idx];
+		}
+	}
+	
+
+	// MOVE THEM INTO BUFFER
+	for (int i = 0; i < RangeBins; i++) {
+		if(count[i] != 0){
+
+			// actually take the average of the intensities
+			result[i] *= (1 + c.multNoise.sampleFloat())/count[i];
+			result[i] += c.addNoise.sampleRayleigh();
+		}
+		else{
+			result[i] = c.addNoise.sampleRayleigh();
 		}
-		
-
-		// MOVE THEM INTO BUFFER
-		for (int i = 0; i < RangeBins; i++) {
-			if(count[i] != 0){
-
-				// actually take the average of the intensities
-				result[i] *= (1 + multNoise.sampleFloat())/count[i];
-				result[i] += addNoise.sampleRayleigh();
-			}
-			else{
-				result[i] = addNoise.sampleRayleigh();
-			}
-		}		
+	}		
+}
+
+
+void USinglebeamSonar::TickSensorComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) {
+	Super::TickSensorComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if(TickCounter == 0){
+		captureImage();
 	}
 }
@@ -16,7 +16,7 @@ void UVelocitySensor::InitializeSensor() {
 void UVelocitySensor::TickSensorComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) {
 	//check if your parent pointer is valid, and if the sensor is on. Then get the velocity and buffer, then send the data to it. 
 	if (Parent != nullptr && bOn) {
-		FVector Velocity = Parent->GetPhysicsLinearVelocityAtPoint(this->GetComponentLocation());
+		FVector Velocity = GetKinematics().GetVelocityAtPoint(this->GetComponentLocation());
 		Velocity = ConvertLinearVector(Velocity, UEToClient);
 		float* FloatBuffer = static_cast<float*>(Buffer);
 		FloatBuffer[0] = Velocity.X;
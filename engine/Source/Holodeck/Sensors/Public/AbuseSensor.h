@@ -30,6 +30,13 @@ public:
 
 	virtual void ParseSensorParms(FString ParmsJson) override;
 
+	/**
+	* SaveSnapshot / RestoreSnapshot
+	* See HolodeckSensor for the documentation of these overridden functions.
+	*/
+	virtual void SaveSnapshot() override;
+	virtual void RestoreSnapshot() override;
+
 protected:
 	//See HolodeckSensor for the documentation of these overridden functions.
 	int GetNumItems() override { return 1; };
@@ -39,5 +46,6 @@ protected:
 private:
 	AHolodeckAgent* Agent;
 	FVector PrevSpeed;
+	FVector SnapshotSpeed;
 	float AccelerationLimit;
 };
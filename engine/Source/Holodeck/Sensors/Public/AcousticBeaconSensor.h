@@ -38,6 +38,13 @@ public:
 	*/
 	virtual void ParseSensorParms(FString ParmsJson) override;
 
+	/**
+	* SaveSnapshot / RestoreSnapshot
+	* See HolodeckSensor for the documentation of these overridden functions.
+	*/
+	virtual void SaveSnapshot() override;
+	virtual void RestoreSnapshot() override;
+
 protected:
 	//See HolodeckSensor for the documentation of these overridden functions.
 	int GetNumItems() override { return 4; };
@@ -62,6 +69,11 @@ private:
     AActor* Parent;
 	float WaitBuffer[4];
 	int WaitTicks = -1;
+
+	// Saved by SaveSnapshot
+	UAcousticBeaconSensor* SnapshotFromSensor = NULL;
+	float SnapshotWaitBuffer[4];
+	int SnapshotWaitTicks = -1;
 	float SpeedOfSound = 1500;
 	MultivariateNormal<1> DistanceNoise;
 };
@@ -42,6 +42,8 @@ protected:
 	int GetNumItems() override { return ReturnRange ? 7 : 3; };
 	int GetItemSize() override { return sizeof(float); };
 	void TickSensorComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	// Range traces and debug lines go through the world, so they're only done from the game thread
+	bool IsThreadSafe() override { return !DebugLines && !ReturnRange; }
 
 	UPROPERTY(EditAnywhere)
 	bool DebugLines = false;
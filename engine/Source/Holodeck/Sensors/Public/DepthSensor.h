@@ -41,6 +41,7 @@ protected:
 	int GetNumItems() override { return 1; };
 	int GetItemSize() override { return sizeof(float); };
 	void TickSensorComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	bool IsThreadSafe() override { return true; }
 
 private:
 	/*
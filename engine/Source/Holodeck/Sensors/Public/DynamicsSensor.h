@@ -39,6 +39,7 @@ protected:
 	int GetNumItems() override { return UseRPY ? 18 : 19; };
 	int GetItemSize() override { return sizeof(float); };
 	void TickSensorComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	bool IsThreadSafe() override { return true; }
 
 	UPROPERTY(EditAnywhere)
 	bool UseCOM = true;
@@ -53,9 +54,6 @@ private:
 	 */
 	UPrimitiveComponent* Parent;
 
-	FVector LinearVelocityThen;
-	FVector AngularVelocityThen;
-
 	FVector LinearAcceleration;
 	FVector LinearVelocity;
 	FVector Position;
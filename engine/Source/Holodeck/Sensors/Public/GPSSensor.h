@@ -42,6 +42,7 @@ protected:
 	int GetNumItems() override { return 3; };
 	int GetItemSize() override { return sizeof(float); };
 	void TickSensorComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	bool IsThreadSafe() override { return true; }
 
 	UPROPERTY(EditAnywhere)
 	float GPSDepth = 2;
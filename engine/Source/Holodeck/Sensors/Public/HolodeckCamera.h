@@ -38,6 +38,7 @@ public:
 protected:
 	//Checkout HolodeckSensor.h for the documentation for this overridden function.
 	virtual void TickSensorComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction);
+	virtual bool NeedsRendering() override { return true; }
 	FColor* Buffer;
 	FRenderRequest RenderRequest;
 
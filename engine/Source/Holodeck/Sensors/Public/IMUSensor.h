@@ -48,11 +48,19 @@ public:
 	*/
 	virtual void ParseSensorParms(FString ParmsJson) override;
 
+	/**
+	* SaveSnapshot / RestoreSnapshot
+	* See HolodeckSensor for the documentation of these overridden functions.
+	*/
+	virtual void SaveSnapshot() override;
+	virtual void RestoreSnapshot() override;
+
 protected:
 	// See HolodeckSensor for more information on these overridden functions.
 	int GetNumItems() override { return ReturnBias ? 12 : 6; };
 	int GetItemSize() override { return sizeof(float); };
 	void TickSensorComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	bool IsThreadSafe() override { return true; }
 
 	UPROPERTY(EditAnywhere)
 	bool ReturnBias = false;
@@ -77,8 +85,6 @@ private:
 	AWorldSettings* WorldSettings;
 	float WorldGravity;
 
-	FVector VelocityThen;
-	FVector VelocityNow;
 	FRotator RotationNow;
 
 	FVector LinearAccelerationVector;
@@ -91,4 +97,8 @@ private:
 	MultivariateNormal<3> mvnBiasOmega;
 	FVector BiasAccel = FVector(0);
 	FVector BiasOmega = FVector(0);
+
+	// Saved by SaveSnapshot
+	FVector SnapshotBiasAccel;
+	FVector SnapshotBiasOmega;
 };
\ No newline at end of file
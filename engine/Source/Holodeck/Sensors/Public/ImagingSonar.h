@@ -18,6 +18,36 @@
 #include "ImagingSonar.generated.h"
 
 #define Pi 3.1415926535897932384626433832795
+
+/**
+ * FImagingSonarCapture
+ * What one imaging sonar image is made with, on top of FSonarCapture. The noise
+ * generators are copies of the sensor's, so images made at once each draw their own.
+ */
+struct FImagingSonarCapture : public FSonarCapture
+{
+	void reseed(uint32 seed) override {
+		std::seed_seq seq{ seed };
+		uint32 seeds[3];
+		seq.generate(seeds, seeds+3);
+		addNoise.reseed(seeds[0]);
+		multNoise.reseed(seeds[1]);
+		rNoise.reseed(seeds[2]);
+	}
+
+	// Used to hold leaves for multipath
+	TMap<FIntVector,Octree*> mapLeaves;
+	TMap<FIntVector,Octree*> mapSearch;
+	TArray<TArray<Octree*>> cluster;
+	TArray<int32> count;
+	TArray<int32> hasPerfectNormal;
+
+	// for adding noise
+	MultivariateNormal<1> addNoise;
+	MultivariateNormal<1> multNoise;
+	MultivariateUniform<1> rNoise;
+};
+
 /**
  * UImagingSonar
  */
@@ -43,16 +73,13 @@ public:
 	*/
 	virtual void ParseSensorParms(FString ParmsJson) override;
 
-	/*
-	* Cleans up octree
-	*/
-	virtual void BeginDestroy() override;
-
 protected:
 	//See HolodeckSensor for the documentation of these overridden functions.
 	int GetNumItems() override { return RangeBins*AzimuthBins; };
 	int GetItemSize() override { return sizeof(float); };
 	void TickSensorComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	void computeImage(FSonarCapture& capture, float* result) override;
+	TUniquePtr<FSonarCapture> makeCapture() override;
 
 	UPROPERTY(EditAnywhere)
 	int32 RangeBins = 0;
@@ -94,15 +121,8 @@ private:
 	// various computations we want to cache
 	int32 AzimuthBinScale = 1;
 	float perfectCos;
-
-	// Used to hold leaves for multipath
-	TMap<FIntVector,Octree*> mapLeaves;
-	TMap<FIntVector,Octree*> mapSearch;
-	TArray<TArray<Octree*>> cluster;
-	int32* count;
-	int32* hasPerfectNormal;
 	
-	// for adding noise
+	// for adding noise, each capture gets a copy
 	MultivariateNormal<1> addNoise;
 	MultivariateNormal<1> multNoise;
 	MultivariateUniform<1> rNoise;
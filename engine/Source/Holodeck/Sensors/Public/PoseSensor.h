@@ -37,6 +37,7 @@ protected:
 	int GetNumItems() override { return 16; };
 	int GetItemSize() override { return sizeof(float); };
 	void TickSensorComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	bool IsThreadSafe() override { return true; }
 
 private:
 	UPrimitiveComponent* Parent;
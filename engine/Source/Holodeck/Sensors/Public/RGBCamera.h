@@ -23,6 +23,19 @@ public:
 	*/
 	virtual void ParseSensorParms(FString ParmsJson) override;
 
+	/**
+	* SaveSnapshot / RestoreSnapshot
+	* See HolodeckSensor for the documentation of these overridden functions.
+	*/
+	virtual void SaveSnapshot() override;
+	virtual void RestoreSnapshot() override;
+
+	/**
+	* SetTicksPerCapture
+	* Changes how often the camera captures, and moves it on the capture schedule.
+	*/
+	void SetTicksPerCapture(int Ticks);
+
 	UPROPERTY(EditAnywhere)
 	int TicksPerCapture = 1;
 
@@ -33,7 +46,13 @@ protected:
 	virtual int GetNumItems() { return CaptureWidth * CaptureHeight; };
 	virtual int GetItemSize() { return sizeof(float); };
 
+	// The counter rolls over to zero on ticks where the pixels were read back
+	virtual bool HasNewData() override { return TickCounter == 0; }
+
+	virtual int GetCapturePeriod() override { return TicksPerCapture; }
+
 private:
 	int TickCounter = 0;
+	int SnapshotTickCounter = 0;
 
 };
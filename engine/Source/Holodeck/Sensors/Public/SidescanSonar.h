@@ -16,6 +16,30 @@
 #include "SidescanSonar.generated.h"
 
 #define Pi 3.1415926535897932384626433832795
+
+/**
+ * FSidescanSonarCapture
+ * What one sidescan image is made with, on top of FSonarCapture. The noise
+ * generators are copies of the sensor's, so images made at once each draw their own.
+ */
+struct FSidescanSonarCapture : public FSonarCapture
+{
+	void reseed(uint32 seed) override {
+		std::seed_seq seq{ seed };
+		uint32 seeds[2];
+		seq.generate(seeds, seeds+2);
+		addNoise.reseed(seeds[0]);
+		multNoise.reseed(seeds[1]);
+	}
+
+	// Used for counting how many leaves in a bin for averaging at the end
+	TArray<int32> count;
+
+	// for adding noise
+	MultivariateNormal<1> addNoise;
+	MultivariateNormal<1> multNoise;
+};
+
 /**
  * USidescanSonar
  */
@@ -30,27 +54,18 @@ public:
     */
    USidescanSonar();
 
-	/**
-	* InitializeSensor
-	* Sets up the class
-	*/
-	virtual void InitializeSensor() override;
-
 	/**
 	* Allows parameters to be set dynamically
 	*/
 	virtual void ParseSensorParms(FString ParmsJson) override;
 
-	/*
-	* Cleans up octree
-	*/
-	virtual void BeginDestroy() override;
-
 protected:
 	//See HolodeckSensor for the documentation of these overridden functions.
 	int GetNumItems() override { return RangeBins; }; // Returns 1D array for buffer for Sidescan Sonar
 	int GetItemSize() override { return sizeof(float); };
 	void TickSensorComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	void computeImage(FSonarCapture& capture, float* result) override;
+	TUniquePtr<FSonarCapture> makeCapture() override;
 
 	UPROPERTY(EditAnywhere)
 	int32 RangeBins = 0;
@@ -77,11 +92,9 @@ private:
 	 */
 	AActor* Parent;
 
-	// Used for counting how many leaves in a bin for averaging at the end
-	int32* count;
 	uint32 runtickCounter = 0;
 	
-	// for adding noise
+	// for adding noise, each capture gets a copy
 	MultivariateNormal<1> addNoise;
 	MultivariateNormal<1> multNoise;
 };
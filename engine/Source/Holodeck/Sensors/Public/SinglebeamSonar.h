@@ -17,6 +17,32 @@
 #include "SinglebeamSonar.generated.h"
 
 #define Pi 3.1415926535897932384626433832795
+
+/**
+ * FSinglebeamSonarCapture
+ * What one singlebeam image is made with, on top of FSonarCapture. The noise
+ * generators are copies of the sensor's, so images made at once each draw their own.
+ */
+struct FSinglebeamSonarCapture : public FSonarCapture
+{
+	void reseed(uint32 seed) override {
+		std::seed_seq seq{ seed };
+		uint32 seeds[3];
+		seq.generate(seeds, seeds+3);
+		addNoise.reseed(seeds[0]);
+		multNoise.reseed(seeds[1]);
+		rNoise.reseed(seeds[2]);
+	}
+
+	// Used for counting how many leaves in a bin for averaging at the end
+	TArray<int32> count;
+
+	// for adding noise
+	MultivariateNormal<1> addNoise;
+	MultivariateNormal<1> multNoise;
+	MultivariateUniform<1> rNoise;
+};
+
 /**
  * USinglebeamSonar
  */
@@ -42,20 +68,17 @@ public:
 	*/
 	virtual void ParseSensorParms(FString ParmsJson) override;
 
-	/*
-	* Cleans up octree
-	*/
-	virtual void BeginDestroy() override;
-
 protected:
 	//See HolodeckSensor for the documentation of these overridden functions.
 	int GetNumItems() override { return RangeBins; };
 	int GetItemSize() override { return sizeof(float); };
 	void TickSensorComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	void computeImage(FSonarCapture& capture, float* result) override;
+	TUniquePtr<FSonarCapture> makeCapture() override;
 
 	virtual void showRegion(float DeltaTime) override;
 
-	virtual bool inRange(Octree* tree) override;
+	virtual bool inRange(const FSonarCapture& capture, const FVector& loc, float size, FVector& locSpherical) override;
 	
 	UPROPERTY(EditAnywhere)
 	float OpeningAngle = 30;
@@ -96,11 +119,8 @@ private:
 	// various computations we want to cache
 	float sqrt3_2;
 	float sinOffset;
-
-	// Used to hold leafs when parallelized sorting/binning happens
-	int32* count;
 	
-	// for adding noise
+	// for adding noise, each capture gets a copy
 	MultivariateNormal<1> addNoise;
 	MultivariateNormal<1> multNoise;
 	MultivariateUniform<1> rNoise;
@@ -35,6 +35,7 @@ protected:
 	int GetNumItems() override { return Width * Height; };
 	int GetItemSize() override { return sizeof(FColor); };
 	void TickSensorComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	bool NeedsRendering() override { return true; }
 
 	UPROPERTY(EditAnywhere)
 	bool bGrayScale;
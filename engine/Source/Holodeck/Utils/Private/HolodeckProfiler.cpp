@@ -0,0 +1,225 @@
+// MIT License (c) 2021 BYU FRoStLab see LICENSE file
+
+#include "Holodeck.h"
+#include "HolodeckProfiler.h"
+
+#include "HAL/ThreadManager.h"
+
+#include <map>
+#include <string>
+
+// Histogram buckets are powers of two microseconds, the last one catches everything longer
+const int NUM_HISTOGRAM_BUCKETS = 24;
+
+struct FZoneEvent {
+	const char* Name;
+	uint64 Id;
+	uint64 Parent;
+	uint64 Start;
+	uint64 End;
+};
+
+struct FProfileThreadBuffer {
+	uint32 ThreadId;
+	FString ThreadName;
+	TArray<FZoneEvent> Events;
+	// Innermost open zone on this thread
+	uint64 CurrentZone = 0;
+	FCriticalSection Lock;
+};
+
+struct FZoneStats {
+	uint64 Count = 0;
+	double TotalUs = 0;
+	double MinUs = 0;
+	double MaxUs = 0;
+	uint64 Buckets[NUM_HISTOGRAM_BUCKETS] = { 0 };
+};
+
+std::atomic<bool> HolodeckProfiler::bEnabled{ false };
+
+namespace {
+	FCriticalSection BuffersLock;
+	TArray<FProfileThreadBuffer*> Buffers;
+	thread_local FProfileThreadBuffer* LocalBuffer = nullptr;
+
+	std::atomic<uint64> NextZoneId{ 1 };
+
+	int PendingTicks = 0;
+	FString PendingPath;
+	int TicksLeft = 0;
+	FString CapturePath;
+	uint64 CaptureStart = 0;
+
+	FProfileThreadBuffer* GetLocalBuffer() {
+		if (LocalBuffer == nullptr) {
+			// Thread buffers live as long as the process, worker threads don't go away
+			LocalBuffer = new FProfileThreadBuffer();
+			LocalBuffer->ThreadId = FPlatformTLS::GetCurrentThreadId();
+			LocalBuffer->ThreadName = IsInGameThread() ? FString("GameThread") : FThreadManager::GetThreadName(LocalBuffer->ThreadId);
+			if (LocalBuffer->ThreadName.IsEmpty())
+				LocalBuffer->ThreadName = FString::Printf(TEXT("Thread %u"), LocalBuffer->ThreadId);
+
+			FScopeLock ScopeLock(&BuffersLock);
+			Buffers.Add(LocalBuffer);
+		}
+		return LocalBuffer;
+	}
+
+	double CyclesToUs(uint64 Cycles) {
+		return Cycles * FPlatformTime::GetSecondsPerCycle64() * 1e6;
+	}
+
+	FString EscapeJson(const char* Str) {
+		return FString(UTF8_TO_TCHAR(Str)).ReplaceCharWithEscapedChar();
+	}
+}
+
+void FProfileZone::Begin(const char* NameParam, uint64 ParentParam) {
+	FProfileThreadBuffer* Local = GetLocalBuffer();
+	Buffer = Local;
+	Name = NameParam;
+	Id = NextZoneId++;
+	Parent = ParentParam != 0 ? ParentParam : Local->CurrentZone;
+	PreviousZone = Local->CurrentZone;
+	Local->CurrentZone = Id;
+	StartCycles = FPlatformTime::Cycles64();
+}
+
+void FProfileZone::End() {
+	uint64 EndCycles = FPlatformTime::Cycles64();
+	FProfileThreadBuffer* Local = static_cast<FProfileThreadBuffer*>(Buffer);
+	Local->CurrentZone = PreviousZone;
+
+	// The capture may have ended while this zone was open
+	if (!HolodeckProfiler::IsEnabled())
+		return;
+
+	FScopeLock ScopeLock(&Local->Lock);
+	Local->Events.Add({ Name, Id, Parent, StartCycles, EndCycles });
+}
+
+uint64 HolodeckProfiler::CurrentZone() {
+	if (!IsEnabled())
+		return 0;
+	return GetLocalBuffer()->CurrentZone;
+}
+
+void HolodeckProfiler::Capture(int NumTicks, const FString& Path) {
+	if (NumTicks <= 0) {
+		UE_LOG(LogHolodeck, Warning, TEXT("HolodeckProfiler:: Asked to profile %d ticks, ignoring"), NumTicks);
+		return;
+	}
+
+	PendingTicks = NumTicks;
+	PendingPath = Path.IsEmpty() ? FPaths::ProjectLogDir() / TEXT("HolodeckProfile.json") : Path;
+}
+
+void HolodeckProfiler::CaptureFromCommandLine() {
+	int NumTicks;
+	if (FParse::Value(FCommandLine::Get(), TEXT("HolodeckProfile="), NumTicks)) {
+		FString Path;
+		FParse::Value(FCommandLine::Get(), TEXT("HolodeckProfilePath="), Path);
+		Capture(NumTicks, Path);
+	}
+}
+
+void HolodeckProfiler::OnTick() {
+	if (IsEnabled() && --TicksLeft <= 0) {
+		bEnabled = false;
+		Dump();
+	}
+
+	if (PendingTicks > 0 && !IsEnabled()) {
+		{
+			FScopeLock ScopeLock(&BuffersLock);
+			for (FProfileThreadBuffer* Buffer : Buffers) {
+				FScopeLock BufferLock(&Buffer->Lock);
+				Buffer->Events.Reset();
+			}
+		}
+
+		TicksLeft = PendingTicks;
+		CapturePath = PendingPath;
+		PendingTicks = 0;
+		CaptureStart = FPlatformTime::Cycles64();
+		bEnabled = true;
+		UE_LOG(LogHolodeck, Log, TEXT("HolodeckProfiler:: Profiling %d ticks"), TicksLeft);
+	}
+}
+
+void HolodeckProfiler::Dump() {
+	TArray<FString> TraceEvents;
+	std::map<std::string, FZoneStats> Stats;
+
+	// Which thread each zone ran on, to draw arrows to zones launched from another thread
+	TMap<uint64, uint32> ZoneThreads;
+	TArray<TPair<uint32, FZoneEvent>> AllEvents;
+
+	{
+		FScopeLock ScopeLock(&BuffersLock);
+		for (FProfileThreadBuffer* Buffer : Buffers) {
+			FScopeLock BufferLock(&Buffer->Lock);
+			if (Buffer->Events.Num() == 0)
+				continue;
+
+			TraceEvents.Add(FString::Printf(TEXT("{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"%s\"}}"),
+				Buffer->ThreadId, *Buffer->ThreadName.ReplaceCharWithEscapedChar()));
+
+			for (const FZoneEvent& Event : Buffer->Events) {
+				ZoneThreads.Add(Event.Id, Buffer->ThreadId);
+				AllEvents.Add(TPair<uint32, FZoneEvent>(Buffer->ThreadId, Event));
+			}
+			Buffer->Events.Reset();
+		}
+	}
+
+	for (const TPair<uint32, FZoneEvent>& Pair : AllEvents) {
+		uint32 ThreadId = Pair.Key;
+		const FZoneEvent& Event = Pair.Value;
+		double StartUs = CyclesToUs(Event.Start - CaptureStart);
+		double DurationUs = CyclesToUs(Event.End - Event.Start);
+		FString Name = EscapeJson(Event.Name);
+
+		TraceEvents.Add(FString::Printf(TEXT("{\"ph\":\"X\",\"name\":\"%s\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"id\":%llu,\"parent\":%llu}}"),
+			*Name, ThreadId, StartUs, DurationUs, Event.Id, Event.Parent));
+
+		uint32* ParentThread = ZoneThreads.Find(Event.Parent);
+		if (ParentThread != nullptr && *ParentThread != ThreadId) {
+			TraceEvents.Add(FString::Printf(TEXT("{\"ph\":\"s\",\"name\":\"%s\",\"cat\":\"parent\",\"id\":%llu,\"pid\":0,\"tid\":%u,\"ts\":%.3f}"),
+				*Name, Event.Id, *ParentThread, StartUs));
+			TraceEvents.Add(FString::Printf(TEXT("{\"ph\":\"f\",\"bp\":\"e\",\"name\":\"%s\",\"cat\":\"parent\",\"id\":%llu,\"pid\":0,\"tid\":%u,\"ts\":%.3f}"),
+				*Name, Event.Id, ThreadId, StartUs));
+		}
+
+		FZoneStats& Zone = Stats[Event.Name];
+		Zone.MinUs = Zone.Count == 0 ? DurationUs : FMath::Min(Zone.MinUs, DurationUs);
+		Zone.MaxUs = FMath::Max(Zone.MaxUs, DurationUs);
+		Zone.TotalUs += DurationUs;
+		Zone.Count++;
+		int Bucket = DurationUs < 1 ? 0 : FMath::FloorLog2((uint32)FMath::Min(DurationUs, (double)MAX_uint32)) + 1;
+		Zone.Buckets[FMath::Min(Bucket, NUM_HISTOGRAM_BUCKETS - 1)]++;
+	}
+
+	TArray<FString> Histograms;
+	for (const auto& Zone : Stats) {
+		TArray<FString> Buckets;
+		for (int i = 0; i < NUM_HISTOGRAM_BUCKETS; i++)
+			Buckets.Add(FString::Printf(TEXT("%llu"), Zone.second.Buckets[i]));
+
+		Histograms.Add(FString::Printf(TEXT("\"%s\":{\"count\":%llu,\"total_us\":%.3f,\"min_us\":%.3f,\"max_us\":%.3f,\"buckets\":[%s]}"),
+			*EscapeJson(Zone.first.c_str()), Zone.second.Count, Zone.second.TotalUs, Zone.second.MinUs, Zone.second.MaxUs, *FString::Join(Buckets, TEXT(","))));
+
+		UE_LOG(LogHolodeck, Log, TEXT("HolodeckProfiler:: %s: %llu calls, %.3f ms total, %.3f ms mean, %.3f ms max"),
+			UTF8_TO_TCHAR(Zone.first.c_str()), Zone.second.Count, Zone.second.TotalUs / 1000, Zone.second.TotalUs / 1000 / Zone.second.Count, Zone.second.MaxUs / 1000);
+	}
+
+	// Bucket i holds zones that took [2^(i-1), 2^i) microseconds, bucket 0 everything under 1us
+	FString Json = FString::Printf(TEXT("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n%s\n],\n\"histograms\":{\n%s\n}}\n"),
+		*FString::Join(TraceEvents, TEXT(",\n")), *FString::Join(Histograms, TEXT(",\n")));
+
+	if (FFileHelper::SaveStringToFile(Json, *CapturePath))
+		UE_LOG(LogHolodeck, Log, TEXT("HolodeckProfiler:: Wrote %d zones to %s"), AllEvents.Num(), *CapturePath);
+	else
+		UE_LOG(LogHolodeck, Error, TEXT("HolodeckProfiler:: Unable to write profile to %s"), *CapturePath);
+}
@@ -0,0 +1,119 @@
+// MIT License (c) 2021 BYU FRoStLab see LICENSE file
+
+#pragma once
+
+#include <atomic>
+
+/**
+ * Opens a profiling zone that lasts until the end of the enclosing scope.
+ * Name must be a string literal.
+ */
+#define HOLODECK_PROFILE_ZONE(Name) FProfileZone PREPROCESSOR_JOIN(ProfileZone_, __LINE__)(Name)
+
+/**
+ * Opens a zone nested under Parent, a zone id from HolodeckProfiler::CurrentZone().
+ * Use it inside ParallelFor bodies so the work done on worker threads shows up
+ * under the zone that launched it.
+ */
+#define HOLODECK_PROFILE_ZONE_PARENT(Name, Parent) FProfileZone PREPROCESSOR_JOIN(ProfileZone_, __LINE__)(Name, Parent)
+
+/**
+ * HolodeckProfiler
+ * A hierarchical scoped timer. Zones are recorded into a buffer per thread
+ * while a capture is running, and the capture is written out as a Chrome
+ * trace (which Perfetto opens as well) along with a histogram of how long
+ * each zone took.
+ *
+ * A capture covers a number of ticks and is started with -HolodeckProfile=N
+ * on the command line or the Profile command. When no capture is running a
+ * zone costs a single relaxed atomic load.
+ */
+class HOLODECK_API HolodeckProfiler
+{
+public:
+	/**
+	  * IsEnabled
+	  * @return true while a capture is running.
+	  */
+	static bool IsEnabled() { return bEnabled.load(std::memory_order_relaxed); }
+
+	/**
+	  * Capture
+	  * Records the next NumTicks ticks and writes them to Path. Starts on the
+	  * next call to OnTick.
+	  * @param NumTicks how many ticks to record.
+	  * @param Path where to write the trace. If empty, HolodeckProfile.json in
+	  * the log directory is used.
+	  */
+	static void Capture(int NumTicks, const FString& Path);
+
+	/**
+	  * CaptureFromCommandLine
+	  * Starts a capture if -HolodeckProfile=N (and optionally -HolodeckProfilePath)
+	  * was passed.
+	  */
+	static void CaptureFromCommandLine();
+
+	/**
+	  * OnTick
+	  * Should be called at the start of every tick. Starts a requested capture,
+	  * and writes it out once it has covered enough ticks.
+	  */
+	static void OnTick();
+
+	/**
+	  * CurrentZone
+	  * @return the id of the innermost zone open on this thread, or 0.
+	  */
+	static uint64 CurrentZone();
+
+private:
+	friend class FProfileZone;
+
+	static std::atomic<bool> bEnabled;
+
+	static void Dump();
+};
+
+/**
+ * FProfileZone
+ * RAII zone, use HOLODECK_PROFILE_ZONE instead of making these directly.
+ */
+class HOLODECK_API FProfileZone
+{
+public:
+	explicit FProfileZone(const char* Name, uint64 Parent = 0) : Buffer(nullptr) {
+		if (HolodeckProfiler::IsEnabled())
+			Begin(Name, Parent);
+	}
+
+	~FProfileZone() {
+		if (Buffer != nullptr)
+			End();
+	}
+
+	/**
+	  * Next
+	  * Closes this zone and opens a sibling called NextName in its place, for
+	  * timing the stages of a long function without adding scopes.
+	  */
+	void Next(const char* NextName) {
+		uint64 NextParent = Buffer != nullptr ? Parent : 0;
+		if (Buffer != nullptr)
+			End();
+		Buffer = nullptr;
+		if (HolodeckProfiler::IsEnabled())
+			Begin(NextName, NextParent);
+	}
+
+private:
+	void Begin(const char* Name, uint64 Parent);
+	void End();
+
+	void* Buffer;
+	const char* Name;
+	uint64 Id;
+	uint64 Parent;
+	uint64 PreviousZone;
+	uint64 StartCycles;
+};